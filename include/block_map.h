@@ -0,0 +1,87 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_BLOCK_MAP_H
+#define PSA_PROJECT_BLOCK_MAP_H
+
+#include "fs_structs.h"
+#include "fs_common.h"
+
+// Table des blocs d'un fichier : BLOCK_MAP_DIRECT blocs directs, puis les arbres d'indirection
+// simple (inode->indirect_block), double (inode->double_indirect) et triple (inode->triple_indirect)
+#define BLOCK_MAP_DIRECT 10
+#define BLOCK_MAP_LEVELS 3
+
+// Un nœud gardé par profondeur de chaque arbre : 1 + 2 + 3
+#define BLOCK_MAP_CACHED_NODES 6
+
+/**
+ * Résolution du rang d'un bloc de fichier en numéro de bloc
+ * Le dernier bloc d'indirection lu à chaque profondeur est gardé : un accès séquentiel ne
+ * relit aucun bloc d'indirection, un accès aléatoire en parcourt au plus trois
+ */
+typedef struct {
+    fs_context_t *ctx;
+    inode_t *inode;
+    uint32_t refs;                            // Références par bloc d'indirection (data_size / 4)
+    uint64_t node_ids[BLOCK_MAP_CACHED_NODES]; // Numéro du nœud gardé dans son arbre + 1 (0 : aucun)
+    block_t *nodes[BLOCK_MAP_CACHED_NODES];
+    uint32_t allocated;                       // Blocs d'indirection créés par block_map_slot
+} block_map_t;
+
+/**
+ * Prépare la résolution des blocs d'un fichier (aucun bloc d'indirection n'est lu ici)
+ * @param map Table à initialiser
+ * @param ctx Contexte du système de fichiers
+ * @param inode Inode du fichier (l'appelant en détient les verrous pour écrire)
+ */
+void block_map_init(block_map_t *map, fs_context_t *ctx, inode_t *inode);
+
+/**
+ * Référence du bloc de rang n du fichier : dans l'inode ou dans un bloc d'indirection vérifié
+ * @param map Table du fichier
+ * @param n Rang du bloc dans le fichier
+ * @param create Créer les blocs d'indirection manquants ; le bloc contenant la référence est
+ *               alors marqué à rehacher (l'appelant peut écrire la référence)
+ * @return Pointeur vers la référence (0 si le bloc n'est pas alloué), NULL en cas d'erreur
+ */
+uint32_t *block_map_slot(block_map_t *map, uint32_t n, int create);
+
+/**
+ * Nombre maximal de blocs de données d'un fichier, selon la géométrie (borné à UINT32_MAX)
+ * @param ctx Contexte du système de fichiers
+ * @return Nombre de blocs
+ */
+uint32_t block_map_max_blocks(fs_context_t *ctx);
+
+/**
+ * Nombre de blocs d'indirection d'un fichier de blocks blocs de données
+ * @param ctx Contexte du système de fichiers
+ * @param blocks Nombre de blocs de données
+ * @return Nombre de blocs d'indirection
+ */
+uint64_t block_map_indirect_count(fs_context_t *ctx, uint64_t blocks);
+
+/**
+ * Rend à la bitmap les blocs de rang keep et au-delà, et les blocs d'indirection devenus vides
+ * Avec keep = 0, un bloc d'indirection corrompu est libéré sans relire ses références
+ * @param ctx Contexte du système de fichiers
+ * @param inode Inode du fichier (l'appelant en détient les verrous et le rehache)
+ * @param keep Nombre de blocs conservés
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int block_map_truncate(fs_context_t *ctx, inode_t *inode, uint32_t keep);
+
+/**
+ * Parcourt tous les blocs référencés par un fichier (données et indirection)
+ * @param ctx Contexte du système de fichiers
+ * @param inode Inode du fichier
+ * @param visit Appelé pour chaque bloc ; indirect vaut 1 pour un bloc d'indirection
+ * @param arg Argument passé à visit
+ * @return Nombre de blocs de données visités, -1 si un bloc d'indirection est illisible
+ */
+int64_t block_map_walk(fs_context_t *ctx, inode_t *inode, void (*visit)(void *arg, uint32_t block_num, int indirect),
+                       void *arg);
+
+#endif //PSA_PROJECT_BLOCK_MAP_H
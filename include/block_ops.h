@@ -3,10 +3,17 @@
 //
 
 #include "fs_structs.h"
+#include "fs_common.h"
 
 #ifndef PSA_PROJECT_BLOCK_OPS_H
 #define PSA_PROJECT_BLOCK_OPS_H
 
+// Découpage de la bitmap des blocs : bits par bloc de bitmap, mots de 64 bits,
+// et mots du résumé "contient un bloc libre" (un bit par mot de la bitmap)
+#define BITMAP_BITS_PER_BLOCK  (DATA_SIZE * 8)
+#define BITMAP_WORDS_PER_BLOCK (DATA_SIZE / sizeof(uint64_t))
+#define BITMAP_SUMMARY_WORDS   ((BITMAP_WORDS_PER_BLOCK + 63) / 64)
+
 // Structure pour passer des arguments aux threads de vérification
 typedef struct {
     void *fs_map;            // Mapping du système de fichiers
@@ -18,46 +25,188 @@ typedef struct {
 
 
 /**
- * Calcule le SHA1 d'un bloc (sur les données uniquement pas l'en tete)
- * @param block Le block dont on veut calculer le sha1
+ * Pas entre deux blocs de la projection, lu dans le superbloc (format v1 ou v2)
+ */
+static inline size_t fs_block_stride(const void *addr) {
+    return ((const superblock_t *) ((const block_t *) addr)->data)->block_size;
+}
+
+/**
+ * Octets de données par bloc (géométrie choisie au mkfs), lu dans le superbloc
+ */
+static inline uint32_t fs_data_size(const void *addr) {
+    uint32_t data_size = ((const superblock_t *) ((const block_t *) addr)->data)->data_size;
+    return data_size ? data_size : DATA_SIZE;
+}
+
+// En-tête d'un bloc dans la géométrie du contexte
+#define BLOCK_META(ctx, block) block_meta((block), (ctx)->data_size)
+
+/**
+ * Verrou de lecture d'un bloc (dans son en-tête)
+ * @param addr Adresse de la projection
+ * @param block Le block
+ * @return Le mutex partagé du bloc
+ */
+pthread_mutex_t *block_read_lock(void *addr, block_t *block);
+
+/**
+ * Verrou d'écriture d'un bloc : dans son en-tête (format v1), ou dans la table des verrous
+ * rangée après le dernier bloc (format v2)
+ * @param addr Adresse de la projection
+ * @param block Le block
+ * @return Le mutex partagé du bloc
+ */
+pthread_mutex_t *block_write_lock(void *addr, block_t *block);
+
+/**
+ * Verrou des modifications du superbloc (son verrou d'écriture)
+ * @param addr Adresse de la projection
+ * @return Le mutex partagé du superbloc
+ */
+pthread_mutex_t *superblock_lock(void *addr);
+
+/**
+ * Ouvre une modification du superbloc (compteurs de l'allocateur, tas du résumé) : elle se fait
+ * sous superblock_lock et superblock_update_end rehache aussitôt le superbloc, si bien qu'un
+ * processus qui le vérifie sous ce verrou ne le voit jamais modifié mais pas encore haché
+ * @param ctx Contexte du système de fichiers
+ */
+void superblock_update_begin(fs_context_t *ctx);
+
+/**
+ * Rehache le superbloc et rend superblock_lock
+ * @param ctx Contexte du système de fichiers
+ */
+void superblock_update_end(fs_context_t *ctx);
+
+/**
+ * Calcule la somme de contrôle d'un bloc (sur les données uniquement pas l'en tete)
+ * avec l'algorithme du conteneur
+ * @param ctx Contexte du système de fichiers
+ * @param block Le block dont on veut calculer la somme de contrôle
  */
-void compute_block_sha1(block_t *block);
+void compute_block_checksum(fs_context_t *ctx, block_t *block);
 
+/**
+ * Signale qu'un bloc a été modifié : son SHA1 sera recalculé une seule fois au commit
+ * du contexte, quel que soit le nombre de modifications d'ici là
+ * @param ctx Contexte du système de fichiers
+ * @param block Le block modifié
+ */
+void mark_block_dirty(fs_context_t *ctx, block_t *block);
+
+/**
+ * Indique si le SHA1 d'un bloc est en attente de recalcul dans ce contexte
+ * @param ctx Contexte du système de fichiers
+ * @param block Le block
+ * @return 1 si le bloc est modifié, 0 sinon
+ */
+int is_block_dirty(fs_context_t *ctx, block_t *block);
 
 /**
- * Verifie l'intégrité d'un block
+ * Verifie l'intégrité d'un block lu à travers un contexte
+ * Un bloc modifié par ce contexte (SHA1 pas encore recalculé) est considéré intègre ;
+ * selon PIGNOUFS_VERIFY, un bloc déjà vérifié dans sa génération courante n'est pas rehaché
+ * @param ctx Contexte du système de fichiers
  * @param block Le block dont on veut verifier l'intégrité
- * @return 0 si integre, 1 sinon
+ * @return 1 si integre, 0 sinon
  */
-int verify_block_sha1(block_t *block);
+int verify_block_checksum(fs_context_t *ctx, block_t *block);
 
 /**
- * Obtenir le block par son index
- * @param block_num Le numéro du block
- * @return L'adresse du block
+ * Verifie l'intégrité d'une suite de blocs en les hachant par lots (moteur multi-buffer)
+ * Les blocs modifiés par ce contexte, ou déjà vérifiés (voir verify_block_checksum), sont sautés
+ * @param ctx Contexte du système de fichiers
+ * @param blocks Les blocks à vérifier
+ * @param count Nombre de blocks
+ * @return -1 si tous sont intègres, sinon la position du premier bloc corrompu
+ */
+int verify_blocks_checksum(fs_context_t *ctx, block_t *const *blocks, uint32_t count);
+
+/**
+ * Obtenir le block par son index (adresse calculée sur 64 bits)
+ * @param block_index Le numéro du block
+ * @return L'adresse du block, NULL au-delà du dernier bloc
  * */
-block_t *get_block(void *addr, int block_index);
+block_t *get_block(void *addr, uint32_t block_index);
 
 /**
- *
- * @param addr
- * @param block_num
+ * Marquer un bloc comme utilisé (sans effet s'il l'est déjà)
+ * @param ctx Contexte du système de fichiers
+ * @param block_num Le numéro du block
  */
-void set_block_used(void *addr, uint32_t block_num);
+void set_block_used(fs_context_t *ctx, uint32_t block_num);
 
 /**
- * Marquer un bloc comme libre
+ * Marquer un bloc comme libre (sans effet s'il l'est déjà)
+ * @param ctx Contexte du système de fichiers
  * @param block_num Le numéro du block
  * */
-void set_block_free(void *addr, uint32_t block_num);
+void set_block_free(fs_context_t *ctx, uint32_t block_num);
+
+/**
+ * Indique si un bloc est marqué utilisé dans la bitmap
+ * @param fs_map Pointeur vers la projection mémoire du système de fichiers
+ * @param block_num Le numéro du block
+ * @return 1 si utilisé, 0 sinon
+ */
+int is_block_used(void *fs_map, uint32_t block_num);
+
+/**
+ * Trouve un bloc libre et le réserve (bit à 1, compteurs décrémentés)
+ * La recherche part du curseur tournant du superbloc, saute les blocs de bitmap
+ * pleins grâce aux compteurs et les mots pleins grâce au résumé en mémoire
+ * @param ctx Contexte du système de fichiers
+ * @return Numéro du bloc réservé ou 0 si aucun bloc libre n'est disponible
+ */
+uint32_t find_free_block(fs_context_t *ctx);
+
+/**
+ * Réserve une suite de blocs libres contigus et les marque utilisés en une passe
+ * (chaque bloc de bitmap touché et le superbloc ne sont rehachés qu'une fois)
+ * Si aucune suite de count blocs n'existe, la plus longue suite trouvée est réservée
+ * @param ctx Contexte du système de fichiers
+ * @param count Nombre de blocs souhaités
+ * @param first Reçoit le premier bloc de la suite
+ * @return Nombre de blocs réservés (0 si le système de fichiers est plein)
+ */
+uint32_t alloc_extent(fs_context_t *ctx, uint32_t count, uint32_t *first);
+
+/**
+ * Réserve d'avance count blocs (en extents aussi longs que possible) pour les
+ * prochains appels à find_free_block du contexte
+ * @param ctx Contexte du système de fichiers
+ * @param count Nombre de blocs à réserver
+ * @return 0 en cas de succès, -1 si l'espace libre est insuffisant
+ */
+int reserve_blocks(fs_context_t *ctx, uint32_t count);
+
+/**
+ * Nombre de blocs réservés d'avance et pas encore consommés
+ * @param ctx Contexte du système de fichiers
+ */
+uint32_t reserved_block_count(fs_context_t *ctx);
+
+/**
+ * Rend à la bitmap les blocs réservés d'avance qui n'ont pas servi
+ * @param ctx Contexte du système de fichiers
+ */
+void release_reserved_blocks(fs_context_t *ctx);
 
 /**
- * Trouve un bloc libre dans le système de fichiers
+ * Nombre de blocs libres suivis par un bloc de bitmap
  * @param fs_map Pointeur vers la projection mémoire du système de fichiers
- * @param sb Pointeur vers le superbloc
- * @return Numéro du bloc libre ou 0 si aucun bloc libre n'est disponible
+ * @param bitmap_index Index du bloc de bitmap (0 pour le premier)
+ * @return Nombre de bits à 0 correspondant à des blocs existants
+ */
+uint32_t count_free_in_bitmap_block(void *fs_map, uint32_t bitmap_index);
+
+/**
+ * Libère l'état en mémoire de l'allocateur
+ * @param ctx Contexte du système de fichiers
  */
-uint32_t find_free_block(void *fs_map, superblock_t *sb);
+void free_alloc_state(fs_context_t *ctx);
 
 /**
  * Incrémente le compteur de blocs libres dans le superbloc
@@ -0,0 +1,74 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_CHECKSUM_H
+#define PSA_PROJECT_CHECKSUM_H
+
+#include "fs_structs.h"
+
+/**
+ * Algorithme de somme de contrôle des blocs, choisi au mkfs et enregistré dans le superbloc
+ * L'empreinte occupe le début du champ sha1 du bloc, le reste est à zéro
+ */
+typedef struct {
+    uint32_t id;            // Valeur du champ checksum_algo du superbloc (CHECKSUM_*)
+    const char *name;       // Nom utilisé par mkfs et affiché par df
+    uint32_t digest_size;   // Nombre d'octets significatifs de l'empreinte
+
+    void (*compute)(const unsigned char *data, size_t len, unsigned char digest[SHA1_SIZE]);
+
+    // Calcul groupé de plusieurs messages de même longueur (NULL : compute message par message)
+    void (*compute_many)(const unsigned char *const *data, size_t len, unsigned char (*digests)[SHA1_SIZE],
+                         int count);
+} checksum_ops_t;
+
+// Nombre de blocs vérifiés par lot (taille des tableaux sur la pile)
+#define CHECKSUM_BATCH 64
+
+/**
+ * Retrouve un algorithme par son identifiant (champ du superbloc)
+ * La variante matérielle (SSE4.2 pour CRC32C) est choisie au premier appel
+ * @param id Identifiant CHECKSUM_*
+ * @return La table de l'algorithme ou NULL s'il est inconnu
+ */
+const checksum_ops_t *checksum_ops_by_id(uint32_t id);
+
+/**
+ * Retrouve un algorithme par son nom (sha1, crc32c, xxh64)
+ * @param name Nom de l'algorithme
+ * @return La table de l'algorithme ou NULL s'il est inconnu
+ */
+const checksum_ops_t *checksum_ops_by_name(const char *name);
+
+/**
+ * Calcule l'empreinte d'un bloc (sur les données uniquement), l'écrit dans son en-tête
+ * et incrémente la génération du bloc
+ * @param ops Algorithme à utiliser
+ * @param block Le block
+ * @param data_size Octets de données par bloc (géométrie du conteneur)
+ */
+void checksum_block_compute(const checksum_ops_t *ops, block_t *block, uint32_t data_size);
+
+/**
+ * Compare l'empreinte d'un bloc à celle enregistrée dans son en-tête
+ * @param ops Algorithme à utiliser
+ * @param block Le block
+ * @param data_size Octets de données par bloc (géométrie du conteneur)
+ * @return 1 si integre, 0 sinon
+ */
+int checksum_block_verify(const checksum_ops_t *ops, block_t *block, uint32_t data_size);
+
+/**
+ * Vérifie un lot de blocs ; les algorithmes qui le permettent hachent plusieurs blocs à la fois
+ * @param ops Algorithme à utiliser
+ * @param blocks Blocs à vérifier
+ * @param count Nombre de blocs
+ * @param valid Reçoit 1 pour chaque bloc intègre, 0 sinon
+ * @param data_size Octets de données par bloc (géométrie du conteneur)
+ * @return Nombre de blocs corrompus
+ */
+uint32_t checksum_blocks_verify(const checksum_ops_t *ops, block_t *const *blocks, uint32_t count, uint8_t *valid,
+                                uint32_t data_size);
+
+#endif //PSA_PROJECT_CHECKSUM_H
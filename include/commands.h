@@ -11,11 +11,17 @@
 /**
  * Crée un nouveau système de fichiers
  * @param fsname Nom du fichier conteneur
- * @param argc Nombre d'arguments additionnels
- * @param argv Arguments additionnels
+ * @param nb_inode Nombre d'inodes
+ * @param nb_block Nombre de blocs allouables
+ * @param checksum_name Somme de contrôle des blocs (sha1, crc32c, xxh64 ; NULL = sha1)
+ * @param block_size BLOCK_SIZE pour le format v1, sinon taille des blocs du format v2
+ *                   (multiple de PAGE_BLOCK_SIZE jusqu'à MAX_BLOCK_SIZE, verrous d'écriture à part)
+ * @param packed_inodes Table des inodes compacte (une place de PACKED_INODE_SLOT octets par inode)
+ * @param trigram_index Index des trigrammes des noms, pour find
  * @return Code d'erreur
  */
-int cmd_mkfs(const char *fsname, int nb_inode, int nb_block);
+int cmd_mkfs(const char *fsname, uint32_t nb_inode, uint32_t nb_block, const char *checksum_name,
+             uint32_t block_size, int packed_inodes, int trigram_index);
 
 /**
  * Liste les fichiers dans le système de fichiers
@@ -70,12 +76,24 @@ int cmd_lock(const char *fsname, const char *filename, const char *mode);
 int cmd_chmod(const char *fsname, const char *filename, const char *mode);
 
 /**
- * Affiche le contenu d'un fichier
+ * Affiche le contenu d'un fichier, ou une plage de celui-ci
  * @param fsname Nom du fichier conteneur
  * @param filename Nom du fichier à afficher
+ * @param offset Premier octet à afficher
+ * @param length Nombre maximal d'octets à afficher (UINT64_MAX : jusqu'à la fin)
+ * @return Code d'erreur
+ */
+int cmd_cat(const char *fsname, const char *filename, uint64_t offset, uint64_t length);
+
+/**
+ * Écrit des données à une position d'un fichier existant, sans réécrire le reste
+ * @param fsname Nom du fichier conteneur
+ * @param filename Nom du fichier à modifier
+ * @param offset Position d'écriture
+ * @param data Données à écrire (NULL : lire l'entrée standard)
  * @return Code d'erreur
  */
-int cmd_cat(const char *fsname, const char *filename);
+int cmd_write_at(const char *fsname, const char *filename, uint64_t offset, const char *data);
 
 /**
  * Écrit l'entrée standard dans un fichier
@@ -121,9 +139,10 @@ int cmd_fsck(const char *fsname);
  * Commande pour rechercher des fichiers par nom
  * @param fsname Nom du système de fichiers
  * @param pattern Motif à rechercher dans les noms de fichiers
+ * @param mode NAME_MATCH_SUBSTRING (le nom contient le motif), NAME_MATCH_PREFIX ou NAME_MATCH_GLOB
  * @return EXIT_SUCCESS ou EXIT_FAILURE
  */
-int cmd_find(const char *fsname, const char *pattern);
+int cmd_find(const char *fsname, const char *pattern, int mode);
 
 /**
  * Crée un nouveau répertoire dans le système de fichiers
@@ -141,4 +160,18 @@ int cmd_mkdir(const char *fsname, const char *dirname);
  */
 int cmd_rmdir(const char *fsname, const char *dirname);
 
+/**
+ * Exécute une commande de la table des commandes (utilisé par batch)
+ */
+typedef int (*batch_runner_t)(const char *fsname, const char *command, int argc, char **argv);
+
+/**
+ * Exécute les commandes lues sur l'entrée standard (une par ligne, sans le nom du conteneur)
+ * avec un seul contexte ; sommes de contrôle et msync sont regroupés à la fin du lot
+ * @param fsname Nom du fichier conteneur
+ * @param run Fonction exécutant une commande
+ * @return Code d'erreur (EXIT_FAILURE si au moins une commande a échoué)
+ */
+int cmd_batch(const char *fsname, batch_runner_t run);
+
 #endif //PSA_PROJECT_COMMANDS_H
\ No newline at end of file
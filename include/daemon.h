@@ -0,0 +1,84 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_DAEMON_H
+#define PSA_PROJECT_DAEMON_H
+
+#include "pignoufs.h"
+
+/// Démon "serve" : garde un conteneur ouvert (projection, superbloc vérifié, caches chauds)
+/// et exécute les commandes reçues sur une socket Unix, nommée <conteneur>.sock
+///
+/// Protocole binaire, une requête par connexion :
+///  - requête : daemon_request_t, accompagné des descripteurs 0, 1 et 2 du client (SCM_RIGHTS),
+///    puis payload_size octets : répertoire courant du client, ses variables PIGNOUFS_*
+///    (NOM=valeur) et les arguments, terminés par '\0'
+///  - réponse : daemon_reply_t, envoyé une fois la commande terminée
+///
+/// Le client ne se connecte qu'à une socket de son utilisateur, et le démon ne sert que lui
+
+#define DAEMON_MAGIC       0x464e4750u  // "PGNF"
+#define DAEMON_VERSION     2
+#define DAEMON_MAX_PAYLOAD 65536
+
+// Opérations
+#define DAEMON_OP_RUN  1   // Exécuter une commande
+#define DAEMON_OP_STOP 2   // Arrêter le démon
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t op;             // DAEMON_OP_*
+    uint32_t envc;           // Nombre de variables d'environnement (après le répertoire)
+    uint32_t argc;           // Nombre d'arguments (commande comprise)
+    uint32_t payload_size;   // Taille des chaînes qui suivent
+} daemon_request_t;
+
+typedef struct {
+    uint32_t magic;
+    int32_t status;          // Code de retour de la commande
+} daemon_reply_t;
+
+/**
+ * Exécute une commande pour le démon (même dispatch que la ligne de commande)
+ * @param fsname Conteneur servi
+ * @param command Nom de la commande
+ * @param argc Nombre d'arguments de la commande
+ * @param argv Arguments de la commande
+ * @return Code de retour de la commande
+ */
+typedef int (*daemon_runner_t)(const char *fsname, const char *command, int argc, char **argv);
+
+/**
+ * Chemin de la socket du démon servant un conteneur
+ * @param fsname Chemin du conteneur
+ * @param path Reçoit le chemin de la socket
+ * @param size Taille de path
+ * @return 0 en cas de succès, -1 si le chemin est trop long
+ */
+int daemon_socket_path(const char *fsname, char *path, size_t size);
+
+/**
+ * Transmet une requête au démon servant le conteneur, s'il tourne
+ * @param fsname Chemin du conteneur
+ * @param op Opération (DAEMON_OP_*)
+ * @param command Nom de la commande
+ * @param argc Nombre d'arguments de la commande
+ * @param argv Arguments de la commande
+ * @param status Reçoit le code de retour de la commande
+ * @return 0 si le démon a traité la requête, -1 s'il n'y a pas de démon joignable
+ */
+int daemon_forward(const char *fsname, uint16_t op, const char *command, int argc, char **argv, int *status);
+
+/**
+ * Sert un conteneur jusqu'à SIGINT, SIGTERM ou DAEMON_OP_STOP : un seul contexte reste
+ * ouvert et est prêté à chaque commande, exécutée dans un processus fils (une commande qui
+ * attend l'entrée de son client ou un verrou ne bloque pas les autres)
+ * @param fsname Chemin du conteneur
+ * @param run Fonction exécutant une commande
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int daemon_serve(const char *fsname, daemon_runner_t run);
+
+#endif //PSA_PROJECT_DAEMON_H
@@ -7,6 +7,40 @@
 
 #include "pignoufs.h"
 #include "fs_structs.h"
+#include "checksum.h"
+#include "verify_cache.h"
+
+/**
+ * Suite de blocs contigus réservés d'avance (extent)
+ */
+typedef struct {
+    uint32_t start;          // Premier bloc de l'extent
+    uint32_t count;          // Nombre de blocs encore disponibles à partir de start
+} block_extent_t;
+
+/**
+ * Résumé en mémoire de la bitmap des blocs, construit à la demande par l'allocateur
+ */
+typedef struct {
+    uint32_t bitmap_blocks;  // Nombre de blocs de bitmap couvrant le système de fichiers
+    uint32_t *free_counts;   // Blocs libres par bloc de bitmap (dans le superbloc ou local_counts)
+    uint32_t *local_counts;  // Compteurs recalculés pour les conteneurs sans résumé
+    uint64_t *has_free;      // Par bloc de bitmap : un bit par mot de 64 bits contenant un bloc libre
+    uint8_t *summary_ready;  // Par bloc de bitmap : has_free déjà construit
+    block_extent_t *reserved;// Extents réservés, consommés en priorité par find_free_block
+    uint32_t reserved_extents; // Nombre d'extents réservés
+    uint32_t reserved_pos;   // Premier extent non épuisé
+} block_alloc_t;
+
+/**
+ * Ensemble des blocs modifiés dont le SHA1 reste à recalculer (au commit du contexte)
+ */
+typedef struct {
+    uint8_t *map;            // Un bit par bloc : SHA1 à recalculer
+    uint32_t *list;          // Blocs modifiés, dans l'ordre de première modification
+    uint32_t count;          // Nombre de blocs dans list
+    uint32_t capacity;       // Taille allouée de list
+} dirty_set_t;
 
 /**
  * Structure contenant les ressources du système de fichiers
@@ -16,6 +50,14 @@ typedef struct {
     void *fs_map;           // Pointeur vers la projection mémoire
     ssize_t fs_size;         // Taille du fichier
     superblock_t *sb;       // Pointeur vers le superbloc
+    uint32_t data_size;     // Octets de données par bloc (géométrie lue dans le superbloc)
+    block_alloc_t *alloc;   // État de l'allocateur de blocs (NULL tant qu'il n'a pas servi)
+    dirty_set_t dirty;      // Blocs dont le SHA1 est différé jusqu'au commit
+    const checksum_ops_t *checksum; // Somme de contrôle du conteneur (résolue à l'ouverture)
+    verify_cache_t *verify_cache;   // Blocs déjà vérifiés (créé au premier accès)
+    int read_only;          // Projection en lecture seule : verrous des blocs inaccessibles
+    int resident;           // Projection et caches prêtés par le démon ou le lot (non libérés avec le contexte)
+    int deferred;           // Lot (batch) : msync et hachage des bitmaps reportés à la fin
 } fs_context_t;
 
 /**
@@ -33,6 +75,37 @@ int fs_init_context(const char *fsname, fs_context_t *ctx, int mode);
  */
 void fs_free_context(fs_context_t *ctx);
 
+/**
+ * Recalcule une seule fois le SHA1 de chaque bloc modifié depuis le dernier commit
+ * (appelé par fs_free_context, ou explicitement avant un msync ou avant de rendre un verrou)
+ * Dans un lot, les blocs des bitmaps restent en attente jusqu'au commit final
+ * @param ctx Pointeur vers la structure de contexte
+ */
+void fs_commit(fs_context_t *ctx);
+
+/**
+ * Recalcule tout de suite les sommes des bitmaps modifiées par l'allocateur (sauf dans un lot),
+ * avant un long remplissage ; le superbloc, lui, est rehaché à chaque modification
+ * @param ctx Pointeur vers la structure de contexte
+ */
+void fs_commit_alloc(fs_context_t *ctx);
+
+/**
+ * Désigne le contexte ouvert par le démon ou le lot : les ouvertures suivantes du même
+ * conteneur empruntent sa projection et son cache de vérification au lieu de rouvrir le fichier
+ * Si ctx->deferred est positionné, elles partagent aussi ses blocs modifiés : les bitmaps ne sont
+ * hachées et la projection écrite (msync) qu'à la libération du contexte résident
+ * @param fsname Chemin du conteneur (tel que passé aux commandes), NULL pour désactiver
+ * @param ctx Contexte résident
+ */
+void fs_set_resident_context(const char *fsname, fs_context_t *ctx);
+
+/**
+ * Écrit la projection sur disque (msync), sauf si le contexte appartient à un lot
+ * @param ctx Pointeur vers la structure de contexte
+ */
+void fs_sync(fs_context_t *ctx);
+
 /**
  * Vérifie la validité du système de fichiers
  * @param ctx Pointeur vers la structure de contexte
@@ -48,6 +121,12 @@ int fs_verify(fs_context_t *ctx);
  */
 int fs_error(const char *format, ...);
 
+/**
+ * Supprime (ou rétablit) l'affichage des messages de fs_error, errno restant positionné
+ * @param silenced 1 pour ne plus rien écrire sur stderr
+ */
+void fs_silence_errors(int silenced);
+
 /**
  * Initialise le contexte du système de fichiers et vérifie sa validité
  * @param fsname Chemin vers le fichier conteneur
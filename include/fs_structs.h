@@ -7,10 +7,9 @@
 
 #include "pignoufs.h"
 
-// Structure d'un bloc générique
+// En-tête d'un bloc, rangé juste après ses sb->data_size octets de données
 typedef struct {
-    unsigned char data[DATA_SIZE];
-    unsigned char sha1[SHA1_SIZE];
+    unsigned char sha1[SHA1_SIZE];  // Empreinte des données (algorithme choisi au mkfs, SHA1 par défaut)
     uint32_t type;
     //ALL TYPES
     // 1. superbloc
@@ -18,34 +17,114 @@ typedef struct {
     //  3. inode /
     //  4. bloc allouable libre
     //  5. bloc de données
-    //  6. bloc d’indirection simple
-    //  7. bloc d’indirection double
+    //  6. bloc d’indirection (simple, double ou triple)
+    //  BLOCK_TYPE_NAME_INDEX (6) : index des noms (table de hachage nom -> inode)
+    //  BLOCK_TYPE_INODE_BITMAP (7) : bitmap des inodes libres
+    //  BLOCK_TYPE_INODE_SUMMARY (8) : résumé des inodes (colonnes et tas des noms)
+    //  BLOCK_TYPE_TRIGRAM_INDEX (9) : index des trigrammes (un bitmap d'inodes par seau)
     unsigned char lock_read[LOCK_SIZE];
-    unsigned char lock_write[LOCK_SIZE];
+    unsigned char lock_write[LOCK_SIZE];  // Format v1 seulement : passer par block_write_lock
+} block_meta_t;
+
+// Structure d'un bloc générique : données (au moins DATA_SIZE octets, sb->data_size en tout)
+// suivies de leur en-tête (block_meta). Les blocs de métadonnées (bitmaps, index des noms)
+// n'utilisent que leurs DATA_SIZE premiers octets, quelle que soit la géométrie
+typedef struct {
+    unsigned char data[DATA_SIZE];
 } block_t;
 
+/**
+ * En-tête d'un bloc dans une géométrie donnée
+ * @param block Le bloc
+ * @param data_size Octets de données par bloc (sb->data_size)
+ */
+static inline block_meta_t *block_meta(block_t *block, uint32_t data_size) {
+    return (block_meta_t *) (block->data + data_size);
+}
+
+// Génération d'un bloc : incrémentée à chaque recalcul de sa somme de contrôle
+// Rangée dans les derniers octets de lock_read, que le mutex n'occupe pas (même place dans les deux formats)
+#define BLOCK_GENERATION(meta) ((uint32_t *) ((meta)->lock_read + LOCK_SIZE - sizeof(uint32_t)))
+
+_Static_assert(sizeof(pthread_mutex_t) + sizeof(uint32_t) <= LOCK_SIZE, "la génération doit suivre le mutex");
+_Static_assert(DATA_SIZE + sizeof(block_meta_t) == BLOCK_SIZE, "un bloc v1 : données puis en-tête complet");
+_Static_assert(DATA_SIZE + BLOCK_META_SIZE == PAGE_BLOCK_SIZE, "un bloc v2 s'arrête avant lock_write");
+
 // Structure du superbloc
 typedef struct {
     char magic[8];              // Nombre magique (signature)
-    uint32_t block_size;         // Taille d'un bloc (4096)
+    uint32_t block_size;         // Pas entre deux blocs : BLOCK_SIZE (v1) ou multiple de PAGE_BLOCK_SIZE (v2)
     uint32_t num_blocks;         // Nombre total de blocs
     uint32_t num_free_blocks;    // Nombre de blocs libres
     uint32_t bitmap_start;       // Premier bloc de bitmap
     uint32_t inode_start;        // Premier bloc d'inodes
     uint32_t data_start;         // Premier bloc de données
     uint32_t max_inodes;         // Nombre maximal d'inodes
+    uint32_t features;           // Fonctionnalités optionnelles du format (FS_FEATURE_*)
+    uint32_t name_index_start;   // Premier bloc de l'index des noms
+    uint32_t name_index_blocks;  // Nombre de blocs de l'index des noms
+    uint32_t inode_bitmap_start; // Premier bloc de la bitmap des inodes
+    uint32_t inode_bitmap_blocks;// Nombre de blocs de la bitmap des inodes
+    uint32_t alloc_cursor;       // Prochain bloc à essayer lors d'une allocation (curseur tournant)
+    uint32_t checksum_algo;      // Somme de contrôle des blocs (CHECKSUM_*, 0 = SHA1)
+    uint32_t fs_id;              // Identifiant aléatoire tiré au mkfs (nomme le cache de vérification partagé)
+    uint32_t bitmap_free[SB_MAX_BITMAP_BLOCKS]; // Blocs libres suivis par chaque bloc de bitmap
+    uint32_t data_size;          // Octets de données par bloc (0 : DATA_SIZE, conteneurs antérieurs)
+    uint32_t inodes_per_block;   // Inodes par bloc de la table (FS_FEATURE_PACKED_INODES ; sinon un par bloc)
+    uint32_t summary_start;      // Premier bloc du résumé des inodes (FS_FEATURE_INODE_SUMMARY)
+    uint32_t summary_blocks;     // Nombre de blocs du résumé (colonnes puis tas des noms)
+    uint32_t summary_heap_used;  // Octets déjà attribués dans le tas des noms du résumé
+    uint32_t trigram_start;      // Premier bloc de l'index des trigrammes (FS_FEATURE_TRIGRAM_INDEX)
+    uint32_t trigram_blocks;     // Nombre de blocs de l'index des trigrammes
 } superblock_t;
 
+_Static_assert(sizeof(superblock_t) <= DATA_SIZE, "le superbloc doit tenir dans un bloc");
+
 // Structure d'un inode
 typedef struct {
-    uint32_t flags;               // Bit 0: existe, Bit 1: lecture, Bit 2: écriture, Bit 3: verrou lecture, Bit 4: verrou écriture, Bit 5: répertoire
+    uint32_t flags;               // Bit 0: existe, Bit 1: lecture, Bit 2: écriture, Bit 3: verrou lecture, Bit 4: verrou écriture, Bit 5: répertoire, Bit 7: données dans l'inode
     uint32_t mode;               // Droits d'accès
-    uint32_t size;               // Taille du fichier en octets
+    uint32_t size_lo;            // Taille du fichier en octets (32 bits de poids faible, voir inode_size)
     uint32_t direct_blocks[10];  // Pointeurs directs vers blocs de données
-    uint32_t indirect_block;     // Pointeur vers bloc d'indirection
+    uint32_t indirect_block;     // Pointeur vers bloc d'indirection simple
     char filename[256];          // Nom du fichier
+    uint32_t size_hi;            // 32 bits de poids fort de la taille (FS_FEATURE_LARGE_FILES, 0 sinon)
+    uint32_t double_indirect;    // Pointeur vers bloc d'indirection double (0 sur les conteneurs antérieurs)
+    uint32_t triple_indirect;    // Pointeur vers bloc d'indirection triple
 } inode_t;
 
+/**
+ * Taille d'un fichier en octets
+ * @param inode L'inode
+ */
+static inline uint64_t inode_size(const inode_t *inode) {
+    return (uint64_t) inode->size_hi << 32 | inode->size_lo;
+}
+
+/**
+ * Change la taille d'un fichier
+ * @param inode L'inode
+ * @param size Nouvelle taille (au-delà de 4 Gio, seulement avec FS_FEATURE_LARGE_FILES)
+ */
+static inline void inode_set_size(inode_t *inode, uint64_t size) {
+    inode->size_lo = (uint32_t) size;
+    inode->size_hi = (uint32_t) (size >> 32);
+}
+
+/**
+ * Contenu d'un fichier PERM_INLINE : le reste de la place de l'inode dans son bloc, juste après lui
+ * @param inode L'inode (en tête des données de son bloc)
+ */
+static inline char *inode_inline_data(inode_t *inode) {
+    return (char *) (inode + 1);
+}
+
+// Entrée de l'index des noms (adressage ouvert, sondage linéaire)
+typedef struct {
+    uint32_t hash;            // Empreinte du nom
+    uint32_t inode;           // Index de l'inode + 1 (0: entrée vide, 0xFFFFFFFF: entrée supprimée)
+} name_index_entry_t;
+
 typedef struct {
     uint32_t inode_index;     // Index de l'inode associé à cette entrée
     char name[256];           // Nom de l'entrée (fichier ou répertoire)
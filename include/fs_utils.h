@@ -3,6 +3,7 @@
 //
 
 #include "fs_structs.h"
+#include <sys/uio.h>
 
 #ifndef PSA_PROJECT_FS_UTILS_H
 #define PSA_PROJECT_FS_UTILS_H
@@ -40,5 +41,14 @@ int read_lock_file(int fd, int inode_number);
  */
 int write_lock_file(int fd, int inode_number);
 
+/**
+ * Écrit entièrement une suite de morceaux avec writev (reprend après une écriture partielle)
+ * @param fd Descripteur de destination
+ * @param iov Morceaux à écrire (modifiés en cas d'écriture partielle)
+ * @param count Nombre de morceaux
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int write_all_iov(int fd, struct iovec *iov, int count);
+
 #endif //PSA_PROJECT_FS_UTILS_H
 
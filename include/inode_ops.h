@@ -7,40 +7,261 @@
 
 #include "fs_structs.h"
 #include "fs_common.h"
+#include "block_map.h"
+#include <sys/uio.h>
 
 /**
- * Trouver l'index d'un inode par son nom
+ * Trouver l'index d'un inode par son nom (par l'index des noms, ou par un parcours de la
+ * table des inodes sans index ou si un de ses blocs est corrompu)
+ * @param ctx Contexte du système de fichiers
  * @param filename Nom de l'inode
- * @return Index de l'inode
+ * @return Index de l'inode, -1 si le nom est absent
  * */
-int find_inode_by_name(void *addr, const char *filename);
+int find_inode_by_name(fs_context_t *ctx, const char *filename);
 
 
 /**
  * Obtenir l'adresse d'un inode
  * @param inode_index Index de l'inode
- * @return le block contenant l'inode
+ * @return le block contenant l'inode (partagé par inodes_per_block inodes : sa somme de
+ *         contrôle et ses verrous couvrent tous ses inodes)
  * */
 block_t *get_inode_block(void *addr, int inode_index);
 
+/**
+ * Obtenir un inode dans son bloc (sa place est le bloc entier hors table compacte)
+ * @param inode_index Index de l'inode
+ * @return L'inode, NULL si l'index est invalide
+ * */
+inode_t *get_inode(void *addr, int inode_index);
+
+/**
+ * Nombre d'inodes rangés dans chaque bloc de la table
+ * @param sb Superbloc
+ * @return sb->inodes_per_block avec FS_FEATURE_PACKED_INODES, 1 sinon
+ */
+uint32_t inodes_per_block(const superblock_t *sb);
+
+/**
+ * Parcours des inodes existants place par place : le bloc d'une place n'est vérifié qu'à la
+ * première d'entre elles (table compacte : un haché pour inodes_per_block inodes)
+ */
+typedef struct {
+    fs_context_t *ctx;
+    uint32_t next;            // Prochain index d'inode à examiner
+    block_t *block;           // Dernier bloc d'inodes vérifié
+    int block_ok;             // Somme de contrôle de ce bloc valide
+    int report;               // Signaler les blocs corrompus (sinon ils sont sautés en silence)
+} inode_scan_t;
+
+/**
+ * Commence un parcours de la table des inodes
+ * @param scan Parcours à initialiser
+ * @param ctx Contexte du système de fichiers
+ * @param report Signaler une fois chaque bloc d'inodes corrompu
+ */
+void inode_scan_init(inode_scan_t *scan, fs_context_t *ctx, int report);
+
+/**
+ * Inode existant suivant (les inodes d'un bloc corrompu sont sautés)
+ * @param scan Parcours en cours
+ * @param inode_index Reçoit l'index de l'inode rendu
+ * @return L'inode, NULL à la fin de la table
+ */
+inode_t *inode_scan_next(inode_scan_t *scan, int *inode_index);
+
 /**
  * Marquer un inode comme libre
  * @param inode_index Index de l'inode
  * */
-void set_inode_free(void *addr, int inode_index);
+void set_inode_free(fs_context_t *ctx, int inode_index);
+
+/**
+ * Réserve un inode libre dans la bitmap des inodes (un seul bit atomique)
+ * @param ctx Contexte du système de fichiers
+ * @return Index de l'inode réservé ou -1 si aucun inode n'est libre
+ */
+int alloc_inode(fs_context_t *ctx);
+
+/**
+ * Rend un inode à la bitmap des inodes
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode
+ */
+void release_inode(fs_context_t *ctx, int inode_index);
+
+/**
+ * Nombre de blocs de bitmap nécessaires pour un nombre d'inodes donné
+ * @param nb_inode Nombre d'inodes
+ * @return Nombre de blocs
+ */
+uint32_t inode_bitmap_blocks_for(uint32_t nb_inode);
+
+/**
+ * Reconstruit la bitmap des inodes à partir de la table des inodes
+ * @param ctx Contexte du système de fichiers
+ * @param check_only Si non nul, ne modifie rien et signale seulement les écarts
+ * @return Nombre d'inodes dont le bit était incohérent
+ */
+uint32_t sync_inode_bitmap(fs_context_t *ctx, int check_only);
 
 /** Vérifier les permissions
  * @param perm Permissions à vérifier
  * */
 int check_permissions(inode_t *inode, uint32_t perm);
 
+/**
+ * Taille maximale d'un fichier : blocs adressables par l'inode, et 4 Gio - 1 sur un
+ * conteneur sans FS_FEATURE_LARGE_FILES
+ * @param ctx Contexte du système de fichiers
+ * @return Taille maximale en octets
+ */
+uint64_t inode_max_size(fs_context_t *ctx);
+
+/**
+ * Taille maximale d'un fichier rangé dans la place de son inode (0 sans FS_FEATURE_INLINE_DATA)
+ * @param ctx Contexte du système de fichiers
+ * @return Taille en octets
+ */
+uint32_t inode_inline_capacity(fs_context_t *ctx);
+
+// Nombre maximal de blocs rendus par un appel à inode_reader_next
+#define INODE_READER_IOV 64
+
+/**
+ * Lecture d'un fichier bloc par bloc, sans copie : chaque morceau pointe directement
+ * dans la projection du conteneur
+ */
+typedef struct {
+    fs_context_t *ctx;
+    inode_t *inode;
+    uint64_t size;            // Taille du fichier à l'ouverture
+    uint64_t offset;          // Octets déjà rendus
+    uint32_t next_block;      // Rang du prochain bloc du fichier
+    block_map_t map;          // Table des blocs (blocs d'indirection gardés d'un appel à l'autre)
+} inode_reader_t;
+
+/**
+ * Prépare la lecture d'un fichier (vérifie l'inode, l'existence et le droit de lecture)
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à lire
+ * @param reader Lecteur à initialiser
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int inode_reader_open(fs_context_t *ctx, int inode_index, inode_reader_t *reader);
+
+/**
+ * Restreint la lecture à une plage du fichier (avant le premier inode_reader_next)
+ * @param reader Lecteur ouvert
+ * @param offset Premier octet à rendre (borné à la taille du fichier)
+ * @param length Nombre maximal d'octets à rendre
+ */
+void inode_reader_seek(inode_reader_t *reader, uint64_t offset, uint64_t length);
+
+/**
+ * Rend les morceaux suivants du fichier, dans l'ordre, après vérification de leurs blocs
+ * Les pointeurs restent valides tant que le contexte est ouvert
+ * @param reader Lecteur ouvert
+ * @param iov Reçoit un morceau par bloc de données
+ * @param max_iov Taille de iov (au plus INODE_READER_IOV morceaux sont rendus)
+ * @return Nombre de morceaux rendus, 0 à la fin du fichier, -1 en cas d'erreur
+ */
+int inode_reader_next(inode_reader_t *reader, struct iovec *iov, int max_iov);
+
+// Taille conseillée des morceaux passés à inode_writer_write (lectures de l'entrée standard)
+#define INODE_WRITER_CHUNK (256 * DATA_SIZE)
+
+// Modes d'ouverture d'un écrivain
+#define INODE_WRITER_APPEND  0   // Écrire à la suite du contenu actuel
+#define INODE_WRITER_REPLACE 1   // Réécrire depuis le début (blocs réutilisés), fin coupée à la fermeture
+
+/**
+ * Écriture séquentielle d'un fichier en plusieurs morceaux : les verrous, l'inode vérifié,
+ * la position du dernier bloc et les blocs d'indirection sont gardés d'un morceau à l'autre ;
+ * taille et sommes de contrôle ne sont validées qu'à la fermeture
+ */
+typedef struct {
+    fs_context_t *ctx;
+    int inode_index;          // Index de l'inode (mise à jour du résumé à la fermeture)
+    block_t *inode_block;
+    inode_t *inode;
+    uint64_t offset;          // Position de la prochaine écriture
+    uint64_t original_size;   // Taille à l'ouverture
+    int mode;                 // INODE_WRITER_*
+    block_map_t map;          // Table des blocs du fichier
+} inode_writer_t;
+
+/**
+ * Ouvre un fichier pour l'écrire par morceaux (prend ses verrous jusqu'à inode_writer_close)
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à écrire
+ * @param writer Écrivain à initialiser
+ * @param mode INODE_WRITER_APPEND ou INODE_WRITER_REPLACE
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int inode_writer_open(fs_context_t *ctx, int inode_index, inode_writer_t *writer, int mode);
+
+/**
+ * Écrit un morceau à la position courante : blocs existants modifiés sur place, nouveaux
+ * blocs alloués au-delà de la fin
+ * @param writer Écrivain ouvert
+ * @param data Données à écrire
+ * @param size Taille des données
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int inode_writer_write(inode_writer_t *writer, const char *data, uint32_t size);
+
+/**
+ * Ferme l'écrivain : coupe l'ancien contenu restant en mode INODE_WRITER_REPLACE, hache
+ * les blocs modifiés et relâche les verrous
+ * @param writer Écrivain ouvert
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int inode_writer_close(inode_writer_t *writer);
+
+/**
+ * Écrit le contenu d'un fichier dans un descripteur avec writev, sans tampon intermédiaire
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à lire
+ * @param fd Descripteur de destination
+ * @param written Reçoit le nombre d'octets écrits
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int stream_inode_content(fs_context_t *ctx, int inode_index, int fd, uint64_t *written);
+
+/**
+ * Écrit une plage d'un fichier dans un descripteur avec writev (seuls ses blocs sont vérifiés)
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à lire
+ * @param fd Descripteur de destination
+ * @param offset Premier octet de la plage
+ * @param length Longueur maximale de la plage
+ * @param written Reçoit le nombre d'octets écrits
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int stream_inode_range(fs_context_t *ctx, int inode_index, int fd, uint64_t offset, uint64_t length,
+                       uint64_t *written);
+
+/**
+ * Lecture positionnelle : copie au plus length octets à partir de offset
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à lire
+ * @param buffer Destination (au moins length octets)
+ * @param length Nombre maximal d'octets à lire
+ * @param offset Position de lecture
+ * @param bytes_read Reçoit le nombre d'octets lus (0 au-delà de la fin)
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int read_inode_at(fs_context_t *ctx, int inode_index, char *buffer, uint32_t length, uint64_t offset,
+                  uint32_t *bytes_read);
+
 /**
  * Lit le contenu complet d'un fichier à partir de son inode
  * @param ctx Contexte du système de fichiers
  * @param inode_index Index de l'inode à lire
  * @param buffer Pointeur vers un buffer qui sera alloué pour stocker les données
  * @param size Pointeur vers une variable qui recevra la taille des données lues
- * @return 0 en cas de succès, -1 en cas d'erreur
+ * @return 0 en cas de succès, -1 en cas d'erreur (fichier de 4 Gio ou plus : utiliser stream_inode_content)
  */
 int read_inode_content(fs_context_t *ctx, int inode_index, char **buffer, uint32_t *size);
 
@@ -55,15 +276,67 @@ int read_inode_content(fs_context_t *ctx, int inode_index, char **buffer, uint32
  */
 int write_inode_content(fs_context_t *ctx, int inode_index, const char *data, uint32_t size, int append);
 
+/**
+ * Écriture positionnelle : seuls les blocs couvrant [offset, offset + size[ sont modifiés et
+ * rehachés ; au-delà de la fin, le fichier grandit (trou éventuel rempli de zéros)
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à utiliser
+ * @param data Données à écrire
+ * @param size Taille des données à écrire
+ * @param offset Position d'écriture
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int write_inode_at(fs_context_t *ctx, int inode_index, const char *data, uint32_t size, uint64_t offset);
+
+/**
+ * Remplace le contenu d'un fichier en réutilisant ses blocs : seuls les blocs en plus ou
+ * en moins passent par l'allocateur (aucun pour une réécriture de même taille)
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à utiliser
+ * @param data Nouveau contenu
+ * @param size Taille du nouveau contenu
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int overwrite_inode_content(fs_context_t *ctx, int inode_index, const char *data, uint32_t size);
+
+/**
+ * Raccourcit un fichier (sans effet si size dépasse sa taille) et libère les blocs devenus inutiles
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à utiliser
+ * @param size Nouvelle taille
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int truncate_inode(fs_context_t *ctx, int inode_index, uint64_t size);
+
+/**
+ * Nombre de blocs (données et indirection) à allouer pour faire passer un fichier
+ * d'une taille à une autre, pour réserver l'extent d'avance (un fichier qui tient dans son
+ * inode n'occupe aucun bloc ; un petit fichier d'un ancien conteneur est compté comme tel)
+ * @param ctx Contexte du système de fichiers (géométrie des blocs)
+ * @param current_size Taille actuelle du fichier
+ * @param new_size Taille finale du fichier
+ * @return Nombre de blocs à allouer
+ */
+uint32_t blocks_to_allocate(fs_context_t *ctx, uint64_t current_size, uint64_t new_size);
+
 /**
  * Crée un nouveau fichier ou réinitialise un fichier existant
  * @param ctx Contexte du système de fichiers
  * @param filename Nom du fichier à créer/réinitialiser
  * @param check_write Vérifier les permissions d'écriture si le fichier existe
- * @return Index de l'inode créé/réinitialisé ou -1 en cas d'erreur
+ * @return Index de l'inode créé/réinitialisé ou -1 en cas d'erreur (errno positionné)
  */
 int create_or_reset_file(fs_context_t *ctx, const char *filename, int check_write);
 
+/**
+ * Ouvre un fichier existant sans toucher à son contenu, ou le crée s'il n'existe pas
+ * (pour le réécrire ensuite avec overwrite_inode_content)
+ * @param ctx Contexte du système de fichiers
+ * @param filename Nom du fichier
+ * @return Index de l'inode ou -1 en cas d'erreur
+ */
+int create_or_open_file(fs_context_t *ctx, const char *filename);
+
 /**
  * Trouve un fichier par son nom et vérifie les permissions d'accès
  * @param ctx Contexte du système de fichiers
@@ -74,23 +347,44 @@ int create_or_reset_file(fs_context_t *ctx, const char *filename, int check_writ
 int find_file_with_perm_check(fs_context_t *ctx, const char *filename, uint32_t check_perm);
 
 /**
- * Cette méthode n'est pas implémenter
- * @param ctx
- * @param inode_index
- * @param buffer
- * @param size
- * @return
+ * Nombre de threads d'E/S pour traiter un nombre de blocs donné
+ * (processeurs disponibles ou PIGNOUFS_THREADS, au moins 32 blocs par thread)
+ * @param blocks Nombre de blocs à traiter
+ * @return Nombre de threads (au moins 1)
+ */
+int io_thread_count(uint32_t blocks);
+
+/**
+ * Découpe [0, count[ en plages contiguës et applique work à chacune ;
+ * le thread appelant traite la dernière plage (ou celles dont le thread n'a pu être créé)
+ * @param count Nombre d'unités à traiter
+ * @param threads Nombre de threads (io_thread_count)
+ * @param work Traitement des unités [first, last[
+ * @param arg Argument passé à work
+ */
+void run_io_ranges(uint32_t count, int threads, void (*work)(void *arg, uint32_t first, uint32_t last), void *arg);
+
+/**
+ * Lit le contenu complet d'un fichier en parallèle : chaque thread vérifie et copie
+ * une plage disjointe de ses blocs
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à lire
+ * @param buffer Pointeur vers un buffer qui sera alloué pour stocker les données
+ * @param size Pointeur vers une variable qui recevra la taille des données lues
+ * @return 0 en cas de succès, -1 en cas d'erreur
  */
 int read_inode_content_threaded(fs_context_t *ctx, int inode_index, char **buffer, uint32_t *size);
 
 /**
- * Cette méthode n'est pas implémenter
- * @param ctx
- * @param inode_index
- * @param buffer
- * @param size
- * @return
+ * Écrit des données dans un fichier en parallèle : tous les blocs sont alloués d'abord,
+ * puis chaque thread remplit et hache une plage disjointe
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à utiliser
+ * @param data Données à écrire
+ * @param size Taille des données à écrire
+ * @param append Mode d'écriture (0: écrasement, 1: ajout)
+ * @return 0 en cas de succès, -1 en cas d'erreur
  */
-int write_inode_content_threaded(fs_context_t *ctx, int inode_index, char **buffer, uint32_t *size);
+int write_inode_content_threaded(fs_context_t *ctx, int inode_index, const char *data, uint32_t size, int append);
 
 #endif //PSA_PROJECT_INODE_OPS_H
\ No newline at end of file
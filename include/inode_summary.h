@@ -0,0 +1,106 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_INODE_SUMMARY_H
+#define PSA_PROJECT_INODE_SUMMARY_H
+
+#include "fs_structs.h"
+#include "fs_common.h"
+#include "inode_ops.h"
+
+// Résumé des inodes : une colonne par champ (empreinte du nom, drapeaux, taille, position du nom
+// dans le tas), indexée par inode et commençant sur un bloc, puis le tas des noms
+typedef enum {
+    SUMMARY_HASH,             // uint32_t : empreinte du nom (name_hash)
+    SUMMARY_FLAGS,            // uint32_t : drapeaux de l'inode (0 : inode libre)
+    SUMMARY_SIZE,             // uint64_t : taille du fichier
+    SUMMARY_NAME,             // uint32_t : position du nom dans le tas + 1 (0 : nom à lire dans l'inode)
+    SUMMARY_COLUMNS
+} summary_column_t;
+
+// Place réservée en moyenne par inode dans le tas des noms
+#define SUMMARY_NAME_BYTES 24
+
+/**
+ * Nombre de blocs du résumé à réserver pour un nombre d'inodes donné
+ * @param nb_inode Nombre d'inodes du système de fichiers
+ * @return Nombre de blocs du résumé
+ */
+uint32_t inode_summary_blocks_for(uint32_t nb_inode);
+
+/**
+ * Recopie dans le résumé les champs d'un inode qui vient d'être modifié (sans effet si le
+ * conteneur n'a pas de résumé) ; le nom n'est ajouté au tas que s'il a changé
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode
+ * @param inode L'inode (l'appelant en détient les verrous)
+ */
+void inode_summary_update(fs_context_t *ctx, int inode_index, const inode_t *inode);
+
+/**
+ * Vérifie que le résumé correspond à la table des inodes
+ * @param ctx Contexte du système de fichiers
+ * @return 0 si le résumé est cohérent, -1 sinon
+ */
+int inode_summary_check(fs_context_t *ctx);
+
+/**
+ * Reconstruit le résumé à partir de la table des inodes (le tas des noms est compacté)
+ * @param ctx Contexte du système de fichiers
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int inode_summary_rebuild(fs_context_t *ctx);
+
+/**
+ * Fichier rendu par un parcours du résumé
+ */
+typedef struct {
+    int inode_index;
+    const char *filename;     // Dans le tas des noms ou dans l'inode
+    uint32_t hash;            // Empreinte du nom
+    uint32_t flags;
+    uint64_t size;
+} summary_entry_t;
+
+/**
+ * Parcours des fichiers existants par le résumé : chaque bloc de colonne n'est vérifié qu'une
+ * fois, et la table des inodes n'est pas lue. Sans résumé, ou à partir d'un bloc du résumé
+ * corrompu, le parcours continue sur la table des inodes
+ */
+typedef struct {
+    fs_context_t *ctx;
+    int use_summary;          // Parcours du résumé (sinon de la table des inodes)
+    uint32_t next;            // Prochain index d'inode à examiner
+    uint32_t end;             // Fin (exclue) de la plage d'inodes parcourue
+    uint32_t column_first[SUMMARY_COLUMNS + 1]; // Premier bloc de chaque colonne et du tas
+    block_t *verified[SUMMARY_COLUMNS + 1]; // Dernier bloc vérifié de chaque colonne et du tas
+    inode_scan_t inodes;      // Parcours de la table des inodes (repli)
+} summary_scan_t;
+
+/**
+ * Commence un parcours des fichiers existants
+ * @param scan Parcours à initialiser
+ * @param ctx Contexte du système de fichiers
+ */
+void summary_scan_init(summary_scan_t *scan, fs_context_t *ctx);
+
+/**
+ * Commence un parcours limité aux inodes [first, end[ (plusieurs parcours d'un même
+ * contexte peuvent avancer en parallèle, un par thread)
+ * @param scan Parcours à initialiser
+ * @param ctx Contexte du système de fichiers
+ * @param first Premier index d'inode
+ * @param end Fin (exclue) de la plage, bornée à sb->max_inodes
+ */
+void summary_scan_init_range(summary_scan_t *scan, fs_context_t *ctx, uint32_t first, uint32_t end);
+
+/**
+ * Fichier existant suivant
+ * @param scan Parcours en cours
+ * @param entry Reçoit le fichier (ses pointeurs restent valides jusqu'à la libération du contexte)
+ * @return 1 si un fichier est rendu, 0 à la fin de la table
+ */
+int summary_scan_next(summary_scan_t *scan, summary_entry_t *entry);
+
+#endif //PSA_PROJECT_INODE_SUMMARY_H
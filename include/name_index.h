@@ -0,0 +1,74 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_NAME_INDEX_H
+#define PSA_PROJECT_NAME_INDEX_H
+
+#include "fs_structs.h"
+#include "fs_common.h"
+
+// Nombre d'entrées de l'index contenues dans un bloc
+#define NAME_INDEX_ENTRIES_PER_BLOCK (DATA_SIZE / sizeof(name_index_entry_t))
+
+// Valeur du champ inode d'une entrée supprimée (la sonde doit continuer)
+#define NAME_INDEX_TOMBSTONE 0xFFFFFFFFu
+
+// Retour de name_index_lookup quand un bloc de l'index traversé est corrompu
+#define NAME_INDEX_CORRUPT (-2)
+
+/**
+ * Calcule l'empreinte d'un nom de fichier (FNV-1a 32 bits)
+ * @param filename Nom du fichier
+ * @return L'empreinte du nom
+ */
+uint32_t name_hash(const char *filename);
+
+/**
+ * Nombre de blocs d'index à réserver pour un nombre d'inodes donné
+ * (au moins deux entrées par inode pour garder des sondes courtes)
+ * @param nb_inode Nombre d'inodes du système de fichiers
+ * @return Nombre de blocs d'index
+ */
+uint32_t name_index_blocks_for(uint32_t nb_inode);
+
+/**
+ * Recherche un nom dans l'index (chaque bloc traversé est vérifié)
+ * @param ctx Contexte du système de fichiers
+ * @param filename Nom du fichier
+ * @return Index de l'inode, -1 si le nom est absent, NAME_INDEX_CORRUPT si l'index est corrompu
+ */
+int name_index_lookup(fs_context_t *ctx, const char *filename);
+
+/**
+ * Ajoute un nom dans l'index
+ * @param ctx Contexte du système de fichiers
+ * @param filename Nom du fichier (tel que stocké dans l'inode)
+ * @param inode_index Index de l'inode associé
+ * @return 0 en cas de succès, -1 si l'index est plein
+ */
+int name_index_insert(fs_context_t *ctx, const char *filename, int inode_index);
+
+/**
+ * Retire un nom de l'index
+ * @param ctx Contexte du système de fichiers
+ * @param filename Nom du fichier
+ * @param inode_index Index de l'inode associé
+ */
+void name_index_remove(fs_context_t *ctx, const char *filename, int inode_index);
+
+/**
+ * Vérifie que chaque inode existant est retrouvé par l'index
+ * @param addr Projection mémoire du système de fichiers
+ * @return 0 si l'index est cohérent, -1 sinon
+ */
+int name_index_check(void *addr);
+
+/**
+ * Reconstruit entièrement l'index à partir de la table des inodes
+ * @param ctx Contexte du système de fichiers
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int name_index_rebuild(fs_context_t *ctx);
+
+#endif //PSA_PROJECT_NAME_INDEX_H
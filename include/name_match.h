@@ -0,0 +1,47 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_NAME_MATCH_H
+#define PSA_PROJECT_NAME_MATCH_H
+
+#include <stddef.h>
+
+// Façons de comparer un nom au motif (toujours sans tenir compte de la casse ASCII)
+typedef enum {
+    NAME_MATCH_SUBSTRING,     // Le nom contient le motif
+    NAME_MATCH_PREFIX,        // Le nom commence par le motif
+    NAME_MATCH_GLOB           // Le nom entier correspond au motif (*, ? et [...])
+} name_match_mode_t;
+
+/**
+ * Motif préparé une seule fois pour toute une recherche
+ */
+typedef struct {
+    name_match_mode_t mode;
+    char pattern[256];        // Motif en minuscules (tronqué à 255 octets, comme les noms)
+    size_t len;
+} name_matcher_t;
+
+/**
+ * Prépare un motif
+ * @param matcher Motif à initialiser
+ * @param pattern Motif tel que donné par l'utilisateur
+ * @param mode Façon de le comparer aux noms
+ */
+void name_matcher_init(name_matcher_t *matcher, const char *pattern, name_match_mode_t mode);
+
+/**
+ * Compare un nom au motif, sans copier le nom
+ * @param matcher Motif préparé
+ * @param name Nom terminé par un zéro
+ * @return 1 si le nom correspond, 0 sinon
+ */
+int name_matcher_match(const name_matcher_t *matcher, const char *name);
+
+/**
+ * Nom du moteur de recherche de sous-chaîne choisi (avx2, sse2 ou scalar)
+ */
+const char *name_match_engine_name(void);
+
+#endif //PSA_PROJECT_NAME_MATCH_H
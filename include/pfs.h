@@ -0,0 +1,103 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_PFS_H
+#define PSA_PROJECT_PFS_H
+
+/// libpignoufs : accès à un conteneur depuis un autre programme, sans passer par la ligne
+/// de commande. Le conteneur est ouvert une fois (pfs_open_fs) ; chaque fichier ouvert garde
+/// son inode et sa table de blocs, revalidées seulement si l'inode a changé entre-temps
+///
+/// En cas d'erreur, les fonctions renvoient -1 (ou NULL) et positionnent errno ; rien n'est
+/// écrit sur la sortie d'erreur (messages du cœur supprimés dès pfs_open_fs).
+/// Un même pfs_fs_t ne doit pas être utilisé par plusieurs threads à la fois
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <fcntl.h>
+
+typedef struct pfs_fs pfs_fs_t;
+typedef struct pfs_file pfs_file_t;
+
+/**
+ * Informations sur un fichier du conteneur
+ */
+typedef struct {
+    uint32_t inode;          // Index de l'inode
+    uint64_t size;           // Taille en octets
+    uint32_t flags;          // PERM_* (existe, lecture, écriture, répertoire...)
+    uint32_t mode;           // Droits d'accès copiés à l'import
+    char name[256];          // Nom du fichier
+} pfs_stat_t;
+
+/**
+ * Ouvre un conteneur
+ * @param path Chemin du fichier conteneur
+ * @param flags O_RDONLY ou O_RDWR
+ * @return Le conteneur ouvert, NULL en cas d'erreur
+ */
+pfs_fs_t *pfs_open_fs(const char *path, int flags);
+
+/**
+ * Ferme un conteneur (recalcule les sommes de contrôle en attente)
+ * Les fichiers encore ouverts sont fermés
+ * @param fs Conteneur ouvert
+ */
+void pfs_close_fs(pfs_fs_t *fs);
+
+/**
+ * Ouvre un fichier du conteneur
+ * @param fs Conteneur ouvert
+ * @param name Nom du fichier (le préfixe "//" des commandes est accepté)
+ * @param flags O_RDONLY, O_WRONLY ou O_RDWR, avec éventuellement O_CREAT et O_TRUNC
+ * @return Le fichier ouvert, NULL en cas d'erreur
+ */
+pfs_file_t *pfs_open(pfs_fs_t *fs, const char *name, int flags);
+
+/**
+ * Lit au plus count octets à partir de offset
+ * @param file Fichier ouvert en lecture
+ * @param buf Destination
+ * @param count Nombre d'octets demandés
+ * @param offset Position de lecture
+ * @return Nombre d'octets lus (0 au-delà de la fin), -1 en cas d'erreur
+ */
+ssize_t pfs_pread(pfs_file_t *file, void *buf, size_t count, uint64_t offset);
+
+/**
+ * Écrit count octets à partir de offset (un trou éventuel est rempli de zéros)
+ * @param file Fichier ouvert en écriture
+ * @param buf Données à écrire
+ * @param count Nombre d'octets (au plus 4 Gio - 1 par appel, le reste n'est pas écrit)
+ * @param offset Position d'écriture
+ * @return Nombre d'octets écrits, -1 en cas d'erreur (EFBIG au-delà de la taille maximale d'un fichier)
+ */
+ssize_t pfs_pwrite(pfs_file_t *file, const void *buf, size_t count, uint64_t offset);
+
+/**
+ * Ferme un fichier
+ * @param file Fichier ouvert
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int pfs_close(pfs_file_t *file);
+
+/**
+ * Informations sur un fichier, par son nom
+ * @param fs Conteneur ouvert
+ * @param name Nom du fichier
+ * @param st Reçoit les informations
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int pfs_stat(pfs_fs_t *fs, const char *name, pfs_stat_t *st);
+
+/**
+ * Parcourt les fichiers du conteneur
+ * @param fs Conteneur ouvert
+ * @param cursor Position du parcours (0 pour commencer), mise à jour à chaque appel
+ * @param st Reçoit les informations du fichier suivant
+ * @return 1 si un fichier a été rendu, 0 à la fin du parcours, -1 en cas d'erreur
+ */
+int pfs_readdir(pfs_fs_t *fs, uint32_t *cursor, pfs_stat_t *st);
+
+#endif //PSA_PROJECT_PFS_H
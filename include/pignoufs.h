@@ -19,10 +19,14 @@
 
 // def des constantes
 #define BLOCK_SIZE         4168
-#define DATA_SIZE          4000
+#define PAGE_BLOCK_SIZE    4096   // Bloc du format v2 : une page, données et en-tête (verrou d'écriture rangé à part)
+#define DATA_SIZE          4000   // Données d'un bloc v1 ; minimum de la géométrie (sb->data_size)
 #define SHA1_SIZE          20
 #define TYPE_SIZE          4
 #define LOCK_SIZE          72
+#define BLOCK_META_SIZE    (SHA1_SIZE + TYPE_SIZE + LOCK_SIZE) // En-tête d'un bloc v2, après ses données
+#define MAX_BLOCK_SIZE     65536  // Plus grand bloc v2 accepté par mkfs
+#define PACKED_INODE_SLOT  500    // Place d'un inode (et de ses données en ligne) dans une table compacte
 
 // Types de blocs
 #define BLOCK_TYPE_SUPERBLOCK 1
@@ -30,6 +34,29 @@
 #define BLOCK_TYPE_INODE      3
 #define BLOCK_TYPE_DATA       4
 #define BLOCK_TYPE_INDIRECT   5
+#define BLOCK_TYPE_NAME_INDEX 6
+#define BLOCK_TYPE_INODE_BITMAP 7
+#define BLOCK_TYPE_INODE_SUMMARY 8
+#define BLOCK_TYPE_TRIGRAM_INDEX 9
+
+// Fonctionnalités optionnelles du format (champ features du superbloc)
+#define FS_FEATURE_NAME_INDEX 0x1
+#define FS_FEATURE_INODE_BITMAP 0x2
+#define FS_FEATURE_ALLOC_SUMMARY 0x4
+#define FS_FEATURE_PAGE_BLOCKS 0x8     // Format v2 : blocs d'une page, table des verrous d'écriture après les blocs
+#define FS_FEATURE_LARGE_FILES 0x10    // Tailles de fichiers sur 64 bits (inode_t::size_hi)
+#define FS_FEATURE_INLINE_DATA 0x20    // Petits fichiers rangés dans le bloc de leur inode (PERM_INLINE)
+#define FS_FEATURE_PACKED_INODES 0x40  // Table des inodes compacte : sb->inodes_per_block inodes par bloc
+#define FS_FEATURE_INODE_SUMMARY 0x80  // Résumé des inodes en colonnes (nom, drapeaux, taille) pour ls, find et df
+#define FS_FEATURE_TRIGRAM_INDEX 0x100 // Index des trigrammes des noms pour find (mkfs ... trigram)
+
+// Algorithmes de somme de contrôle des blocs (champ checksum_algo du superbloc)
+#define CHECKSUM_SHA1   0
+#define CHECKSUM_CRC32C 1
+#define CHECKSUM_XXH64  2
+
+// Nombre maximal de blocs de bitmap dont le superbloc garde le compteur de blocs libres
+#define SB_MAX_BITMAP_BLOCKS 768
 
 // Codes d'erreurs
 // (jsp trop encore si on en a besoin, mais c'est souvent présent dans les projets que j'ai vu)
@@ -50,6 +77,7 @@
 #define PERM_LOCK_WRITE 0x10
 #define PERM_DIR 0x20
 #define PERM_EXEC 0x40
+#define PERM_INLINE 0x80   // Contenu rangé dans le bloc d'inode, après l'inode (aucun bloc de données)
 
 #define UNUSED(x) (void)(x)
 #endif //PSA_PROJECT_PIGNOUFS_H
@@ -0,0 +1,31 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_SHA1_MB_H
+#define PSA_PROJECT_SHA1_MB_H
+
+#include "pignoufs.h"
+
+// Nombre de messages hachés simultanément par le moteur multi-buffer
+#define SHA1_MB_LANES 8
+
+/**
+ * Calcule le SHA1 de plusieurs messages de même longueur en une passe
+ * Le moteur est choisi une seule fois selon le processeur : AVX2 multi-buffer (8 messages
+ * par passe) ou, à défaut, le SHA1 d'OpenSSL message par message (qui exploite lui-même
+ * SHA-NI). PIGNOUFS_SHA1_ENGINE=openssl force le second
+ * @param data Adresse de chaque message
+ * @param len Longueur commune des messages
+ * @param digests Reçoit l'empreinte de chaque message
+ * @param count Nombre de messages
+ */
+void sha1_many(const unsigned char *const *data, size_t len, unsigned char (*digests)[SHA1_SIZE], int count);
+
+/**
+ * Nom du moteur retenu par sha1_many (pour les messages de diagnostic)
+ * @return "avx2" ou "openssl"
+ */
+const char *sha1_engine_name(void);
+
+#endif //PSA_PROJECT_SHA1_MB_H
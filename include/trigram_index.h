@@ -0,0 +1,85 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_TRIGRAM_INDEX_H
+#define PSA_PROJECT_TRIGRAM_INDEX_H
+
+#include "fs_structs.h"
+#include "fs_common.h"
+
+// Index des trigrammes : les trigrammes des noms (en minuscules) sont répartis en
+// TRIGRAM_BUCKETS seaux, et chaque seau a sa liste des inodes, rangée en bitmap de
+// ceil(max_inodes / 64) mots. Les seaux se suivent dans la zone, DATA_SIZE octets par bloc
+#define TRIGRAM_BUCKETS 512
+
+// Nombre maximal de seaux distincts retenus pour une requête (les premiers suffisent à filtrer)
+#define TRIGRAM_MAX_QUERY 64
+
+/**
+ * Nombre de blocs de l'index des trigrammes pour un nombre d'inodes donné
+ * @param nb_inode Nombre d'inodes du système de fichiers
+ * @return Nombre de blocs
+ */
+uint32_t trigram_index_blocks_for(uint32_t nb_inode);
+
+/**
+ * Ajoute un inode aux listes des trigrammes de son nom (sans effet sans index)
+ * @param ctx Contexte du système de fichiers
+ * @param filename Nom du fichier
+ * @param inode_index Index de l'inode
+ */
+void trigram_index_insert(fs_context_t *ctx, const char *filename, int inode_index);
+
+/**
+ * Retire un inode des listes des trigrammes de son nom (sans effet sans index)
+ * @param ctx Contexte du système de fichiers
+ * @param filename Nom du fichier (avant son effacement)
+ * @param inode_index Index de l'inode
+ */
+void trigram_index_remove(fs_context_t *ctx, const char *filename, int inode_index);
+
+/**
+ * Vérifie que l'index correspond exactement aux noms de la table des inodes
+ * @param ctx Contexte du système de fichiers
+ * @return 0 si l'index est cohérent, -1 sinon
+ */
+int trigram_index_check(fs_context_t *ctx);
+
+/**
+ * Reconstruit l'index à partir de la table des inodes
+ * @param ctx Contexte du système de fichiers
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int trigram_index_rebuild(fs_context_t *ctx);
+
+/**
+ * Seaux dont un nom doit faire partie pour correspondre à une recherche
+ */
+typedef struct {
+    uint32_t buckets[TRIGRAM_MAX_QUERY];
+    uint32_t count;
+} trigram_query_t;
+
+/**
+ * Ajoute à une requête les trigrammes d'un morceau de texte que tout nom trouvé contient
+ * (moins de trois octets : rien à ajouter)
+ * @param query Requête (initialisée à zéro par l'appelant)
+ * @param literal Texte
+ * @param len Longueur du texte
+ */
+void trigram_query_add(trigram_query_t *query, const char *literal, size_t len);
+
+/**
+ * Parcourt, dans l'ordre des index, les inodes présents dans tous les seaux de la requête :
+ * des candidats, dont le nom reste à comparer au motif
+ * @param ctx Contexte du système de fichiers
+ * @param query Requête (au moins un seau)
+ * @param visit Appelé pour chaque candidat
+ * @param arg Argument passé à visit
+ * @return Nombre de candidats, -1 si l'index est absent ou corrompu (parcours complet à faire)
+ */
+int64_t trigram_index_search(fs_context_t *ctx, const trigram_query_t *query,
+                             void (*visit)(void *arg, int inode_index), void *arg);
+
+#endif //PSA_PROJECT_TRIGRAM_INDEX_H
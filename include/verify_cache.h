@@ -0,0 +1,81 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#ifndef PSA_PROJECT_VERIFY_CACHE_H
+#define PSA_PROJECT_VERIFY_CACHE_H
+
+#include "pignoufs.h"
+
+// Politique de vérification des blocs lus (variable d'environnement PIGNOUFS_VERIFY)
+#define VERIFY_ALWAYS 0   // "always" : chaque accès recalcule la somme de contrôle
+#define VERIFY_ONCE   1   // "once"   : une fois par génération du bloc (défaut)
+#define VERIFY_OPEN   2   // "open"   : une fois par ouverture du conteneur
+
+/**
+ * Cache des blocs déjà vérifiés : pour chaque bloc, génération + 1 lors de la dernière
+ * vérification réussie (0 = jamais vérifié)
+ * Local au processus par défaut, ou partagé entre processus en mémoire partagée
+ * (PIGNOUFS_VERIFY_CACHE=shm), nommé d'après l'identifiant du conteneur : le segment vit tant
+ * qu'un processus l'a ouvert ; celui d'un processus tué reste dans /dev/shm/pignoufs-* jusqu'au
+ * redémarrage ou à sa suppression à la main
+ */
+typedef struct {
+    int policy;              // VERIFY_*
+    uint32_t num_blocks;     // Nombre de blocs suivis
+    uint32_t *verified;      // Génération vérifiée de chaque bloc (+1), NULL si policy == VERIFY_ALWAYS
+    void *shm;               // Segment partagé (nommé : en-tête + verified ; anonyme : verified) ou NULL
+    size_t shm_size;         // Taille du segment partagé
+    char shm_name[64];       // Nom du segment nommé (vide pour un segment anonyme)
+} verify_cache_t;
+
+/**
+ * Crée le cache selon PIGNOUFS_VERIFY et PIGNOUFS_VERIFY_CACHE
+ * Si la mémoire partagée n'est pas disponible, le cache reste local
+ * @param fd Descripteur du conteneur (identifie le fichier pour le cache partagé)
+ * @param fs_id Identifiant aléatoire du conteneur (superbloc)
+ * @param num_blocks Nombre de blocs du conteneur
+ * @return Le cache, ou NULL en cas d'erreur d'allocation
+ */
+verify_cache_t *verify_cache_open(int fd, uint32_t fs_id, uint32_t num_blocks);
+
+/**
+ * Rend un cache local commun au processus et aux fils qu'il créera ensuite (démon : les
+ * vérifications faites par une commande profitent aux suivantes)
+ * @param cache Le cache (peut être NULL)
+ * @return 0 en cas de succès, -1 si le cache reste propre à chaque processus
+ */
+int verify_cache_share(verify_cache_t *cache);
+
+/**
+ * Relit PIGNOUFS_VERIFY (commande exécutée par le démon avec l'environnement de son client) ;
+ * un cache créé en "always" le reste
+ * @param cache Le cache (peut être NULL)
+ * @param fallback Politique si le client n'a pas positionné PIGNOUFS_VERIFY
+ */
+void verify_cache_reload_policy(verify_cache_t *cache, int fallback);
+
+/**
+ * Libère le cache ; le dernier processus à fermer un segment nommé le supprime
+ * @param cache Le cache (peut être NULL)
+ */
+void verify_cache_close(verify_cache_t *cache);
+
+/**
+ * Indique si un bloc a déjà été vérifié dans cette génération
+ * @param cache Le cache (peut être NULL)
+ * @param block_index Index du bloc
+ * @param generation Génération courante du bloc
+ * @return 1 si la vérification peut être sautée, 0 sinon
+ */
+int verify_cache_hit(verify_cache_t *cache, uint32_t block_index, uint32_t generation);
+
+/**
+ * Enregistre une vérification réussie
+ * @param cache Le cache (peut être NULL)
+ * @param block_index Index du bloc
+ * @param generation Génération du bloc lue avant la vérification
+ */
+void verify_cache_store(verify_cache_t *cache, uint32_t block_index, uint32_t generation);
+
+#endif //PSA_PROJECT_VERIFY_CACHE_H
@@ -50,15 +50,33 @@ int cmd_add(const char *fsname, const char *source, const char *destination) {
     int dest_inode_index = find_file_with_perm_check(&ctx, destination, PERM_WRITE);
     if (dest_inode_index < 0) {
         fs_error("Fichier destination introuvable ou non accessible en écriture\n");
-        munmap(src_map, (int) src_size);
+        munmap(src_map, (size_t) src_size);
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
 
-    // Écrire à la fin du fichier interne (append = 1)
-    if (write_inode_content(&ctx, dest_inode_index, src_map, src_size, 1) < 0) {
+    // Réserver d'un coup l'extent de la partie ajoutée (taille finale connue)
+    inode_t *dest_inode = get_inode(ctx.fs_map, dest_inode_index);
+    uint64_t dest_size = inode_size(dest_inode);
+    if (reserve_blocks(&ctx, blocks_to_allocate(&ctx, dest_size, dest_size + (uint64_t) src_size)) < 0) {
+        fs_error("Espace insuffisant sur le système de fichiers\n");
+        munmap(src_map, (size_t) src_size);
+        fs_free_context(&ctx);
+        return EXIT_FAILURE;
+    }
+
+    // Écrire à la fin du fichier interne (append = 1), par tranches d'au plus 1 Gio
+    // (les tailles passées à write_inode_content sont sur 32 bits)
+    int write_result = 0;
+    for (ssize_t done = 0; write_result == 0 && done < src_size;) {
+        uint32_t chunk = src_size - done < (1 << 30) ? (uint32_t) (src_size - done) : (1u << 30);
+        write_result = write_inode_content(&ctx, dest_inode_index, (const char *) src_map + done, chunk, 1);
+        done += chunk;
+    }
+    release_reserved_blocks(&ctx);
+    if (write_result < 0) {
         fs_error("Erreur lors de l'ajout au fichier destination\n");
-        munmap(src_map, (int) src_size);
+        munmap(src_map, (size_t) src_size);
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
@@ -66,7 +84,7 @@ int cmd_add(const char *fsname, const char *source, const char *destination) {
     printf("Contenu de '%s' ajouté avec succès à '%s' (%zu octets)\n",
            source, destination, src_size);
 
-    munmap(src_map, (int) src_size);
+    munmap(src_map, (size_t) src_size);
     fs_free_context(&ctx);
     return EXIT_SUCCESS;
 }
@@ -10,9 +10,9 @@
 int cmd_addinput(const char *fsname, const char *filename) {
     fs_context_t ctx;
     char *buffer = NULL;
-    uint32_t buffer_size = DATA_SIZE;
+    uint32_t buffer_size = INODE_WRITER_CHUNK;
 
-    // Allouer un buffer pour lire l'entrée standard
+    // Allouer un buffer pour lire l'entrée standard par gros morceaux
     buffer = malloc(buffer_size);
     if (!buffer) {
         return fs_error("Erreur d'allocation mémoire");
@@ -33,23 +33,32 @@ int cmd_addinput(const char *fsname, const char *filename) {
     }
 
     // Lire l'entrée standard et ajouter au fichier
+    // (verrous, dernier bloc et bloc d'indirection gardés d'un morceau à l'autre)
+    inode_writer_t writer;
+    if (inode_writer_open(&ctx, inode_index, &writer, INODE_WRITER_APPEND) < 0) {
+        free(buffer);
+        fs_free_context(&ctx);
+        return EXIT_FAILURE;
+    }
+
     ssize_t total_bytes = 0;
     ssize_t bytes_read;
+    int result = 0;
 
     // Boucle pour lire l'entrée standard
     while ((bytes_read = read(STDIN_FILENO, buffer, buffer_size)) > 0) {
-        // Toujours écrire en mode ajout (append=1)
-        if (write_inode_content(&ctx, inode_index, buffer, bytes_read, 1) < 0) {
-            fs_error("Erreur lors de l'écriture dans le fichier '%s'", filename);
-            free(buffer);
-            fs_free_context(&ctx);
-            return EXIT_FAILURE;
+        if (inode_writer_write(&writer, buffer, (uint32_t) bytes_read) < 0) {
+            result = fs_error("Erreur lors de l'écriture dans le fichier '%s'", filename);
+            break;
         }
         total_bytes += bytes_read;
     }
 
     if (bytes_read < 0) {
-        fs_error("Erreur lors de la lecture de l'entrée standard");
+        result = fs_error("Erreur lors de la lecture de l'entrée standard");
+    }
+
+    if (inode_writer_close(&writer) < 0 || result < 0) {
         free(buffer);
         fs_free_context(&ctx);
         return EXIT_FAILURE;
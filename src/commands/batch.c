@@ -0,0 +1,116 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "../../include/pignoufs.h"
+#include "../../include/fs_common.h"
+#include "../../include/commands.h"
+
+// Taille maximale d'une ligne du script et nombre maximal d'arguments par commande
+#define BATCH_LINE_MAX 4096
+#define BATCH_MAX_ARGS 64
+
+// Commandes refusées dans un lot : elles lisent l'entrée standard (le script lui-même),
+// attendent un signal, ou ouvrent le conteneur autrement
+static const char *batch_forbidden[] = {"mkfs", "lock", "serve", "batch", "input", "addinput", NULL};
+
+/**
+ * Découpe une ligne en arguments (séparés par des blancs, guillemets simples ou doubles)
+ * La ligne est modifiée en place
+ * @return Nombre d'arguments, -1 si la ligne est mal formée
+ */
+static int split_line(char *line, char **argv, int max_args) {
+    int argc = 0;
+    char *p = line;
+
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+        if (!*p || *p == '#') break;
+        if (argc == max_args) return -1;
+
+        // Recopier l'argument sur place, sans ses guillemets
+        char *out = p;
+        argv[argc++] = out;
+        char quote = 0;
+        while (*p && (quote || (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r'))) {
+            if (quote && *p == quote) {
+                quote = 0;
+            } else if (!quote && (*p == '"' || *p == '\'')) {
+                quote = *p;
+            } else {
+                *out++ = *p;
+            }
+            p++;
+        }
+        if (quote) return -1;
+        if (*p) p++;
+        *out = '\0';
+    }
+    return argc;
+}
+
+int cmd_batch(const char *fsname, batch_runner_t run) {
+    fs_context_t ctx;
+    if (init_fs_context_and_verify(fsname, &ctx, O_RDWR) < 0) {
+        return EXIT_FAILURE;
+    }
+    ctx.verify_cache = verify_cache_open(ctx.fd, ctx.sb->fs_id, ctx.sb->num_blocks);
+
+    // Toutes les commandes du lot empruntent ce contexte ; sommes des bitmaps et msync à la fin
+    ctx.deferred = 1;
+    fs_set_resident_context(fsname, &ctx);
+
+    char line[BATCH_LINE_MAX];
+    char *argv[BATCH_MAX_ARGS];
+    int line_number = 0;
+    int failures = 0;
+
+    while (fgets(line, sizeof(line), stdin)) {
+        line_number++;
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n') {
+            fs_error("Ligne %d : trop longue", line_number);
+            failures++;
+            // Ignorer la fin de la ligne
+            int c;
+            while ((c = getchar()) != EOF && c != '\n') {}
+            continue;
+        }
+
+        int argc = split_line(line, argv, BATCH_MAX_ARGS);
+        if (argc == 0) continue;  // Ligne vide ou commentaire
+        if (argc < 0) {
+            fs_error("Ligne %d : commande mal formée", line_number);
+            failures++;
+            continue;
+        }
+
+        int forbidden = 0;
+        for (const char **name = batch_forbidden; *name && !forbidden; name++) {
+            forbidden = strcmp(argv[0], *name) == 0;
+        }
+        // write-at sans données lirait, elle aussi, l'entrée standard
+        forbidden |= strcmp(argv[0], "write-at") == 0 && argc < 4;
+        if (forbidden) {
+            fs_error("Ligne %d : commande '%s' interdite dans un lot", line_number, argv[0]);
+            failures++;
+            continue;
+        }
+
+        if (run(fsname, argv[0], argc - 1, argv + 1) != EXIT_SUCCESS) {
+            fs_error("Ligne %d : échec de '%s'", line_number, argv[0]);
+            failures++;
+        }
+        fflush(stdout);
+    }
+
+    // Point de commit du lot : chaque bloc de bitmap modifié n'est haché qu'une fois, puis un seul msync
+    fs_set_resident_context(NULL, NULL);
+    ctx.deferred = 0;
+    fs_commit(&ctx);
+    fs_sync(&ctx);
+    fs_free_context(&ctx);
+
+    printf("Lot terminé : %d commande(s) en échec\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -10,11 +10,10 @@
 #include "../../include/fs_common.h"
 
 
-int cmd_cat(const char *fsname, const char *filename) {
+int cmd_cat(const char *fsname, const char *filename, uint64_t offset, uint64_t length) {
     fs_context_t ctx;
-    int result = EXIT_FAILURE;
-    char *buffer = NULL;
-    uint32_t buffer_size = 0;
+    int result = EXIT_SUCCESS;
+    uint64_t written = 0;
 
     // Initialiser le contexte du système de fichiers et vérifier sa validité
     if (init_fs_context_and_verify(fsname, &ctx, O_RDWR) < 0) {
@@ -30,27 +29,12 @@ int cmd_cat(const char *fsname, const char *filename) {
         return EXIT_FAILURE;
     }
 
-    // Lire le contenu du fichier
-    if (read_inode_content(&ctx, inode_index, &buffer, &buffer_size) < 0) {
-        fs_free_context(&ctx);
-        return EXIT_FAILURE;
-    }
-
-    // Afficher le contenu du fichier
-    if (buffer_size > 0) {
-        if (write(STDOUT_FILENO, buffer, buffer_size) != buffer_size) {
-            perror("Erreur lors de l'écriture sur la sortie standard");
-            result = EXIT_FAILURE;
-        } else {
-            result = EXIT_SUCCESS;
-        }
-    } else {
-        // Fichier vide
-        result = EXIT_SUCCESS;
+    // Envoyer le contenu (ou la plage demandée) sur la sortie standard directement depuis les blocs projetés
+    if (stream_inode_range(&ctx, inode_index, STDOUT_FILENO, offset, length, &written) < 0) {
+        result = EXIT_FAILURE;
     }
 
     // Libérer les ressources
-    free(buffer);
     fs_free_context(&ctx);
     return result;
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "fs_structs.h"
 #include "block_ops.h"
 #include "inode_ops.h"
+#include "inode_summary.h"
 
 int cmd_chmod(const char *fsname, const char *filename, const char *mode) {
     fs_context_t ctx;
@@ -26,14 +27,14 @@ int cmd_chmod(const char *fsname, const char *filename, const char *mode) {
     }
 
     block_t *inode_block = get_inode_block(ctx.fs_map, inode_index);
-    if (!inode_block || !verify_block_sha1(inode_block)) {
+    if (!inode_block || !verify_block_checksum(&ctx, inode_block)) {
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
 
-    pthread_mutex_lock((pthread_mutex_t *) inode_block->lock_write);
+    pthread_mutex_lock(block_write_lock(ctx.fs_map, inode_block));
 
-    inode_t *inode = (inode_t *) inode_block->data;
+    inode_t *inode = get_inode(ctx.fs_map, inode_index);
 
     if (strcmp(mode, "+r") == 0) {
         inode->flags |= PERM_READ;
@@ -44,19 +45,19 @@ int cmd_chmod(const char *fsname, const char *filename, const char *mode) {
     } else if (strcmp(mode, "-w") == 0) {
         inode->flags &= ~PERM_WRITE;
     } else {
-        pthread_mutex_unlock((pthread_mutex_t *) inode_block->lock_write);
+        pthread_mutex_unlock(block_write_lock(ctx.fs_map, inode_block));
         fs_error("Mode invalide. Utiliser +r, -r, +w ou -w\n");
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
 
-    compute_block_sha1(inode_block);
+    mark_block_dirty(&ctx, inode_block);
+    inode_summary_update(&ctx, inode_index, inode);
+    fs_commit(&ctx);
 
-    pthread_mutex_unlock((pthread_mutex_t *) inode_block->lock_write);
+    pthread_mutex_unlock(block_write_lock(ctx.fs_map, inode_block));
 
-    if (msync(ctx.fs_map, (int) ctx.fs_size, MS_SYNC) < 0) {
-        perror("Erreur msync");
-    }
+    fs_sync(&ctx);
 
     fs_free_context(&ctx);
 
@@ -7,6 +7,11 @@
 #include "../../include/block_ops.h"
 #include "../../include/inode_ops.h"
 #include "../../include/fs_common.h"
+#include "../../include/fs_utils.h"
+
+// Au-delà, la source est copiée par morceaux au lieu d'être lue d'un coup en mémoire
+// (read plafonne d'ailleurs à 2 Gio par appel)
+#define CP_BUFFER_MAX (256u * 1024 * 1024)
 
 /**
  * Copier un fichier de Pignoufs vers le système de fichiers réel
@@ -24,12 +29,12 @@ int copy_from_pignoufs(fs_context_t *ctx, const char *pignoufs_path, const char
 
     // Récupérer le bloc d'inode
     block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
-    if (!inode_block || !verify_block_sha1(inode_block)) {
+    if (!inode_block || !verify_block_checksum(ctx, inode_block)) {
         return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
     }
 
     // Récupérer l'inode
-    inode_t *inode = (inode_t *) inode_block->data;
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
 
     // Ouvrir le fichier destination
     int dst_fd = open(ext_path, O_WRONLY | O_CREAT | O_TRUNC, inode->mode ? inode->mode : 0644);
@@ -37,30 +42,77 @@ int copy_from_pignoufs(fs_context_t *ctx, const char *pignoufs_path, const char
         return fs_error("Erreur lors de l'ouverture du fichier destination");
     }
 
-    // Utiliser read_inode_content pour lire le contenu du fichier
-    char *buffer = NULL;
-    uint32_t buffer_size = 0;
+    uint64_t bytes_written = 0;
+    uint64_t size = inode_size(inode);
+    if (size <= UINT32_MAX && io_thread_count((uint32_t) ((size + ctx->data_size - 1) / ctx->data_size)) > 1) {
+        // Plusieurs cœurs : vérifier et copier les blocs en parallèle, puis écrire d'un coup
+        // (au-delà de 4 Gio, le fichier ne tient pas dans un seul buffer : écriture directe)
+        char *buffer = NULL;
+        uint32_t buffer_size = 0;
+        if (read_inode_content_threaded(ctx, inode_index, &buffer, &buffer_size) < 0) {
+            close(dst_fd);
+            return -1;  // L'erreur a déjà été affichée
+        }
+        bytes_written = buffer_size;
 
-    if (read_inode_content(ctx, inode_index, &buffer, &buffer_size) < 0) {
+        struct iovec iov = {buffer, buffer_size};
+        int result = write_all_iov(dst_fd, &iov, 1);
+        free(buffer);
+        if (result < 0) {
+            close(dst_fd);
+            return fs_error("Erreur lors de l'écriture du fichier destination");
+        }
+    } else if (stream_inode_content(ctx, inode_index, dst_fd, &bytes_written) < 0) {
+        // Sinon, écrire directement depuis les blocs projetés
         close(dst_fd);
         return -1;  // L'erreur a déjà été affichée
     }
 
-    // Écrire le contenu dans le fichier de destination
-    ssize_t bytes_written = write(dst_fd, buffer, buffer_size);
-    if (bytes_written != buffer_size) {
+    close(dst_fd);
+
+    printf("Fichier '%s' copié avec succès vers '%s' (%lu octets)\n",
+           pignoufs_path, ext_path, (unsigned long) bytes_written);
+    return 0;
+}
+
+/**
+ * Réécrit un fichier de Pignoufs par morceaux depuis un descripteur (sources de plus de
+ * CP_BUFFER_MAX octets, qu'on ne lit pas d'un coup en mémoire)
+ * @param ctx Contexte du système de fichiers
+ * @param src_fd Descripteur du fichier source
+ * @param inode_index Index de l'inode destination
+ * @param copied Reçoit le nombre d'octets copiés
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+static int copy_fd_to_inode(fs_context_t *ctx, int src_fd, int inode_index, uint64_t *copied) {
+    char *buffer = malloc(INODE_WRITER_CHUNK);
+    if (!buffer) {
+        return fs_error("Erreur d'allocation mémoire pour le buffer");
+    }
+
+    inode_writer_t writer;
+    if (inode_writer_open(ctx, inode_index, &writer, INODE_WRITER_REPLACE) < 0) {
         free(buffer);
-        close(dst_fd);
-        return fs_error("Erreur lors de l'écriture dans le fichier destination");
+        return -1;
     }
 
-    // Libérer les ressources
-    free(buffer);
-    close(dst_fd);
+    int result = 0;
+    ssize_t bytes_read;
+    *copied = 0;
+    while ((bytes_read = read(src_fd, buffer, INODE_WRITER_CHUNK)) > 0) {
+        if (inode_writer_write(&writer, buffer, (uint32_t) bytes_read) < 0) {
+            result = -1;
+            break;
+        }
+        *copied += (uint64_t) bytes_read;
+    }
+    if (bytes_read < 0) {
+        result = fs_error("Erreur lors de la lecture du fichier source");
+    }
 
-    printf("Fichier '%s' copié avec succès vers '%s' (%u octets)\n",
-           pignoufs_path, ext_path, buffer_size);
-    return 0;
+    if (inode_writer_close(&writer) < 0) result = -1;
+    free(buffer);
+    return result;
 }
 
 /**
@@ -88,13 +140,36 @@ int copy_to_pignoufs(fs_context_t *ctx, const char *ext_path, const char *pignou
         return fs_error("Impossible d'ouvrir le fichier source '%s'", ext_path);
     }
 
-    // Créer ou réinitialiser le fichier destination dans Pignoufs
-    int inode_index = create_or_reset_file(ctx, pignoufs_path, 1);
+    // Ouvrir le fichier destination dans Pignoufs (ses blocs seront réutilisés) ou le créer
+    int inode_index = create_or_open_file(ctx, pignoufs_path);
     if (inode_index < 0) {
         close(src_fd);
         return -1;  // L'erreur a déjà été affichée
     }
 
+    // Grosse source : copie par morceaux, blocs réservés d'avance
+    if ((uint64_t) src_stat.st_size > CP_BUFFER_MAX) {
+        block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
+        uint64_t old_size = inode_block ? inode_size(get_inode(ctx->fs_map, inode_index)) : 0;
+        if (reserve_blocks(ctx, blocks_to_allocate(ctx, old_size, (uint64_t) src_stat.st_size)) < 0) {
+            release_reserved_blocks(ctx);
+            close(src_fd);
+            return fs_error("Espace insuffisant sur le système de fichiers");
+        }
+
+        uint64_t copied = 0;
+        int copy_result = copy_fd_to_inode(ctx, src_fd, inode_index, &copied);
+        release_reserved_blocks(ctx);
+        close(src_fd);
+        if (copy_result < 0) {
+            return -1;  // L'erreur a déjà été affichée
+        }
+
+        printf("Fichier '%s' copié avec succès vers '%s' (%lu octets)\n",
+               ext_path, pignoufs_path, (unsigned long) copied);
+        return 0;
+    }
+
     // Allouer un buffer pour lire le fichier source
     char *buffer = malloc(src_stat.st_size);
     if (!buffer && src_stat.st_size > 0) {
@@ -102,8 +177,13 @@ int copy_to_pignoufs(fs_context_t *ctx, const char *ext_path, const char *pignou
         return fs_error("Erreur d'allocation mémoire pour le buffer");
     }
 
-    // Lire le contenu du fichier source
-    ssize_t bytes_read = read(src_fd, buffer, src_stat.st_size);
+    // Lire le contenu du fichier source (read peut rendre moins que demandé)
+    ssize_t bytes_read = 0;
+    while (bytes_read < src_stat.st_size) {
+        ssize_t n = read(src_fd, buffer + bytes_read, (size_t) (src_stat.st_size - bytes_read));
+        if (n <= 0) break;
+        bytes_read += n;
+    }
     if (bytes_read != src_stat.st_size) {
         free(buffer);
         close(src_fd);
@@ -113,19 +193,41 @@ int copy_to_pignoufs(fs_context_t *ctx, const char *ext_path, const char *pignou
     // Fermer le fichier source
     close(src_fd);
 
-    // Écrire le contenu dans le fichier destination de Pignoufs
-    if (write_inode_content(ctx, inode_index, buffer, bytes_read, 0) < 0) {
+    block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
+    if (!inode_block || !verify_block_checksum(ctx, inode_block)) {
+        free(buffer);
+        return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
+    }
+    uint64_t old_size = inode_size(get_inode(ctx->fs_map, inode_index));
+
+    // Réserver d'un coup les blocs manquants (taille finale connue)
+    if (reserve_blocks(ctx, blocks_to_allocate(ctx, old_size, (uint32_t) bytes_read)) < 0) {
+        release_reserved_blocks(ctx);
+        free(buffer);
+        return fs_error("Espace insuffisant sur le système de fichiers");
+    }
+
+    // Fichier vide : blocs remplis en parallèle ; sinon réécriture sur place des blocs existants,
+    // seuls les blocs en plus ou en moins passent par la bitmap
+    int write_result = old_size == 0
+                       ? write_inode_content_threaded(ctx, inode_index, buffer, bytes_read, 0)
+                       : overwrite_inode_content(ctx, inode_index, buffer, (uint32_t) bytes_read);
+    release_reserved_blocks(ctx);
+    if (write_result < 0) {
         free(buffer);
         return -1;  // L'erreur a déjà été affichée
     }
 
-    // Mettre à jour le mode du fichier
-    block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
-    if (inode_block && verify_block_sha1(inode_block)) {
-        inode_t *inode = (inode_t *) inode_block->data;
+    // Mettre à jour le mode du fichier, sous le verrou du bloc d'inode (partagé avec ses voisins)
+    pthread_mutex_t *inode_lock = block_write_lock(ctx->fs_map, inode_block);
+    pthread_mutex_lock(inode_lock);
+    if (verify_block_checksum(ctx, inode_block)) {
+        inode_t *inode = get_inode(ctx->fs_map, inode_index);
         inode->mode = src_stat.st_mode & 0777;  // Copier les permissions du fichier source
-        compute_block_sha1(inode_block);
+        mark_block_dirty(ctx, inode_block);
+        fs_commit(ctx);
     }
+    pthread_mutex_unlock(inode_lock);
 
     // Libérer le buffer
     free(buffer);
@@ -6,6 +6,7 @@
 #include "../../include/fs_structs.h"
 #include "../../include/block_ops.h"
 #include "fs_common.h"
+#include "inode_summary.h"
 
 
 int cmd_df(const char *fsname) {
@@ -22,8 +23,21 @@ int cmd_df(const char *fsname) {
     printf("Nombre total de blocs : %d\n", superbloc->num_blocks);
     printf("Nombre de blocs libres : %d\n", superbloc->num_free_blocks);
     printf("Nombre maximal d'inodes : %d\n", superbloc->max_inodes);
+    printf("Somme de contrôle des blocs : %s\n", ctx.checksum->name);
     printf("Espace libre estimé : %d Ko\n", (superbloc->num_free_blocks * superbloc->block_size) / 1024);
 
+    // Fichiers et octets occupés, lus dans le résumé des inodes
+    uint32_t files = 0;
+    uint64_t bytes = 0;
+    summary_scan_t scan;
+    summary_scan_init(&scan, &ctx);
+    summary_entry_t entry;
+    while (summary_scan_next(&scan, &entry)) {
+        files++;
+        bytes += entry.size;
+    }
+    printf("Fichiers : %u (%lu octets)\n", files, (unsigned long) bytes);
+
     // Libérer les ressources
     fs_free_context(&ctx);
     return EXIT_SUCCESS;
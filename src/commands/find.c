@@ -6,40 +6,129 @@
 #include "../../include/fs_structs.h"
 #include "../../include/block_ops.h"
 #include "../../include/inode_ops.h"
+#include "../../include/inode_summary.h"
+#include "../../include/name_match.h"
+#include "../../include/trigram_index.h"
 #include <string.h>
-#include <ctype.h>
+
+// Inodes confiés à chaque unité de travail des threads de recherche
+#define FIND_INODES_PER_CHUNK 1024
+
+/**
+ * Fichiers trouvés dans une tranche d'inodes, affichés dans l'ordre des tranches
+ */
+typedef struct {
+    summary_entry_t *hits;
+    uint32_t count;
+    uint32_t capacity;
+    int error;                // Plus de mémoire pour garder les fichiers trouvés
+} find_chunk_t;
+
+typedef struct {
+    fs_context_t *ctx;
+    const name_matcher_t *matcher;
+    find_chunk_t *chunks;
+} find_work_t;
+
+/**
+ * Garde un fichier trouvé dans une tranche
+ * @return 0, -1 s'il n'y a plus de mémoire (chunk->error est alors posé)
+ */
+static int find_keep(find_chunk_t *chunk, const summary_entry_t *entry) {
+    if (chunk->count == chunk->capacity) {
+        uint32_t capacity = chunk->capacity ? chunk->capacity * 2 : 16;
+        summary_entry_t *hits = realloc(chunk->hits, capacity * sizeof(*hits));
+        if (!hits) {
+            chunk->error = 1;
+            return -1;
+        }
+        chunk->hits = hits;
+        chunk->capacity = capacity;
+    }
+    chunk->hits[chunk->count++] = *entry;
+    return 0;
+}
+
+/**
+ * Parcourt les tranches [first, last[ et garde les fichiers dont le nom correspond au motif
+ */
+static void find_range(void *arg, uint32_t first, uint32_t last) {
+    find_work_t *work = (find_work_t *) arg;
+
+    for (uint32_t c = first; c < last; c++) {
+        find_chunk_t *chunk = &work->chunks[c];
+        summary_scan_t scan;
+        summary_entry_t entry;
+
+        summary_scan_init_range(&scan, work->ctx, c * FIND_INODES_PER_CHUNK, (c + 1) * FIND_INODES_PER_CHUNK);
+        while (summary_scan_next(&scan, &entry)) {
+            if (name_matcher_match(work->matcher, entry.filename) && find_keep(chunk, &entry) < 0) break;
+        }
+    }
+}
 
 /**
- * Vérifie si une chaîne contient un motif
- * @param string Chaîne dans laquelle chercher
- * @param pattern Motif à rechercher
- * @return 1 si le motif est trouvé, 0 sinon
+ * Trigrammes que tout nom correspondant au motif contient : le motif entier (sous-chaîne ou
+ * préfixe), ou chaque suite de caractères ordinaires d'un motif glob
  */
-int contains_pattern(const char *string, const char *pattern) {
-    char haystack_lower[256];
-    char needle_lower[256];
-
-    // Copier et convertir string
-    ssize_t i = 0;
-    while (string[i] && i < 255) {
-        haystack_lower[i] = (char) tolower(string[i]);
-        i++;
+static void find_trigram_query(const name_matcher_t *matcher, trigram_query_t *query) {
+    if (matcher->mode != NAME_MATCH_GLOB) {
+        trigram_query_add(query, matcher->pattern, matcher->len);
+        return;
     }
-    haystack_lower[i] = '\0';
 
-    // Copier et convertir pattern
-    i = 0;
-    while (pattern[i] && i < 255) {
-        needle_lower[i] = (char) tolower(pattern[i]);
-        i++;
+    const char *p = matcher->pattern;
+    const char *literal = p;
+    while (*p) {
+        if (*p != '*' && *p != '?' && *p != '[' && *p != ']') {
+            p++;
+            continue;
+        }
+        trigram_query_add(query, literal, (size_t) (p - literal));
+
+        // Sauter une classe [...] fermée (mêmes règles que le motif : ']' juste après l'ouverture
+        // en fait partie) ; un '[' non fermé est ordinaire mais coupe simplement la suite
+        if (*p == '[') {
+            const char *end = p + 1;
+            if (*end == '!' || *end == '^') end++;
+            if (*end) end++;
+            while (*end && *end != ']') end++;
+            if (*end == ']') p = end;
+        }
+        literal = ++p;
     }
-    needle_lower[i] = '\0';
+    trigram_query_add(query, literal, (size_t) (p - literal));
+}
 
-    // Rechercher le motif
-    return strstr(haystack_lower, needle_lower) != NULL;
+typedef struct {
+    fs_context_t *ctx;
+    const name_matcher_t *matcher;
+    find_chunk_t *found;
+    block_t *block;           // Dernier bloc d'inodes vérifié
+    int block_ok;
+} find_candidates_t;
+
+/**
+ * Confirme un candidat de l'index des trigrammes par son nom dans l'inode
+ */
+static void find_candidate(void *arg, int inode_index) {
+    find_candidates_t *candidates = (find_candidates_t *) arg;
+    if (candidates->found->error) return;
+
+    block_t *block = get_inode_block(candidates->ctx->fs_map, inode_index);
+    if (block != candidates->block) {
+        candidates->block = block;
+        candidates->block_ok = verify_block_checksum(candidates->ctx, block);
+    }
+    inode_t *inode = get_inode(candidates->ctx->fs_map, inode_index);
+    if (!candidates->block_ok || !(inode->flags & PERM_EXISTS)) return;
+    if (!name_matcher_match(candidates->matcher, inode->filename)) return;
+
+    summary_entry_t entry = {inode_index, inode->filename, 0, inode->flags, inode_size(inode)};
+    find_keep(candidates->found, &entry);
 }
 
-int cmd_find(const char *fsname, const char *pattern) {
+int cmd_find(const char *fsname, const char *pattern, int mode) {
     fs_context_t ctx;
     int result = EXIT_SUCCESS;
     int found = 0;
@@ -48,38 +137,56 @@ int cmd_find(const char *fsname, const char *pattern) {
         return EXIT_FAILURE;
     }
 
-    printf("Recherche des fichiers contenant '%s'...\n", pattern);
+    printf("Recherche des fichiers %s '%s'...\n",
+           mode == NAME_MATCH_GLOB ? "correspondant à" : mode == NAME_MATCH_PREFIX ? "commençant par" : "contenant",
+           pattern);
 
-    // Parcourir tous les inodes
-    for (uint32_t i = 0; i < ctx.sb->max_inodes; i++) {
-        block_t *inode_block = get_inode_block(ctx.fs_map, (int) i);
-        if (!inode_block) {
-            continue;
-        }
+    // Motif préparé une fois pour tous les noms
+    name_matcher_t matcher;
+    name_matcher_init(&matcher, pattern, (name_match_mode_t) mode);
 
-        if (!verify_block_sha1(inode_block)) {
-            fs_error("Attention: Le bloc d'inode %d est corrompu\n", i);
-            continue;
+    // Avec l'index des trigrammes, seuls les noms présents dans toutes les listes du motif sont
+    // comparés ; sinon (motif sans trigramme, index absent ou corrompu), parcours de tous les noms
+    trigram_query_t query = {{0}, 0};
+    find_trigram_query(&matcher, &query);
+    find_chunk_t indexed = {NULL, 0, 0, 0};
+    find_candidates_t candidates = {&ctx, &matcher, &indexed, NULL, 0};
+
+    find_chunk_t *chunks = &indexed;
+    uint32_t chunk_count = 1;
+    if (query.count == 0 || trigram_index_search(&ctx, &query, find_candidate, &candidates) < 0) {
+        // Tranches d'inodes parcourues en parallèle (par le résumé des inodes)
+        free(indexed.hits);
+        chunk_count = (ctx.sb->max_inodes + FIND_INODES_PER_CHUNK - 1) / FIND_INODES_PER_CHUNK;
+        chunks = calloc(chunk_count ? chunk_count : 1, sizeof(find_chunk_t));
+        if (!chunks) {
+            fs_error("Erreur d'allocation mémoire");
+            fs_free_context(&ctx);
+            return EXIT_FAILURE;
         }
 
-        inode_t *inode = (inode_t *) (inode_block->data);
+        find_work_t work = {&ctx, &matcher, chunks};
+        run_io_ranges(chunk_count, io_thread_count(chunk_count), find_range, &work);
+    }
 
-        // Vérifier que l'inode correspond à un fichier existant
-        if (!(inode->flags & PERM_EXISTS)) {
-            continue;
+    for (uint32_t c = 0; c < chunk_count; c++) {
+        if (chunks[c].error) {
+            fs_error("Erreur d'allocation mémoire");
+            result = EXIT_FAILURE;
         }
-
-        // Vérifier si le nom du fichier contient le motif recherché
-        if (contains_pattern(inode->filename, pattern)) {
-            printf("Trouvé: %-20s Taille: %-8u Permissions: %c%c%c\n",
-                   inode->filename,
-                   inode->size,
-                   (inode->flags & PERM_READ) ? 'r' : '-',
-                   (inode->flags & PERM_WRITE) ? 'w' : '-',
-                   (inode->flags & PERM_DIR) ? 'd' : '-');
+        for (uint32_t i = 0; i < chunks[c].count; i++) {
+            summary_entry_t *entry = &chunks[c].hits[i];
+            printf("Trouvé: %-20s Taille: %-8lu Permissions: %c%c%c\n",
+                   entry->filename,
+                   (unsigned long) entry->size,
+                   (entry->flags & PERM_READ) ? 'r' : '-',
+                   (entry->flags & PERM_WRITE) ? 'w' : '-',
+                   (entry->flags & PERM_DIR) ? 'd' : '-');
             found++;
         }
+        free(chunks[c].hits);
     }
+    if (chunks != &indexed) free(chunks);
 
     if (found == 0) {
         printf("Aucun fichier correspondant au motif '%s' n'a été trouvé.\n", pattern);
@@ -90,4 +197,4 @@ int cmd_find(const char *fsname, const char *pattern) {
     // Libérer les ressources
     fs_free_context(&ctx);
     return result;
-}
\ No newline at end of file
+}
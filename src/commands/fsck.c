@@ -1,7 +1,12 @@
 #include "../../include/fs_common.h"
 #include "../../include/block_ops.h"
+#include "../../include/name_index.h"
+#include "../../include/inode_ops.h"
+#include "../../include/inode_summary.h"
+#include "../../include/trigram_index.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /// 1. Vérifie le magic number
 int check_magic(superblock_t *sb) {
@@ -12,14 +17,27 @@ int check_magic(superblock_t *sb) {
     return 0;
 }
 
-/// 2. Vérifie les SHA1 de tous les blocs
+/// 2. Vérifie les sommes de contrôle de tous les blocs
 int check_sha1_all_blocks(fs_context_t *ctx) {
     int res = 0;
-    for (uint32_t i = 0; i < ctx->sb->num_blocks; i++) {
-        block_t *blk = get_block(ctx->fs_map, (int) i);
-        if (!verify_block_sha1(blk)) {
-            fs_error("Corruption SHA1 dans le bloc %u.\n", i);
-            res = -1;
+    block_t *batch[CHECKSUM_BATCH];
+    uint8_t valid[CHECKSUM_BATCH];
+
+    // Vérification par lots de blocs consécutifs (moteur multi-buffer)
+    for (uint32_t first = 0; first < ctx->sb->num_blocks; first += CHECKSUM_BATCH) {
+        uint32_t n = ctx->sb->num_blocks - first;
+        if (n > CHECKSUM_BATCH) n = CHECKSUM_BATCH;
+
+        for (uint32_t i = 0; i < n; i++) {
+            batch[i] = get_block(ctx->fs_map, (first + i));
+        }
+        if (checksum_blocks_verify(ctx->checksum, batch, n, valid, ctx->data_size) == 0) continue;
+
+        for (uint32_t i = 0; i < n; i++) {
+            if (!valid[i]) {
+                fs_error("Corruption de la somme de contrôle dans le bloc %u.\n", first + i);
+                res = -1;
+            }
         }
     }
     return res;
@@ -30,19 +48,52 @@ int check_block_types(fs_context_t *ctx) {
     int res = 0;
     uint32_t nbb = ctx->sb->num_blocks;
 
+    // Fin de la zone bitmap : début de la première zone qui la suit
+    uint32_t bitmap_end = ctx->sb->inode_start;
+    uint32_t index_end = ctx->sb->name_index_start + ctx->sb->name_index_blocks;
+    uint32_t inode_bitmap_end = ctx->sb->inode_bitmap_start + ctx->sb->inode_bitmap_blocks;
+    uint32_t summary_end = ctx->sb->summary_start + ctx->sb->summary_blocks;
+    uint32_t trigram_end = ctx->sb->trigram_start + ctx->sb->trigram_blocks;
+    if (ctx->sb->features & FS_FEATURE_NAME_INDEX) {
+        bitmap_end = ctx->sb->name_index_start;
+    }
+    if (ctx->sb->features & FS_FEATURE_INODE_BITMAP) {
+        bitmap_end = ctx->sb->inode_bitmap_start;
+    }
+
     for (uint32_t i = 0; i < nbb; i++) {
-        block_t *blk = get_block(ctx->fs_map, (int) i);
+        block_t *blk = get_block(ctx->fs_map, i);
         if (!blk) continue;
-        uint32_t type = blk->type;
+        uint32_t type = BLOCK_META(ctx, blk)->type;
 
         if (i == 0 && type != BLOCK_TYPE_SUPERBLOCK) {
             fs_error("Bloc %u : attendu superbloc.\n", i);
             res = -1;
 
-        } else if (i >= ctx->sb->bitmap_start && i < ctx->sb->inode_start && type != BLOCK_TYPE_BITMAP) {
+        } else if (i >= ctx->sb->bitmap_start && i < bitmap_end && type != BLOCK_TYPE_BITMAP) {
             fs_error("Bloc %u : attendu bitmap.\n", i);
             res = -1;
 
+        } else if ((ctx->sb->features & FS_FEATURE_INODE_BITMAP)
+                   && i >= ctx->sb->inode_bitmap_start && i < inode_bitmap_end && type != BLOCK_TYPE_INODE_BITMAP) {
+            fs_error("Bloc %u : attendu bitmap des inodes.\n", i);
+            res = -1;
+
+        } else if ((ctx->sb->features & FS_FEATURE_NAME_INDEX)
+                   && i >= ctx->sb->name_index_start && i < index_end && type != BLOCK_TYPE_NAME_INDEX) {
+            fs_error("Bloc %u : attendu index des noms.\n", i);
+            res = -1;
+
+        } else if ((ctx->sb->features & FS_FEATURE_INODE_SUMMARY)
+                   && i >= ctx->sb->summary_start && i < summary_end && type != BLOCK_TYPE_INODE_SUMMARY) {
+            fs_error("Bloc %u : attendu résumé des inodes.\n", i);
+            res = -1;
+
+        } else if ((ctx->sb->features & FS_FEATURE_TRIGRAM_INDEX)
+                   && i >= ctx->sb->trigram_start && i < trigram_end && type != BLOCK_TYPE_TRIGRAM_INDEX) {
+            fs_error("Bloc %u : attendu index des trigrammes.\n", i);
+            res = -1;
+
         } else if (i >= ctx->sb->inode_start && i < ctx->sb->data_start) {
             if (type != BLOCK_TYPE_INODE && type != 0) { // inode ou libre
                 fs_error("Bloc %u : attendu inode ou libre (type=%u).\n", i, type);
@@ -60,28 +111,30 @@ int check_block_types(fs_context_t *ctx) {
 }
 
 int is_block_free(fs_context_t *ctx, uint32_t i) {
-    uint8_t *bitmap = (uint8_t *) ((char *) ctx->fs_map + ctx->sb->bitmap_start * BLOCK_SIZE);
-    return !(bitmap[i / 8] & (1 << (i % 8)));
+    return !is_block_used(ctx->fs_map, i);
 }
 
+/// 4. Vérifie que la bitmap (tous ses blocs) correspond aux compteurs du superbloc
 int check_bitmap_coherence(fs_context_t *ctx) {
-    block_t *bitmap_block = get_block(ctx->fs_map, (int) ctx->sb->bitmap_start);
-    if (!bitmap_block || !verify_block_sha1(bitmap_block)) {
-        fs_error("Erreur : bloc bitmap invalide\n");
-        return -1;
-    }
-
-    unsigned char *bitmap = bitmap_block->data;
+    uint32_t bitmap_blocks = (ctx->sb->num_blocks + BITMAP_BITS_PER_BLOCK - 1) / BITMAP_BITS_PER_BLOCK;
     uint32_t count = 0;
+    int res = 0;
 
-    // On doit parcourir TOUS les blocs (du bloc 0 à num_blocks - 1)
-    for (uint32_t i = 0; i < ctx->sb->num_blocks; i++) {
-        int byte = (int) i / 8;
-        int bit = (int) i % 8;
+    for (uint32_t b = 0; b < bitmap_blocks; b++) {
+        block_t *bitmap_block = get_block(ctx->fs_map, (ctx->sb->bitmap_start + b));
+        if (!bitmap_block || !verify_block_checksum(ctx, bitmap_block)) {
+            fs_error("Erreur : bloc bitmap %u invalide\n", b);
+            return -1;
+        }
+
+        // Bits à 0 → blocs libres (les bits au-delà du dernier bloc sont ignorés)
+        uint32_t block_free = count_free_in_bitmap_block(ctx->fs_map, b);
+        count += block_free;
 
-        // Si le bit est à 0 → bloc libre
-        if ((bitmap[byte] & (1 << bit)) == 0) {
-            count++;
+        if ((ctx->sb->features & FS_FEATURE_ALLOC_SUMMARY) && ctx->sb->bitmap_free[b] != block_free) {
+            fs_error("Incohérence bitmap %u : résumé %u libres, trouvé %u\n",
+                     b, ctx->sb->bitmap_free[b], block_free);
+            res = -1;
         }
     }
 
@@ -91,19 +144,147 @@ int check_bitmap_coherence(fs_context_t *ctx) {
         return -1;
     }
 
-    return 0;
+    return res;
 }
 
 
 /// 5. Réinitialise les verrous dans tous les blocs
 void reset_all_locks(fs_context_t *ctx) {
     for (uint32_t i = 0; i < ctx->sb->num_blocks; i++) {
-        block_t *blk = get_block(ctx->fs_map, (int) i);
-        memset(blk->lock_read, 0, LOCK_SIZE);
-        memset(blk->lock_write, 0, LOCK_SIZE);
+        block_t *blk = get_block(ctx->fs_map, i);
+        uint32_t generation = *BLOCK_GENERATION(BLOCK_META(ctx, blk));
+        memset(block_read_lock(ctx->fs_map, blk), 0, LOCK_SIZE);
+        memset(block_write_lock(ctx->fs_map, blk), 0, LOCK_SIZE);
+        *BLOCK_GENERATION(BLOCK_META(ctx, blk)) = generation + 1;  // Les caches de vérification repartent de zéro
     }
 }
 
+/// 6. Vérifie l'index des noms et le reconstruit s'il est incohérent
+int check_name_index(fs_context_t *ctx) {
+    if (!(ctx->sb->features & FS_FEATURE_NAME_INDEX)) return 0;
+
+    if (name_index_check(ctx->fs_map) == 0) return 0;
+
+    printf("Index des noms incohérent, reconstruction...\n");
+    if (name_index_rebuild(ctx) < 0) {
+        fs_error("Erreur : impossible de reconstruire l'index des noms\n");
+        return -1;
+    }
+    return 0;
+}
+
+/// 6 bis. Vérifie le résumé des inodes et le reconstruit s'il est incohérent (le tas est compacté)
+int check_inode_summary(fs_context_t *ctx) {
+    if (!(ctx->sb->features & FS_FEATURE_INODE_SUMMARY)) return 0;
+
+    if (inode_summary_check(ctx) == 0) return 0;
+
+    printf("Résumé des inodes incohérent, reconstruction...\n");
+    if (inode_summary_rebuild(ctx) < 0) {
+        fs_error("Erreur : impossible de reconstruire le résumé des inodes\n");
+        return -1;
+    }
+    return 0;
+}
+
+/// 6 ter. Vérifie l'index des trigrammes et le reconstruit s'il est incohérent
+int check_trigram_index(fs_context_t *ctx) {
+    if (!(ctx->sb->features & FS_FEATURE_TRIGRAM_INDEX)) return 0;
+
+    if (trigram_index_check(ctx) == 0) return 0;
+
+    printf("Index des trigrammes incohérent, reconstruction...\n");
+    if (trigram_index_rebuild(ctx) < 0) {
+        fs_error("Erreur : impossible de reconstruire l'index des trigrammes\n");
+        return -1;
+    }
+    return 0;
+}
+
+/// 7. Vérifie la bitmap des inodes et la resynchronise avec la table des inodes
+void check_inode_bitmap(fs_context_t *ctx) {
+    if (!(ctx->sb->features & FS_FEATURE_INODE_BITMAP)) return;
+
+    uint32_t mismatches = sync_inode_bitmap(ctx, 1);
+    if (mismatches == 0) return;
+
+    printf("Bitmap des inodes incohérente (%u inodes), resynchronisation...\n", mismatches);
+    sync_inode_bitmap(ctx, 0);
+}
+
+/// État du parcours des arbres de blocs (blocs déjà référencés par un fichier)
+typedef struct {
+    fs_context_t *ctx;
+    uint8_t *seen;
+    int inode_index;
+    int errors;
+} tree_check_t;
+
+static void check_tree_block(void *arg, uint32_t block_num, int indirect) {
+    tree_check_t *check = (tree_check_t *) arg;
+    fs_context_t *ctx = check->ctx;
+
+    if (block_num < ctx->sb->data_start || block_num >= ctx->sb->num_blocks) {
+        fs_error("Inode %d : bloc %u hors de la zone de données.\n", check->inode_index, block_num);
+        check->errors++;
+        return;
+    }
+    if (check->seen[block_num / 8] & (1 << (block_num % 8))) {
+        fs_error("Inode %d : bloc %u référencé plusieurs fois.\n", check->inode_index, block_num);
+        check->errors++;
+    }
+    check->seen[block_num / 8] |= (uint8_t) (1 << (block_num % 8));
+
+    if (!is_block_used(ctx->fs_map, block_num)) {
+        fs_error("Inode %d : bloc %u marqué libre dans la bitmap.\n", check->inode_index, block_num);
+        check->errors++;
+    }
+    uint32_t type = BLOCK_META(ctx, get_block(ctx->fs_map, block_num))->type;
+    if (type != (indirect ? BLOCK_TYPE_INDIRECT : BLOCK_TYPE_DATA)) {
+        fs_error("Inode %d : bloc %u de type %u inattendu.\n", check->inode_index, block_num, type);
+        check->errors++;
+    }
+}
+
+/// 8. Vérifie les arbres de blocs (directs, simple, double et triple indirection) de chaque fichier
+int check_inode_trees(fs_context_t *ctx) {
+    tree_check_t check = {ctx, calloc(ctx->sb->num_blocks / 8 + 1, 1), 0, 0};
+    if (!check.seen) {
+        fs_error("Erreur d'allocation mémoire\n");
+        return -1;
+    }
+
+    // Les blocs d'inodes corrompus sont déjà signalés
+    inode_scan_t scan;
+    inode_scan_init(&scan, ctx, 0);
+    inode_t *inode;
+    int i;
+    while ((inode = inode_scan_next(&scan, &i)) != NULL) {
+        check.inode_index = i;
+        int64_t blocks = block_map_walk(ctx, inode, check_tree_block, &check);
+        uint64_t expected = (inode_size(inode) + ctx->data_size - 1) / ctx->data_size;
+        if (inode->flags & PERM_INLINE) {
+            expected = 0;  // Contenu dans le bloc d'inode
+            if (inode_size(inode) > inode_inline_capacity(ctx)) {
+                fs_error("Inode %d : %llu octets dans l'inode pour %u au plus.\n", i,
+                         (unsigned long long) inode_size(inode), inode_inline_capacity(ctx));
+                check.errors++;
+            }
+        }
+        if (blocks < 0) {
+            fs_error("Inode %d : bloc d'indirection illisible.\n", i);
+            check.errors++;
+        } else if ((uint64_t) blocks != expected) {
+            fs_error("Inode %d : %lld blocs de données pour %llu attendus.\n", i,
+                     (long long) blocks, (unsigned long long) expected);
+            check.errors++;
+        }
+    }
+
+    free(check.seen);
+    return check.errors ? -1 : 0;
+}
+
 /// Entrée principale
 int cmd_fsck(const char *fsname) {
 
@@ -119,6 +300,11 @@ int cmd_fsck(const char *fsname) {
     if (check_sha1_all_blocks(&ctx) < 0) status = -1;
     if (check_block_types(&ctx) < 0) status = -1;
     if (check_bitmap_coherence(&ctx) < 0) status = -1;
+    if (check_name_index(&ctx) < 0) status = -1;
+    if (check_inode_summary(&ctx) < 0) status = -1;
+    if (check_trigram_index(&ctx) < 0) status = -1;
+    if (check_inode_trees(&ctx) < 0) status = -1;
+    check_inode_bitmap(&ctx);
 
     reset_all_locks(&ctx);
 
@@ -11,9 +11,9 @@
 int cmd_input(const char *fsname, const char *filename) {
     fs_context_t ctx;
     char *buffer = NULL;
-    uint32_t buffer_size = DATA_SIZE;
+    uint32_t buffer_size = INODE_WRITER_CHUNK;
 
-    // Allouer un buffer pour lire l'entrée standard
+    // Allouer un buffer pour lire l'entrée standard par gros morceaux
     buffer = malloc(buffer_size);
     if (!buffer) {
         return fs_error("Erreur d'allocation mémoire");
@@ -29,38 +29,61 @@ int cmd_input(const char *fsname, const char *filename) {
         filename += 2;
     }
 
-    // Créer ou réinitialiser le fichier
-    int inode_index = create_or_reset_file(&ctx, filename, 1);
+    // Ouvrir le fichier (ses blocs seront réécrits sur place) ou le créer
+    int inode_index = create_or_open_file(&ctx, filename);
     if (inode_index < 0) {
         free(buffer);
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
 
-    // Lire l'entrée standard et écrire dans le fichier
+    // Si l'entrée standard est un fichier régulier, la taille finale est connue :
+    // réserver d'un coup les blocs qui manquent à l'ancien contenu
+    struct stat st;
+    block_t *inode_block = get_inode_block(ctx.fs_map, inode_index);
+    if (inode_block && fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode)) {
+        uint64_t old_size = inode_size(get_inode(ctx.fs_map, inode_index));
+        off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+        off_t remaining_input = st.st_size - (offset > 0 ? offset : 0);
+        if (remaining_input > 0 && reserve_blocks(&ctx, blocks_to_allocate(&ctx, old_size, (uint64_t) remaining_input)) < 0) {
+            release_reserved_blocks(&ctx);
+        }
+    }
+
+    // Lire l'entrée standard et écrire dans le fichier, par-dessus l'ancien contenu
+    // (verrous et bloc d'indirection gardés d'un morceau à l'autre, fin coupée à la fermeture)
+    inode_writer_t writer;
+    if (inode_writer_open(&ctx, inode_index, &writer, INODE_WRITER_REPLACE) < 0) {
+        free(buffer);
+        fs_free_context(&ctx);
+        return EXIT_FAILURE;
+    }
+
     ssize_t total_bytes = 0;
     ssize_t bytes_read;
-    int append = 0;  // Premier écrit en mode écrasement
+    int result = 0;
 
     // Boucle pour lire l'entrée standard
     while ((bytes_read = read(STDIN_FILENO, buffer, buffer_size)) > 0) {
-        if (write_inode_content(&ctx, inode_index, buffer, bytes_read, append) < 0) {
-            fs_error("Erreur lors de l'écriture dans le fichier '%s'", filename);
-            free(buffer);
-            fs_free_context(&ctx);
-            return EXIT_FAILURE;
+        if (inode_writer_write(&writer, buffer, (uint32_t) bytes_read) < 0) {
+            result = fs_error("Erreur lors de l'écriture dans le fichier '%s'", filename);
+            break;
         }
         total_bytes += bytes_read;
-        append = 1;  // Les écritures suivantes sont en mode ajout
     }
 
     if (bytes_read < 0) {
-        fs_error("Erreur lors de la lecture de l'entrée standard");
+        result = fs_error("Erreur lors de la lecture de l'entrée standard");
+    }
+
+    if (inode_writer_close(&writer) < 0 || result < 0) {
         free(buffer);
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
 
+    release_reserved_blocks(&ctx);
+
     printf("Données écrites avec succès dans '%s' (%zu octets)\n", filename, total_bytes);
 
     // Libérer les ressources
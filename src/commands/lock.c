@@ -37,13 +37,13 @@ int cmd_lock(const char *fsname, const char *filename, const char *mode) {
     }
 
     block_t *inode_block = get_inode_block(ctx.fs_map, inode_index);
-    if (!inode_block || !verify_block_sha1(inode_block)) {
+    if (!inode_block || !verify_block_checksum(&ctx, inode_block)) {
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
 
-    pthread_mutex_t *mutex = strcmp(mode, "w") == 0 ? (pthread_mutex_t *) inode_block->lock_write
-                                                    : (pthread_mutex_t *) inode_block->lock_read;
+    pthread_mutex_t *mutex = strcmp(mode, "w") == 0 ? block_write_lock(ctx.fs_map, inode_block)
+                                                    : block_read_lock(ctx.fs_map, inode_block);
 
     // 4. Préparer le signal handler
     global_mutex = mutex;
@@ -2,6 +2,8 @@
 #include "../../include/fs_structs.h"
 #include "../../include/block_ops.h"
 #include "../../include/inode_ops.h"
+#include "../../include/inode_summary.h"
+#include "../../include/name_index.h"
 
 int cmd_ls(const char *fsname, int argc, char **argv) {
     int detailed = 0;      // 0 = affichage simple, 1 = affichage détaillé
@@ -24,37 +26,25 @@ int cmd_ls(const char *fsname, int argc, char **argv) {
     }
 
     int found = 0;
+    uint32_t target_hash = target_name ? name_hash(target_name) : 0;
 
-    // Parcourir tous les inodes
-    for (uint32_t i = 0; i < ctx.sb->max_inodes; i++) {
-        block_t *inode_block = get_inode_block(ctx.fs_map, (int) i);
-        if (!inode_block) {
-            continue;
-        }
-
-        if (!verify_block_sha1(inode_block)) {
-            fs_error("Erreur: Le bloc d'inode %d est corrompu\n", i);
-            continue;
-        }
-
-        inode_t *inode = (inode_t *) (inode_block->data);
-
-        // Afficher uniquement les inodes existants
-        if (!(inode->flags & PERM_EXISTS)) {
-            continue;
-        }
+    // Parcourir les fichiers existants par le résumé des inodes (la table des inodes n'est pas lue)
+    summary_scan_t scan;
+    summary_scan_init(&scan, &ctx);
+    summary_entry_t entry;
+    while (summary_scan_next(&scan, &entry)) {
 
-        // Si un nom cible est spécifié, ne montrer que ce fichier
-        if (!target_name || strcmp(inode->filename, target_name) == 0) {
+        // Si un nom cible est spécifié, ne montrer que ce fichier (empreinte comparée d'abord)
+        if (!target_name || (entry.hash == target_hash && strcmp(entry.filename, target_name) == 0)) {
             if (detailed) {
-                printf("%-20s Taille: %-8u Permissions: %c%c%c\n",
-                       inode->filename,
-                       inode->size,
-                       (inode->flags & PERM_READ) ? 'r' : '-',
-                       (inode->flags & PERM_WRITE) ? 'w' : '-',
-                       (inode->flags & PERM_DIR) ? 'd' : '-');
+                printf("%-20s Taille: %-8lu Permissions: %c%c%c\n",
+                       entry.filename,
+                       (unsigned long) entry.size,
+                       (entry.flags & PERM_READ) ? 'r' : '-',
+                       (entry.flags & PERM_WRITE) ? 'w' : '-',
+                       (entry.flags & PERM_DIR) ? 'd' : '-');
             } else {
-                printf("%s\n", inode->filename);
+                printf("%s\n", entry.filename);
             }
             found = 1;
             if (target_name) break; // si on cherchait un seul fichier, stop
@@ -5,24 +5,85 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <sys/mman.h>
+#include <time.h>
 #include "pignoufs.h"
 #include "fs_structs.h"
 #include "block_ops.h"
 #include "fs_common.h"
+#include "name_index.h"
+#include "inode_ops.h"
+#include "inode_summary.h"
+#include "trigram_index.h"
+
+/**
+ * Tire l'identifiant aléatoire du conteneur
+ */
+static uint32_t random_fs_id(void) {
+    uint32_t id = 0;
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd >= 0) {
+        if (read(fd, &id, sizeof(id)) != sizeof(id)) id = 0;
+        close(fd);
+    }
+    if (id == 0) id = (uint32_t) time(NULL) ^ (uint32_t) getpid();
+    return id;
+}
 
-void init_block_lock(block_t *block) {
+void init_block_lock(void *fs_map, block_t *block) {
     pthread_mutexattr_t attr;
     pthread_mutexattr_init(&attr);
     pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-    pthread_mutex_init((pthread_mutex_t *) block->lock_read, &attr);
-    pthread_mutex_init((pthread_mutex_t *) block->lock_write, &attr);
+    pthread_mutex_init(block_read_lock(fs_map, block), &attr);
+    pthread_mutex_init(block_write_lock(fs_map, block), &attr);
     pthread_mutexattr_destroy(&attr);
 }
 
 
-int cmd_mkfs(const char *fsname, int nb_inode, int nb_block) {
-    int bitmap_blocks = ((nb_inode + nb_block) / (BLOCK_SIZE * 8)) + 1;
-    int nbb = 1 + bitmap_blocks + nb_inode + nb_block; // Nombre total de blocs
+int cmd_mkfs(const char *fsname, uint32_t nb_inode, uint32_t nb_block, const char *checksum_name,
+             uint32_t block_size, int packed_inodes, int trigram_index) {
+    // Format v2 : blocs de block_size octets commençant chacun sur une page, données suivies de
+    // l'en-tête du bloc (somme, type, verrou de lecture), verrous d'écriture dans une table après
+    // les blocs ; format v1 : blocs de BLOCK_SIZE octets. Les données d'un bloc v2 ne remplissent
+    // pas la page et les sommes restent dans chaque bloc (pas de table de métadonnées à part)
+    int page_blocks = block_size != BLOCK_SIZE;
+    if (page_blocks && (block_size % PAGE_BLOCK_SIZE != 0 || block_size == 0 || block_size > MAX_BLOCK_SIZE)) {
+        fs_error("Taille de bloc invalide (%u) : multiple de %d jusqu'à %d", block_size, PAGE_BLOCK_SIZE,
+                 MAX_BLOCK_SIZE);
+        return EXIT_FAILURE;
+    }
+    uint32_t data_size = page_blocks ? block_size - BLOCK_META_SIZE : DATA_SIZE;
+
+    // Table compacte : une place de PACKED_INODE_SLOT octets par inode (8 par bloc de 4k)
+    uint32_t per_block = packed_inodes ? data_size / PACKED_INODE_SLOT : 1;
+    uint32_t inode_blocks = (uint32_t) (((uint64_t) nb_inode + per_block - 1) / per_block);
+
+    uint32_t index_blocks = name_index_blocks_for(nb_inode);
+    uint32_t inode_bitmap_blocks = inode_bitmap_blocks_for(nb_inode);
+    uint32_t summary_blocks = inode_summary_blocks_for(nb_inode);
+    uint32_t trigram_blocks = trigram_index ? trigram_index_blocks_for(nb_inode) : 0;
+    uint64_t meta_blocks = (uint64_t) inode_bitmap_blocks + index_blocks + summary_blocks + trigram_blocks;
+    // Chaque bloc de bitmap suit DATA_SIZE * 8 blocs, y compris les blocs de bitmap eux-mêmes
+    // (les blocs de métadonnées gardent ce format quelle que soit la taille des blocs)
+    // Calculs sur 64 bits : les numéros de blocs doivent tenir sur 32 bits, pas leur somme intermédiaire
+    uint64_t other_blocks = 1 + meta_blocks + inode_blocks + nb_block;
+    uint64_t bitmap_blocks = (other_blocks + BITMAP_BITS_PER_BLOCK - 2) / (BITMAP_BITS_PER_BLOCK - 1);
+    uint64_t total_blocks = bitmap_blocks + other_blocks;
+
+    const checksum_ops_t *checksum = checksum_ops_by_name(checksum_name ? checksum_name : "sha1");
+    if (!checksum) {
+        fs_error("Somme de contrôle inconnue '%s' (sha1, crc32c ou xxh64)", checksum_name);
+        return EXIT_FAILURE;
+    }
+
+    if (bitmap_blocks > SB_MAX_BITMAP_BLOCKS || total_blocks > UINT32_MAX) {
+        fs_error("Système de fichiers trop grand (%lu blocs de bitmap, maximum %d)", (unsigned long) bitmap_blocks,
+                 SB_MAX_BITMAP_BLOCKS);
+        return EXIT_FAILURE;
+    }
+    uint32_t nbb = (uint32_t) total_blocks; // Nombre total de blocs
+
+    size_t stride = block_size;
+    size_t fs_size = (size_t) nbb * stride + (page_blocks ? (size_t) nbb * LOCK_SIZE : 0);
 
     int fd = open(fsname, O_RDWR | O_CREAT | O_TRUNC, 0666);
     if (fd < 0) {
@@ -30,13 +91,13 @@ int cmd_mkfs(const char *fsname, int nb_inode, int nb_block) {
         return EXIT_FAILURE;
     }
 
-    if (ftruncate(fd, nbb * BLOCK_SIZE) < 0) {
+    if (ftruncate(fd, (off_t) fs_size) < 0) {
         fs_error("Erreur lors de l'ajustement de la taille du fichier conteneur");
         close(fd);
         return EXIT_FAILURE;
     }
 
-    void *fs_map = mmap(NULL, nbb * BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void *fs_map = mmap(NULL, fs_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (fs_map == MAP_FAILED) {
         fs_error("Erreur lors de la projection mémoire");
         close(fd);
@@ -46,92 +107,175 @@ int cmd_mkfs(const char *fsname, int nb_inode, int nb_block) {
     // Initialisation du superbloc
     block_t *superbloc_block = (block_t *) fs_map;
     // 1. Nettoyer tout le bloc (important)
-    memset(superbloc_block, 0, sizeof(block_t));
+    memset(superbloc_block, 0, stride);
 
     // 2. Remplir le DATA : écrire magic, block_size, num_blocks, ...
     superblock_t *superbloc = (superblock_t *) (superbloc_block->data);
     memset(superbloc, 0, sizeof(superblock_t));
     memcpy(superbloc->magic, "pignoufs", 8);
-    superbloc->block_size = BLOCK_SIZE;
+    superbloc->block_size = (uint32_t) stride;
     superbloc->num_blocks = nbb;
     superbloc->num_free_blocks = nb_block;
     superbloc->bitmap_start = 1;
-    superbloc->inode_start = 1 + bitmap_blocks;
-    superbloc->data_start = superbloc->inode_start + nb_inode;
+    superbloc->inode_bitmap_start = 1 + bitmap_blocks;
+    superbloc->inode_bitmap_blocks = inode_bitmap_blocks;
+    superbloc->name_index_start = superbloc->inode_bitmap_start + inode_bitmap_blocks;
+    superbloc->name_index_blocks = index_blocks;
+    superbloc->summary_start = superbloc->name_index_start + index_blocks;
+    superbloc->summary_blocks = summary_blocks;
+    superbloc->trigram_start = superbloc->summary_start + summary_blocks;
+    superbloc->trigram_blocks = trigram_blocks;
+    superbloc->inode_start = superbloc->trigram_start + trigram_blocks;
+    superbloc->data_start = superbloc->inode_start + inode_blocks;
     superbloc->max_inodes = nb_inode;
+    superbloc->features = FS_FEATURE_NAME_INDEX | FS_FEATURE_INODE_BITMAP | FS_FEATURE_ALLOC_SUMMARY
+                          | FS_FEATURE_LARGE_FILES | FS_FEATURE_INLINE_DATA | (page_blocks ? FS_FEATURE_PAGE_BLOCKS : 0)
+                          | FS_FEATURE_INODE_SUMMARY | (per_block > 1 ? FS_FEATURE_PACKED_INODES : 0)
+                          | (trigram_index ? FS_FEATURE_TRIGRAM_INDEX : 0);
+    superbloc->inodes_per_block = per_block;
+    superbloc->alloc_cursor = superbloc->data_start;
+    superbloc->checksum_algo = checksum->id;
+    superbloc->data_size = data_size;
+    superbloc->fs_id = random_fs_id();
+
+    // Compteur de blocs libres de chaque bloc de bitmap : intersection avec [data_start, nbb[
+    for (uint32_t i = 0; i < bitmap_blocks; i++) {
+        uint64_t first = (uint64_t) i * BITMAP_BITS_PER_BLOCK;
+        uint64_t last = first + BITMAP_BITS_PER_BLOCK;
+        if (first < superbloc->data_start) first = superbloc->data_start;
+        if (last > nbb) last = nbb;
+        superbloc->bitmap_free[i] = last > first ? (uint32_t) (last - first) : 0;
+    }
 
-    init_block_lock(superbloc_block);
+    init_block_lock(fs_map, superbloc_block);
 
-    unsigned char sha1[20];
-    SHA1(superbloc_block->data, 4000, sha1);
-    memcpy(superbloc_block->sha1, sha1, 20);
+    checksum_block_compute(checksum, superbloc_block, data_size);
 
     // 4. Puis mettre type = 1
-    superbloc_block->type = 1;
+    block_meta(superbloc_block, data_size)->type = 1;
 
 
 
     // Initialiser les bitmaps
-    char *bitmap_area = (char *) (fs_map + BLOCK_SIZE);
-    memset(bitmap_area, 0, bitmap_blocks * BLOCK_SIZE);
+    // Les blocs 0 à (superbloc + bitmaps + index + inodes) sont alloués, ainsi que les bits
+    // au-delà du dernier bloc pour que l'allocateur ne les propose jamais
+    for (uint32_t i = 0; i < bitmap_blocks; i++) {
+        block_t *bitmap_block = get_block(fs_map, 1 + i);
+        memset(bitmap_block, 0, stride);
+
+        for (uint32_t bit = 0; bit < BITMAP_BITS_PER_BLOCK; bit++) {
+            uint64_t block_num = (uint64_t) i * BITMAP_BITS_PER_BLOCK + bit;
+            if (block_num < superbloc->data_start || block_num >= nbb) {
+                bitmap_block->data[bit / 8] |= (1 << (bit % 8));
+            }
+        }
+
+        // Somme de contrôle et metadata
+        checksum_block_compute(checksum, bitmap_block, data_size);
+        block_meta(bitmap_block, data_size)->type = 2; // Bitmap
+        init_block_lock(fs_map, bitmap_block);
 
-    // Les blocs 0 à (superbloc + bitmaps + inodes) sont alloués
-    for (uint32_t i = 0; i < superbloc->data_start; i++) {
-        bitmap_area[i / 8] |= (1 << (i % 8));
     }
 
-    // Calculer SHA1 pour chaque bloc de bitmap
-    for (int i = 0; i < bitmap_blocks; i++) {
-        block_t *bitmap_block = (block_t *) (fs_map + (1 + i) * BLOCK_SIZE);
+    // Initialiser la bitmap des inodes : tous libres, les bits au-delà du dernier inode à 1
+    for (uint32_t i = 0; i < inode_bitmap_blocks; i++) {
+        block_t *inode_bitmap_block = get_block(fs_map, superbloc->inode_bitmap_start + i);
+        memset(inode_bitmap_block, 0, stride);
 
-        // SHA1 et metadata
-        SHA1(bitmap_block->data, 4000, sha1);
-        memcpy(bitmap_block->sha1, sha1, 20);
-        bitmap_block->type = 2; // Bitmap
-        memset(bitmap_block->lock_read, 0, LOCK_SIZE);
-        memset(bitmap_block->lock_write, 0, LOCK_SIZE);
-        init_block_lock(bitmap_block);
+        uint32_t first_unused = (uint32_t) (nb_inode - i * DATA_SIZE * 8);
+        for (uint32_t bit = first_unused; bit < DATA_SIZE * 8; bit++) {
+            inode_bitmap_block->data[bit / 8] |= (1 << (bit % 8));
+        }
 
+        init_block_lock(fs_map, inode_bitmap_block);
+        block_meta(inode_bitmap_block, data_size)->type = BLOCK_TYPE_INODE_BITMAP;
+
+        checksum_block_compute(checksum, inode_bitmap_block, data_size);
+    }
+
+    // Initialiser l'index des noms (table vide)
+    for (uint32_t i = 0; i < index_blocks; i++) {
+        block_t *index_block = get_block(fs_map, superbloc->name_index_start + i);
+        memset(index_block, 0, stride);
+
+        init_block_lock(fs_map, index_block);
+        block_meta(index_block, data_size)->type = BLOCK_TYPE_NAME_INDEX;
+
+        checksum_block_compute(checksum, index_block, data_size);
     }
 
-    // Initialiser les inodes
-    block_t *inode_area = (block_t *) (fs_map + (1 + bitmap_blocks) * BLOCK_SIZE);
-    for (int i = 0; i < nb_inode; i++) {
-        block_t *inode_block = &inode_area[i];
-        memset(inode_block, 0, sizeof(block_t));  // CLEAN total
+    // Initialiser le résumé des inodes (colonnes à zéro : aucun inode, tas vide)
+    for (uint32_t i = 0; i < summary_blocks; i++) {
+        block_t *summary_block = get_block(fs_map, superbloc->summary_start + i);
+        memset(summary_block, 0, stride);
+
+        init_block_lock(fs_map, summary_block);
+        block_meta(summary_block, data_size)->type = BLOCK_TYPE_INODE_SUMMARY;
 
-        init_block_lock(inode_block);  // Initialiser mutex AVANT tout
+        checksum_block_compute(checksum, summary_block, data_size);
+    }
+
+    // Initialiser l'index des trigrammes (listes vides)
+    for (uint32_t i = 0; i < trigram_blocks; i++) {
+        block_t *trigram_block = get_block(fs_map, superbloc->trigram_start + i);
+        memset(trigram_block, 0, stride);
 
-        inode_block->type = 3;
+        init_block_lock(fs_map, trigram_block);
+        block_meta(trigram_block, data_size)->type = BLOCK_TYPE_TRIGRAM_INDEX;
 
-        // SHA1
-        compute_block_sha1(inode_block);
+        checksum_block_compute(checksum, trigram_block, data_size);
     }
 
-     // Initialiser les blocs de données (DATA) pas sur de bien faire
-     block_t *data_area = (block_t *) (fs_map + superbloc->data_start * BLOCK_SIZE);
-     for (int i = 0; i < nb_block; i++) {
-         block_t *data_block = &data_area[i];
-         memset(data_block, 0, sizeof(block_t));
+    // Initialiser les blocs d'inodes
+    for (uint32_t i = 0; i < inode_blocks; i++) {
+        block_t *inode_block = get_block(fs_map, superbloc->inode_start + i);
+        memset(inode_block, 0, stride);  // CLEAN total
+
+        init_block_lock(fs_map, inode_block);  // Initialiser mutex AVANT tout
 
-         init_block_lock(data_block);
-         data_block->type = BLOCK_TYPE_DATA;
+        block_meta(inode_block, data_size)->type = 3;
 
-         compute_block_sha1(data_block);
-     }
+        // Somme de contrôle
+        checksum_block_compute(checksum, inode_block, data_size);
+    }
+
+    // Initialiser les blocs de données : le fichier vient d'être tronqué, leurs données sont déjà
+    // à zéro et ont toutes la même empreinte, calculée une seule fois (mkfs de plusieurs Gio)
+    block_meta_t *first_data = NULL;
+    for (uint32_t i = 0; i < nb_block; i++) {
+        block_t *data_block = get_block(fs_map, superbloc->data_start + i);
+        block_meta_t *meta = block_meta(data_block, data_size);
+
+        init_block_lock(fs_map, data_block);
+        meta->type = BLOCK_TYPE_DATA;
+
+        if (!first_data) {
+            checksum_block_compute(checksum, data_block, data_size);
+            first_data = meta;
+        } else {
+            memcpy(meta->sha1, first_data->sha1, SHA1_SIZE);
+            *BLOCK_GENERATION(meta) = *BLOCK_GENERATION(first_data);
+        }
+    }
 
-    printf(" Système de fichiers %s initialisé avec %d inodes et %d blocs allouables.\n", fsname, nb_inode, nb_block);
+    printf(" Système de fichiers %s initialisé avec %u inodes et %u blocs allouables.\n", fsname, nb_inode, nb_block);
 
-    if (munmap(fs_map, nbb * BLOCK_SIZE) < 0) {
+    if (munmap(fs_map, fs_size) < 0) {
         fs_error("Erreur lors de la libération de la projection mémoire");
     }
 
     close(fd);
 
-    printf("nbb (total blocs) = %d\n", nbb);
-    printf("bitmap_blocks = %d\n", bitmap_blocks);
-    printf("nb_inodes = %d\n", nb_inode);
-    printf("nb_blocks allouables = %d\n", nb_block);
+    printf("nbb (total blocs) = %u\n", nbb);
+    printf("bitmap_blocks = %lu\n", (unsigned long) bitmap_blocks);
+    printf("inode_bitmap_blocks = %u\n", inode_bitmap_blocks);
+    printf("index_blocks = %u\n", index_blocks);
+    printf("summary_blocks = %u\n", summary_blocks);
+    printf("trigram_blocks = %u\n", trigram_blocks);
+    printf("nb_inodes = %u (%u par bloc)\n", nb_inode, per_block);
+    printf("nb_blocks allouables = %u\n", nb_block);
+    printf("checksum = %s\n", checksum->name);
+    printf("format = %s (blocs de %zu octets, %u octets de données)\n", page_blocks ? "v2" : "v1", stride, data_size);
 
     return EXIT_SUCCESS;
 }
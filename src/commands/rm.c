@@ -2,6 +2,9 @@
 #include "../../include/fs_structs.h"
 #include "../../include/block_ops.h"
 #include "../../include/inode_ops.h"
+#include "../../include/name_index.h"
+#include "../../include/inode_summary.h"
+#include "../../include/trigram_index.h"
 
 int cmd_rm(const char *fsname, const char *filename) {
     if (filename == NULL) {
@@ -23,7 +26,7 @@ int cmd_rm(const char *fsname, const char *filename) {
     }
 
     // Trouver l'inode du fichier à supprimer
-    int inode_idx = find_inode_by_name(ctx.fs_map, pignoufs_path);
+    int inode_idx = find_inode_by_name(&ctx, pignoufs_path);
     if (inode_idx == -1) {
         fs_error("Erreur : Fichier '%s' introuvable", pignoufs_path);
         fs_free_context(&ctx);
@@ -38,62 +41,47 @@ int cmd_rm(const char *fsname, const char *filename) {
         return EXIT_FAILURE;
     }
 
-    if (!verify_block_sha1(inode_block)) {
+    if (!verify_block_checksum(&ctx, inode_block)) {
         fs_error("Erreur : Bloc d'inode corrompu");
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
 
-    pthread_mutex_lock((pthread_mutex_t *) inode_block->lock_write);
+    pthread_mutex_lock(block_write_lock(ctx.fs_map, inode_block));
 
-    inode_t *inode = (inode_t *) inode_block->data;
+    inode_t *inode = get_inode(ctx.fs_map, inode_idx);
 
     // Vérifier que le fichier existe
     if (!(inode->flags & PERM_EXISTS)) {
         fs_error("Erreur : Le fichier '%s' n'existe pas", pignoufs_path);
-        pthread_mutex_unlock((pthread_mutex_t *) inode_block->lock_write);
+        pthread_mutex_unlock(block_write_lock(ctx.fs_map, inode_block));
         fs_free_context(&ctx);
         return EXIT_FAILURE;
     }
 
-    // Libérer tous les blocs directs
-    for (int i = 0; i < 10; i++) {
-        if (inode->direct_blocks[i] != 0) {
-            set_block_free(ctx.fs_map, inode->direct_blocks[i]);
-            inode->direct_blocks[i] = 0;
-        }
-    }
+    // Libérer tous les blocs de données et d'indirection (un bloc d'indirection corrompu est
+    // rendu sans relire ses références)
+    block_map_truncate(&ctx, inode, 0);
 
-    // Libérer les blocs indirects si besoin
-    if (inode->indirect_block != 0) {
-        block_t *indirect_block = get_block(ctx.fs_map, (int) inode->indirect_block);
-        if (indirect_block && verify_block_sha1(indirect_block)) {
-            pthread_mutex_lock((pthread_mutex_t *) indirect_block->lock_write);
-            uint32_t *indirect_pointers = (uint32_t *) indirect_block->data;
-            int max_indirect = DATA_SIZE / sizeof(uint32_t);
-
-            for (int i = 0; i < max_indirect; i++) {
-                if (indirect_pointers[i] != 0) {
-                    set_block_free(ctx.fs_map, indirect_pointers[i]);
-                }
-            }
-            pthread_mutex_unlock((pthread_mutex_t *) indirect_block->lock_write);
-        }
-        set_block_free(ctx.fs_map, inode->indirect_block);
-        inode->indirect_block = 0;
+    // Retirer le nom des index avant d'effacer l'inode
+    if (ctx.sb->features & FS_FEATURE_NAME_INDEX) {
+        name_index_remove(&ctx, inode->filename, inode_idx);
     }
+    trigram_index_remove(&ctx, inode->filename, inode_idx);
 
     // Libérer l'inode
     inode->flags = 0;
-    inode->size = 0;
+    inode_set_size(inode, 0);
     memset(inode->filename, 0, sizeof(inode->filename));
 
-    compute_block_sha1(inode_block);
+    mark_block_dirty(&ctx, inode_block);
+    inode_summary_update(&ctx, inode_idx, inode);
+    fs_commit(&ctx);
 
-    pthread_mutex_unlock((pthread_mutex_t *) inode_block->lock_write);
+    pthread_mutex_unlock(block_write_lock(ctx.fs_map, inode_block));
 
-    // Mettre à jour le SHA1 du superbloc
-    compute_block_sha1((block_t *) ctx.fs_map);
+    // Rendre l'inode à la bitmap des inodes
+    release_inode(&ctx, inode_idx);
 
     printf("Fichier '%s' supprimé avec succès.\n", pignoufs_path);
     result = EXIT_SUCCESS;
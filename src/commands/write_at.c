@@ -0,0 +1,81 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "../../include/pignoufs.h"
+#include "../../include/fs_structs.h"
+#include "../../include/block_ops.h"
+#include "../../include/inode_ops.h"
+#include "../../include/fs_common.h"
+
+/**
+ * Lit toute l'entrée standard dans un buffer alloué
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+static int read_stdin(char **buffer, uint32_t *size) {
+    uint32_t capacity = DATA_SIZE;
+    *size = 0;
+    *buffer = malloc(capacity);
+    if (!*buffer) {
+        return fs_error("Erreur d'allocation mémoire");
+    }
+
+    ssize_t bytes_read;
+    while ((bytes_read = read(STDIN_FILENO, *buffer + *size, capacity - *size)) > 0) {
+        *size += (uint32_t) bytes_read;
+        if (*size == capacity) {
+            char *bigger = capacity <= UINT32_MAX / 2 ? realloc(*buffer, capacity * 2) : NULL;
+            if (!bigger) {
+                free(*buffer);
+                return fs_error("Entrée standard trop volumineuse");
+            }
+            *buffer = bigger;
+            capacity *= 2;
+        }
+    }
+
+    if (bytes_read < 0) {
+        free(*buffer);
+        return fs_error("Erreur lors de la lecture de l'entrée standard");
+    }
+    return 0;
+}
+
+int cmd_write_at(const char *fsname, const char *filename, uint64_t offset, const char *data) {
+    fs_context_t ctx;
+    char *input = NULL;
+    uint32_t size;
+
+    if (strncmp(filename, "//", 2) == 0) {
+        filename += 2;
+    }
+
+    // Données en argument, sinon l'entrée standard
+    if (data) {
+        size = (uint32_t) strlen(data);
+    } else {
+        if (read_stdin(&input, &size) < 0) {
+            return EXIT_FAILURE;
+        }
+        data = input;
+    }
+
+    // Initialiser le contexte du système de fichiers et vérifier sa validité
+    if (init_fs_context_and_verify(fsname, &ctx, O_RDWR) < 0) {
+        free(input);
+        return EXIT_FAILURE;
+    }
+
+    int inode_index = find_file_with_perm_check(&ctx, filename, PERM_WRITE);
+    if (inode_index < 0 || write_inode_at(&ctx, inode_index, data, size, offset) < 0) {
+        free(input);
+        fs_free_context(&ctx);
+        return EXIT_FAILURE;
+    }
+
+    printf("%u octets écrits dans '%s' à la position %lu\n", size, filename, (unsigned long) offset);
+
+    free(input);
+    fs_free_context(&ctx);
+    return EXIT_SUCCESS;
+}
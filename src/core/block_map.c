@@ -0,0 +1,269 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "block_map.h"
+#include "block_ops.h"
+
+
+/// Table des blocs d'un fichier : après les blocs directs, le rang n d'un bloc est ramené à un
+/// indice m dans l'arbre d'indirection à t niveaux qui le contient. Le nœud de profondeur d
+/// couvre refs^(t - d) rangs ; c'est le numéro m / refs^(t - d) qui sert de clé au cache
+
+/**
+ * refs^k sur 64 bits (k <= BLOCK_MAP_LEVELS)
+ */
+static uint64_t refs_pow(uint32_t refs, int k) {
+    uint64_t result = 1;
+    while (k-- > 0) result *= refs;
+    return result;
+}
+
+/**
+ * Emplacement du cache pour la profondeur depth de l'arbre à levels niveaux
+ */
+static int cache_slot(int levels, int depth) {
+    return (levels - 1) * levels / 2 + depth;
+}
+
+/**
+ * Référence de la racine de l'arbre à levels niveaux
+ */
+static uint32_t *tree_root(inode_t *inode, int levels) {
+    return levels == 1 ? &inode->indirect_block : levels == 2 ? &inode->double_indirect : &inode->triple_indirect;
+}
+
+void block_map_init(block_map_t *map, fs_context_t *ctx, inode_t *inode) {
+    memset(map, 0, sizeof(*map));
+    map->ctx = ctx;
+    map->inode = inode;
+    map->refs = ctx->data_size / sizeof(uint32_t);
+}
+
+uint32_t block_map_max_blocks(fs_context_t *ctx) {
+    uint64_t refs = ctx->data_size / sizeof(uint32_t);
+    uint64_t blocks = BLOCK_MAP_DIRECT + refs + refs * refs + refs * refs * refs;
+    return blocks > UINT32_MAX ? UINT32_MAX : (uint32_t) blocks;
+}
+
+uint64_t block_map_indirect_count(fs_context_t *ctx, uint64_t blocks) {
+    uint32_t refs = ctx->data_size / sizeof(uint32_t);
+    uint64_t rest = blocks > BLOCK_MAP_DIRECT ? blocks - BLOCK_MAP_DIRECT : 0;
+    uint64_t count = 0;
+
+    for (int levels = 1; levels <= BLOCK_MAP_LEVELS && rest > 0; levels++) {
+        uint64_t span = refs_pow(refs, levels);
+        uint64_t used = rest < span ? rest : span;
+
+        // Nœuds de chaque profondeur nécessaires pour couvrir les used premiers rangs de l'arbre
+        for (int depth = 0; depth < levels; depth++) {
+            uint64_t cover = refs_pow(refs, levels - depth);
+            count += (used + cover - 1) / cover;
+        }
+        rest -= used;
+    }
+    return count;
+}
+
+/**
+ * Charge le nœud désigné par ref, ou le crée s'il manque et que create est demandé
+ * @param parent Nœud qui contient ref (NULL : ref est dans l'inode)
+ * @return Le nœud vérifié, NULL en cas d'erreur
+ */
+static block_t *load_node(block_map_t *map, uint32_t *ref, block_t *parent, int create) {
+    fs_context_t *ctx = map->ctx;
+
+    if (*ref == 0) {
+        if (!create) {
+            fs_error("Bloc d'indirection manquant");
+            return NULL;
+        }
+
+        uint32_t block_num = find_free_block(ctx);
+        block_t *node = block_num ? get_block(ctx->fs_map, block_num) : NULL;
+        if (!node) {
+            fs_error("Erreur lors de l'allocation d'un bloc d'indirection");
+            return NULL;
+        }
+        memset(node->data, 0, ctx->data_size);
+        BLOCK_META(ctx, node)->type = BLOCK_TYPE_INDIRECT;
+        mark_block_dirty(ctx, node);
+
+        *ref = block_num;
+        if (parent) mark_block_dirty(ctx, parent);
+        map->allocated++;
+        return node;
+    }
+
+    block_t *node = get_block(ctx->fs_map, *ref);
+    if (!node || !verify_block_checksum(ctx, node)) {
+        fs_error("Erreur lors de l'accès au bloc d'indirection %u ou bloc corrompu", *ref);
+        return NULL;
+    }
+    return node;
+}
+
+uint32_t *block_map_slot(block_map_t *map, uint32_t n, int create) {
+    if (n < BLOCK_MAP_DIRECT) {
+        return &map->inode->direct_blocks[n];
+    }
+
+    // Arbre contenant le rang, et indice dans cet arbre
+    uint64_t m = n - BLOCK_MAP_DIRECT;
+    int levels = 1;
+    while (levels <= BLOCK_MAP_LEVELS && m >= refs_pow(map->refs, levels)) {
+        m -= refs_pow(map->refs, levels);
+        levels++;
+    }
+    if (levels > BLOCK_MAP_LEVELS) {
+        fs_error("Rang de bloc %u au-delà de la taille maximale d'un fichier", n);
+        return NULL;
+    }
+
+    // Partir du nœud gardé le plus profond sur le chemin (la feuille en accès séquentiel)
+    int depth = levels - 1;
+    block_t *node = NULL;
+    for (; depth >= 0; depth--) {
+        int slot = cache_slot(levels, depth);
+        if (map->node_ids[slot] == m / refs_pow(map->refs, levels - depth) + 1) {
+            node = map->nodes[slot];
+            break;
+        }
+    }
+    if (!node) {
+        depth = 0;
+        node = load_node(map, tree_root(map->inode, levels), NULL, create);
+        if (!node) return NULL;
+        map->node_ids[cache_slot(levels, 0)] = 1;
+        map->nodes[cache_slot(levels, 0)] = node;
+    }
+
+    // Descendre jusqu'à la feuille, qui contient la référence du bloc de données
+    for (; depth < levels - 1; depth++) {
+        uint64_t child_cover = refs_pow(map->refs, levels - depth - 1);
+        uint32_t *child_ref = (uint32_t *) node->data + (m / child_cover) % map->refs;
+
+        node = load_node(map, child_ref, node, create);
+        if (!node) return NULL;
+        map->node_ids[cache_slot(levels, depth + 1)] = m / child_cover + 1;
+        map->nodes[cache_slot(levels, depth + 1)] = node;
+    }
+
+    if (create) mark_block_dirty(map->ctx, node);
+    return (uint32_t *) node->data + m % map->refs;
+}
+
+/**
+ * Libère les rangs keep et au-delà du sous-arbre désigné par ref (levels niveaux sous lui),
+ * et le nœud lui-même si keep vaut 0
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+static int truncate_tree(fs_context_t *ctx, uint32_t *ref, int levels, uint64_t keep) {
+    if (*ref == 0) return 0;
+
+    uint32_t refs = ctx->data_size / sizeof(uint32_t);
+    uint64_t child_span = refs_pow(refs, levels - 1);
+    block_t *node = get_block(ctx->fs_map, *ref);
+
+    if (node && verify_block_checksum(ctx, node)) {
+        uint32_t *children = (uint32_t *) node->data;
+        int modified = 0;
+
+        for (uint64_t i = keep / child_span; i < refs; i++) {
+            if (children[i] == 0) continue;
+
+            uint64_t child_keep = keep > i * child_span ? keep - i * child_span : 0;
+            if (levels == 1) {
+                set_block_free(ctx, children[i]);
+                children[i] = 0;
+            } else {
+                if (truncate_tree(ctx, &children[i], levels - 1, child_keep) < 0) return -1;
+                if (children[i] != 0) continue;
+            }
+            modified = 1;
+        }
+
+        // Le nœud a été modifié : à rehacher, même s'il est rendu à la bitmap
+        if (modified) mark_block_dirty(ctx, node);
+    } else if (keep > 0) {
+        return fs_error("Erreur lors de l'accès au bloc d'indirection %u ou bloc corrompu", *ref);
+    }
+
+    if (keep == 0) {
+        set_block_free(ctx, *ref);
+        *ref = 0;
+    }
+    return 0;
+}
+
+int block_map_truncate(fs_context_t *ctx, inode_t *inode, uint32_t keep) {
+    for (uint32_t n = keep; n < BLOCK_MAP_DIRECT; n++) {
+        if (inode->direct_blocks[n] != 0) {
+            set_block_free(ctx, inode->direct_blocks[n]);
+            inode->direct_blocks[n] = 0;
+        }
+    }
+
+    uint32_t refs = ctx->data_size / sizeof(uint32_t);
+    uint64_t rest = keep > BLOCK_MAP_DIRECT ? keep - BLOCK_MAP_DIRECT : 0;
+    for (int levels = 1; levels <= BLOCK_MAP_LEVELS; levels++) {
+        uint64_t span = refs_pow(refs, levels);
+        uint64_t tree_keep = rest < span ? rest : span;
+
+        if (tree_keep < span && truncate_tree(ctx, tree_root(inode, levels), levels, tree_keep) < 0) {
+            return -1;
+        }
+        rest -= tree_keep;
+    }
+    return 0;
+}
+
+/**
+ * Visite le nœud désigné par block_num puis ses descendants
+ * @return Nombre de blocs de données visités, -1 si un nœud est illisible
+ */
+static int64_t walk_tree(fs_context_t *ctx, uint32_t block_num, int levels,
+                         void (*visit)(void *, uint32_t, int), void *arg) {
+    block_t *node = get_block(ctx->fs_map, block_num);
+    visit(arg, block_num, 1);
+    if (!node || !verify_block_checksum(ctx, node)) return -1;
+
+    uint32_t refs = ctx->data_size / sizeof(uint32_t);
+    uint32_t *children = (uint32_t *) node->data;
+    int64_t count = 0;
+
+    for (uint32_t i = 0; i < refs; i++) {
+        if (children[i] == 0) continue;
+        if (levels == 1) {
+            visit(arg, children[i], 0);
+            count++;
+        } else {
+            int64_t sub = walk_tree(ctx, children[i], levels - 1, visit, arg);
+            if (sub < 0) return -1;
+            count += sub;
+        }
+    }
+    return count;
+}
+
+int64_t block_map_walk(fs_context_t *ctx, inode_t *inode, void (*visit)(void *arg, uint32_t block_num, int indirect),
+                       void *arg) {
+    int64_t count = 0;
+
+    for (uint32_t n = 0; n < BLOCK_MAP_DIRECT; n++) {
+        if (inode->direct_blocks[n] != 0) {
+            visit(arg, inode->direct_blocks[n], 0);
+            count++;
+        }
+    }
+
+    for (int levels = 1; levels <= BLOCK_MAP_LEVELS; levels++) {
+        uint32_t root = *tree_root(inode, levels);
+        if (root == 0) continue;
+
+        int64_t sub = walk_tree(ctx, root, levels, visit, arg);
+        if (sub < 0) return -1;
+        count += sub;
+    }
+    return count;
+}
@@ -4,108 +4,607 @@
 
 #include "block_ops.h"
 #include "fs_common.h"
+#include "inode_ops.h"
 #include <stdio.h>
 
 
 /// Opération sur les block, je sais pas encore si c'est utile d'avoir un fichier expres pour ca ou pa
 
-void compute_block_sha1(block_t *block) {
-    // Calcul du SHA1 sur les données uniquement (pas sur l'en-tête)
-    SHA1(block->data, DATA_SIZE, block->sha1);
+void compute_block_checksum(fs_context_t *ctx, block_t *block) {
+    checksum_block_compute(ctx->checksum, block, ctx->data_size);
 }
 
-int verify_block_sha1(block_t *block) {
-    unsigned char computed_sha1[SHA1_SIZE];
+/**
+ * Index d'un bloc à partir de son adresse dans la projection
+ */
+static uint32_t block_index_of(fs_context_t *ctx, block_t *block) {
+    return (uint32_t) (((char *) block - (char *) ctx->fs_map) / ctx->sb->block_size);
+}
+
+int is_block_dirty(fs_context_t *ctx, block_t *block) {
+    if (!ctx->dirty.map) return 0;
+    uint32_t index = block_index_of(ctx, block);
+    return (ctx->dirty.map[index / 8] >> (index % 8)) & 1;
+}
+
+void mark_block_dirty(fs_context_t *ctx, block_t *block) {
+    dirty_set_t *dirty = &ctx->dirty;
+    uint32_t index = block_index_of(ctx, block);
+
+    if (!dirty->map) {
+        dirty->map = calloc((ctx->sb->num_blocks + 7) / 8, 1);
+        if (!dirty->map) {
+            compute_block_checksum(ctx, block);  // Pas de mémoire : recalcul immédiat
+            return;
+        }
+    }
+
+    if ((dirty->map[index / 8] >> (index % 8)) & 1) return;  // Déjà en attente
+
+    if (dirty->count == dirty->capacity) {
+        uint32_t capacity = dirty->capacity ? dirty->capacity * 2 : 64;
+        uint32_t *list = realloc(dirty->list, capacity * sizeof(uint32_t));
+        if (!list) {
+            compute_block_checksum(ctx, block);
+            return;
+        }
+        dirty->list = list;
+        dirty->capacity = capacity;
+    }
+
+    dirty->map[index / 8] |= (uint8_t) (1 << (index % 8));
+    dirty->list[dirty->count++] = index;
+}
+
+/**
+ * Cache des blocs déjà vérifiés, créé au premier accès
+ */
+static verify_cache_t *get_verify_cache(fs_context_t *ctx) {
+    if (!ctx->verify_cache) {
+        ctx->verify_cache = verify_cache_open(ctx->fd, ctx->sb->fs_id, ctx->sb->num_blocks);
+    }
+    return ctx->verify_cache;
+}
 
-    // Calculer le SHA1 des données
-    SHA1(block->data, DATA_SIZE, computed_sha1);
+int verify_block_checksum(fs_context_t *ctx, block_t *block) {
+    if (is_block_dirty(ctx, block)) return 1;
 
-    // Comparer avec le SHA1 stocké
-    return memcmp(computed_sha1, block->sha1, SHA1_SIZE) == 0;
+    verify_cache_t *cache = get_verify_cache(ctx);
+    uint32_t index = block_index_of(ctx, block);
+    uint32_t generation = __atomic_load_n(BLOCK_GENERATION(BLOCK_META(ctx, block)), __ATOMIC_ACQUIRE);
+    if (verify_cache_hit(cache, index, generation)) return 1;
+
+    if (!checksum_block_verify(ctx->checksum, block, ctx->data_size)) return 0;
+    verify_cache_store(cache, index, generation);
+    return 1;
+}
+
+int verify_blocks_checksum(fs_context_t *ctx, block_t *const *blocks, uint32_t count) {
+    verify_cache_t *cache = get_verify_cache(ctx);
+    block_t *pending[CHECKSUM_BATCH];
+    uint32_t positions[CHECKSUM_BATCH];
+    uint32_t generations[CHECKSUM_BATCH];
+    uint8_t valid[CHECKSUM_BATCH];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i <= count; i++) {
+        if (i < count && !is_block_dirty(ctx, blocks[i])) {
+            uint32_t generation = __atomic_load_n(BLOCK_GENERATION(BLOCK_META(ctx, blocks[i])), __ATOMIC_ACQUIRE);
+            if (!verify_cache_hit(cache, block_index_of(ctx, blocks[i]), generation)) {
+                pending[n] = blocks[i];
+                generations[n] = generation;
+                positions[n++] = i;
+            }
+        }
+
+        // Lot plein, ou dernier lot
+        if (n == CHECKSUM_BATCH || (i == count && n > 0)) {
+            checksum_blocks_verify(ctx->checksum, pending, n, valid, ctx->data_size);
+            for (uint32_t j = 0; j < n; j++) {
+                if (!valid[j]) return (int) positions[j];
+                verify_cache_store(cache, block_index_of(ctx, pending[j]), generations[j]);
+            }
+            n = 0;
+        }
+    }
+    return -1;
 }
 
-block_t *get_block(void *addr, int block_index) {
-    // Vérifier que l'index est valide
-    if (block_index < 0) {
+block_t *get_block(void *addr, uint32_t block_index) {
+    // Vérifier que l'index est valide (une référence corrompue ne doit pas sortir de la projection)
+    superblock_t *sb = (superblock_t *) ((block_t *) addr)->data;
+    if (block_index >= sb->num_blocks) {
         return NULL;
     }
 
     // Retourner le bloc correspondant à l'index
-    return (block_t *) (addr + block_index * BLOCK_SIZE);
+    return (block_t *) (addr + (size_t) block_index * fs_block_stride(addr));
+}
+
+pthread_mutex_t *block_read_lock(void *addr, block_t *block) {
+    return (pthread_mutex_t *) block_meta(block, fs_data_size(addr))->lock_read;
 }
 
+pthread_mutex_t *block_write_lock(void *addr, block_t *block) {
+    superblock_t *sb = (superblock_t *) ((block_t *) addr)->data;
+    if (!(sb->features & FS_FEATURE_PAGE_BLOCKS)) {
+        return (pthread_mutex_t *) block_meta(block, DATA_SIZE)->lock_write;
+    }
 
-void set_block_free(void *addr, uint32_t block_num) {
-    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    size_t index = (size_t) ((char *) block - (char *) addr) / sb->block_size;
+    return (pthread_mutex_t *) ((char *) addr + (size_t) sb->num_blocks * sb->block_size + index * LOCK_SIZE);
+}
 
-    if (block_num >= sb->num_blocks) return;
+pthread_mutex_t *superblock_lock(void *addr) {
+    return block_write_lock(addr, (block_t *) addr);
+}
 
-    block_t *bitmap_block = get_block(addr, (int) sb->bitmap_start);
-    if (!bitmap_block) return;
+void superblock_update_begin(fs_context_t *ctx) {
+    pthread_mutex_lock(superblock_lock(ctx->fs_map));
+}
 
-    unsigned char *bitmap = bitmap_block->data;
+void superblock_update_end(fs_context_t *ctx) {
+    compute_block_checksum(ctx, (block_t *) ctx->fs_map);
+    pthread_mutex_unlock(superblock_lock(ctx->fs_map));
+}
 
-    bitmap[block_num / 8] &= ~(1 << (block_num % 8));
 
-    sb->num_free_blocks++;
-    compute_block_sha1(bitmap_block);
-    compute_block_sha1((block_t *) addr);
+/**
+ * Masque des bits d'un mot de bitmap qui correspondent à des blocs existants
+ * (les anciens conteneurs laissent à 0 les bits au-delà du dernier bloc)
+ */
+static uint64_t bitmap_word_valid_mask(superblock_t *sb, uint32_t bitmap_index, uint32_t word) {
+    uint64_t first = (uint64_t) bitmap_index * BITMAP_BITS_PER_BLOCK + (uint64_t) word * 64;
+    if (first >= sb->num_blocks) return 0;
+    if (first + 64 <= sb->num_blocks) return ~0ULL;
+    return (1ULL << (sb->num_blocks - first)) - 1;
 }
 
+static uint64_t *bitmap_words(void *fs_map, superblock_t *sb, uint32_t bitmap_index, block_t **block) {
+    block_t *bitmap_block = get_block(fs_map, (sb->bitmap_start + bitmap_index));
+    if (block) *block = bitmap_block;
+    return (uint64_t *) bitmap_block->data;
+}
 
-void set_block_used(void *addr, uint32_t block_num) {
-    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+uint32_t count_free_in_bitmap_block(void *fs_map, uint32_t bitmap_index) {
+    superblock_t *sb = (superblock_t *) (((block_t *) fs_map)->data);
+    uint64_t *words = bitmap_words(fs_map, sb, bitmap_index, NULL);
 
-    if (block_num >= sb->num_blocks) return;
+    uint32_t count = 0;
+    for (uint32_t w = 0; w < BITMAP_WORDS_PER_BLOCK; w++) {
+        count += __builtin_popcountll(~words[w] & bitmap_word_valid_mask(sb, bitmap_index, w));
+    }
+    return count;
+}
 
-    block_t *bitmap_block = get_block(addr, (int) sb->bitmap_start);
-    if (!bitmap_block) return;
+/**
+ * Construit (une seule fois par contexte) l'état de l'allocateur
+ * @return L'état ou NULL en cas d'erreur d'allocation
+ */
+static block_alloc_t *get_alloc_state(fs_context_t *ctx) {
+    if (ctx->alloc) return ctx->alloc;
+
+    block_alloc_t *alloc = calloc(1, sizeof(block_alloc_t));
+    if (!alloc) return NULL;
+
+    alloc->bitmap_blocks = (ctx->sb->num_blocks + BITMAP_BITS_PER_BLOCK - 1) / BITMAP_BITS_PER_BLOCK;
+    alloc->has_free = calloc(alloc->bitmap_blocks * BITMAP_SUMMARY_WORDS, sizeof(uint64_t));
+    alloc->summary_ready = calloc(alloc->bitmap_blocks, sizeof(uint8_t));
+    if (!alloc->has_free || !alloc->summary_ready) goto error;
+
+    if (ctx->sb->features & FS_FEATURE_ALLOC_SUMMARY) {
+        alloc->free_counts = ctx->sb->bitmap_free;
+    } else {
+        // Ancien conteneur : recompter les blocs libres de chaque bloc de bitmap
+        alloc->local_counts = calloc(alloc->bitmap_blocks, sizeof(uint32_t));
+        if (!alloc->local_counts) goto error;
+        for (uint32_t b = 0; b < alloc->bitmap_blocks; b++) {
+            alloc->local_counts[b] = count_free_in_bitmap_block(ctx->fs_map, b);
+        }
+        alloc->free_counts = alloc->local_counts;
+    }
 
-    unsigned char *bitmap = bitmap_block->data;
+    ctx->alloc = alloc;
+    return alloc;
 
-    bitmap[block_num / 8] |= (1 << (block_num % 8));
+    error:
+    free(alloc->has_free);
+    free(alloc->summary_ready);
+    free(alloc);
+    return NULL;
+}
 
-    sb->num_free_blocks--;
-    compute_block_sha1(bitmap_block);
-    compute_block_sha1((block_t *) addr);
+void free_alloc_state(fs_context_t *ctx) {
+    if (!ctx->alloc) return;
+    release_reserved_blocks(ctx);
+    free(ctx->alloc->has_free);
+    free(ctx->alloc->summary_ready);
+    free(ctx->alloc->local_counts);
+    free(ctx->alloc);
+    ctx->alloc = NULL;
 }
 
+/**
+ * Construit le résumé "mot contenant un bloc libre" d'un bloc de bitmap
+ */
+static uint64_t *bitmap_summary(fs_context_t *ctx, block_alloc_t *alloc, uint32_t bitmap_index) {
+    uint64_t *summary = alloc->has_free + bitmap_index * BITMAP_SUMMARY_WORDS;
+    if (alloc->summary_ready[bitmap_index]) return summary;
+
+    uint64_t *words = bitmap_words(ctx->fs_map, ctx->sb, bitmap_index, NULL);
+    memset(summary, 0, BITMAP_SUMMARY_WORDS * sizeof(uint64_t));
+    for (uint32_t w = 0; w < BITMAP_WORDS_PER_BLOCK; w++) {
+        if (~words[w] & bitmap_word_valid_mask(ctx->sb, bitmap_index, w)) {
+            summary[w / 64] |= 1ULL << (w % 64);
+        }
+    }
+    alloc->summary_ready[bitmap_index] = 1;
+    return summary;
+}
 
-uint32_t find_free_block(void *fs_map, superblock_t *sb) {
-    // Parcourir les blocs de bitmap
-    uint32_t bitmap_blocks = (sb->num_blocks / (BLOCK_SIZE * 8)) + 1;
+/**
+ * Met à jour les compteurs après le passage d'un bit de 0 à 1 (delta = -1) ou de 1 à 0 (delta = +1)
+ * L'appelant encadre l'appel par superblock_update_begin / superblock_update_end
+ */
+static void account_block(fs_context_t *ctx, block_alloc_t *alloc, uint32_t bitmap_index, int delta) {
+    if (alloc) {
+        __atomic_add_fetch(&alloc->free_counts[bitmap_index], (uint32_t) delta, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&ctx->sb->num_free_blocks, (uint32_t) delta, __ATOMIC_RELAXED);
+}
 
-    for (int i = 0; i < (int) bitmap_blocks; i++) {
-        block_t *bitmap_block = get_block(fs_map, (int) sb->bitmap_start + i);
-        if (!bitmap_block) continue;
+/**
+ * Réserve un bloc libre dans un bloc de bitmap, à partir du mot from_word
+ * @return Numéro du bloc réservé ou 0
+ */
+static uint32_t claim_in_bitmap_block(fs_context_t *ctx, block_alloc_t *alloc, uint32_t bitmap_index,
+                                      uint32_t from_word) {
+    block_t *bitmap_block;
+    uint64_t *words = bitmap_words(ctx->fs_map, ctx->sb, bitmap_index, &bitmap_block);
+    uint64_t *summary = bitmap_summary(ctx, alloc, bitmap_index);
+
+    for (uint32_t s = from_word / 64; s < BITMAP_SUMMARY_WORDS; s++) {
+        uint64_t pending = summary[s];
+        if (s == from_word / 64) pending &= ~0ULL << (from_word % 64);
+
+        while (pending) {
+            uint32_t w = s * 64 + __builtin_ctzll(pending);
+            uint64_t valid = bitmap_word_valid_mask(ctx->sb, bitmap_index, w);
+            uint64_t word = __atomic_load_n(&words[w], __ATOMIC_RELAXED);
+
+            // Un autre processus peut réserver le bit entre la lecture et le fetch_or
+            while (~word & valid) {
+                uint64_t mask = 1ULL << __builtin_ctzll(~word & valid);
+                uint64_t old = __atomic_fetch_or(&words[w], mask, __ATOMIC_ACQ_REL);
+                word = old | mask;
+
+                if (!(old & mask)) {
+                    if (!(~word & valid)) summary[s] &= ~(1ULL << (w % 64));
+                    uint32_t block_num = bitmap_index * BITMAP_BITS_PER_BLOCK + w * 64 + __builtin_ctzll(mask);
+                    superblock_update_begin(ctx);
+                    account_block(ctx, alloc, bitmap_index, -1);
+                    ctx->sb->alloc_cursor = block_num + 1;
+                    superblock_update_end(ctx);
+                    mark_block_dirty(ctx, bitmap_block);
+                    return block_num;
+                }
+            }
 
-        unsigned char *bitmap = bitmap_block->data;
-        uint32_t bits_per_block = BLOCK_SIZE * 8;
-        uint32_t start_bit = i * bits_per_block;
+            // Mot plein : le retirer du résumé
+            summary[s] &= ~(1ULL << (w % 64));
+            pending &= pending - 1;
+        }
+    }
+    return 0;
+}
 
-        // Parcourir les bits du bitmap
-        for (uint32_t j = 0; j < DATA_SIZE * 8; j++) {
-            uint32_t bit_index = start_bit + j;
-            if (bit_index < sb->data_start) continue; // Ignorer les blocs réservés
-            if (bit_index >= sb->num_blocks) break;   // Fin du système de fichiers
+uint32_t find_free_block(fs_context_t *ctx) {
+    block_alloc_t *alloc = get_alloc_state(ctx);
+    if (!alloc || alloc->bitmap_blocks == 0) return 0;
 
-            // Vérifier si le bit est à 0 (bloc libre)
-            if ((bitmap[j / 8] & (1 << (j % 8))) == 0) {
-                // Marquer le bloc comme utilisé
-                bitmap[j / 8] |= (1 << (j % 8));
-                compute_block_sha1(bitmap_block);
+    // Consommer d'abord les blocs réservés d'avance (déjà marqués dans la bitmap)
+    while (alloc->reserved_pos < alloc->reserved_extents) {
+        block_extent_t *extent = &alloc->reserved[alloc->reserved_pos];
+        if (extent->count == 0) {
+            alloc->reserved_pos++;
+            continue;
+        }
+        extent->count--;
+        return extent->start++;
+    }
 
-                // Décrémenter le nombre de blocs libres
-                compute_block_sha1((block_t *) fs_map);
+    superblock_t *sb = ctx->sb;
+    uint32_t cursor = sb->alloc_cursor < sb->num_blocks ? sb->alloc_cursor : 0;
+    uint32_t first = cursor / BITMAP_BITS_PER_BLOCK;
 
-                return bit_index;
-            }
+    // Un tour complet à partir du curseur ; le bloc de départ est revu en entier à la fin
+    for (uint32_t i = 0; i <= alloc->bitmap_blocks; i++) {
+        uint32_t b = (first + i) % alloc->bitmap_blocks;
+        if (alloc->free_counts[b] == 0) continue;
+
+        uint32_t from_word = (i == 0) ? (cursor % BITMAP_BITS_PER_BLOCK) / 64 : 0;
+        uint32_t block_num = claim_in_bitmap_block(ctx, alloc, b, from_word);
+        if (block_num != 0) {
+            return block_num;
         }
     }
 
     return 0; // Aucun bloc libre trouvé
 }
 
+/**
+ * Passe les bits d'une suite de blocs à 1 (set = 1) ou à 0 (set = 0), sans comptabilité
+ */
+static void flip_range_bits(fs_context_t *ctx, uint32_t start, uint32_t len, int set) {
+    uint32_t end = start + len;
+    for (uint32_t pos = start; pos < end;) {
+        uint32_t bit = pos % BITMAP_BITS_PER_BLOCK;
+        uint32_t n = 64 - bit % 64;
+        if (n > end - pos) n = end - pos;
+        uint64_t mask = (n == 64 ? ~0ULL : (1ULL << n) - 1) << (bit % 64);
+        uint64_t *word = &bitmap_words(ctx->fs_map, ctx->sb, pos / BITMAP_BITS_PER_BLOCK, NULL)[bit / 64];
+
+        if (set) __atomic_fetch_or(word, mask, __ATOMIC_ACQ_REL);
+        else __atomic_fetch_and(word, ~mask, __ATOMIC_ACQ_REL);
+        pos += n;
+    }
+}
+
+/**
+ * Marque une suite de blocs comme utilisée (used = 1) ou libre (used = 0) en une passe :
+ * un fetch_or/fetch_and par mot, puis compteurs, résumé et SHA1 une fois par bloc de bitmap
+ * @return 0 en cas de succès, -1 si un bloc de la suite a été réservé entre-temps
+ *         par un autre processus (rien n'est alors modifié)
+ */
+static int mark_range(fs_context_t *ctx, block_alloc_t *alloc, uint32_t start, uint32_t len, int used) {
+    superblock_t *sb = ctx->sb;
+    uint32_t end = start + len;
+
+    if (used) {
+        for (uint32_t pos = start; pos < end;) {
+            uint32_t bit = pos % BITMAP_BITS_PER_BLOCK;
+            uint32_t n = 64 - bit % 64;
+            if (n > end - pos) n = end - pos;
+            uint64_t mask = (n == 64 ? ~0ULL : (1ULL << n) - 1) << (bit % 64);
+            uint64_t *word = &bitmap_words(ctx->fs_map, sb, pos / BITMAP_BITS_PER_BLOCK, NULL)[bit / 64];
+
+            uint64_t old = __atomic_fetch_or(word, mask, __ATOMIC_ACQ_REL);
+            if (old & mask) {
+                // Annuler les bits posés dans ce mot et dans les précédents
+                __atomic_fetch_and(word, ~(mask & ~old), __ATOMIC_ACQ_REL);
+                flip_range_bits(ctx, start, pos - start, 0);
+                return -1;
+            }
+            pos += n;
+        }
+    } else {
+        flip_range_bits(ctx, start, len, 0);
+    }
+
+    superblock_update_begin(ctx);
+    for (uint32_t pos = start; pos < end;) {
+        uint32_t bitmap_index = pos / BITMAP_BITS_PER_BLOCK;
+        uint32_t block_end = (bitmap_index + 1) * BITMAP_BITS_PER_BLOCK;
+        if (block_end > end) block_end = end;
+
+        block_t *bitmap_block;
+        uint64_t *words = bitmap_words(ctx->fs_map, sb, bitmap_index, &bitmap_block);
+        uint32_t n = block_end - pos;
+        __atomic_add_fetch(&alloc->free_counts[bitmap_index], used ? -n : n, __ATOMIC_RELAXED);
+
+        if (alloc->summary_ready[bitmap_index]) {
+            uint64_t *summary = alloc->has_free + bitmap_index * BITMAP_SUMMARY_WORDS;
+            uint32_t first_word = (pos % BITMAP_BITS_PER_BLOCK) / 64;
+            uint32_t last_word = ((block_end - 1) % BITMAP_BITS_PER_BLOCK) / 64;
+            for (uint32_t w = first_word; w <= last_word; w++) {
+                if (~words[w] & bitmap_word_valid_mask(sb, bitmap_index, w)) {
+                    summary[w / 64] |= 1ULL << (w % 64);
+                } else {
+                    summary[w / 64] &= ~(1ULL << (w % 64));
+                }
+            }
+        }
+
+        mark_block_dirty(ctx, bitmap_block);
+        pos = block_end;
+    }
+
+    __atomic_add_fetch(&sb->num_free_blocks, used ? -len : len, __ATOMIC_RELAXED);
+    if (used) sb->alloc_cursor = end;
+    superblock_update_end(ctx);
+    return 0;
+}
+
+/**
+ * Termine une suite de blocs libres et retient la plus longue
+ */
+static void close_run(uint32_t *run_len, uint32_t run_start, uint32_t *best_len, uint32_t *best_start) {
+    if (*run_len > *best_len) {
+        *best_len = *run_len;
+        *best_start = run_start;
+    }
+    *run_len = 0;
+}
+
+uint32_t alloc_extent(fs_context_t *ctx, uint32_t count, uint32_t *first) {
+    block_alloc_t *alloc = get_alloc_state(ctx);
+    if (!alloc || alloc->bitmap_blocks == 0 || count == 0) return 0;
+
+    superblock_t *sb = ctx->sb;
+
+    // Quelques essais si un autre processus prend un bloc de la suite entre la recherche et le marquage
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint32_t cursor = sb->alloc_cursor < sb->num_blocks ? sb->alloc_cursor : 0;
+        uint32_t first_bitmap = cursor / BITMAP_BITS_PER_BLOCK;
+        uint32_t run_start = 0, run_len = 0, best_start = 0, best_len = 0;
+
+        for (uint32_t i = 0; i < alloc->bitmap_blocks && run_len < count; i++) {
+            uint32_t b = (first_bitmap + i) % alloc->bitmap_blocks;
+
+            // Une suite ne continue pas du dernier bloc de bitmap vers le premier
+            if (b == 0 || alloc->free_counts[b] == 0) {
+                close_run(&run_len, run_start, &best_len, &best_start);
+                if (alloc->free_counts[b] == 0) continue;
+            }
+
+            uint64_t *words = bitmap_words(ctx->fs_map, sb, b, NULL);
+            uint64_t *summary = bitmap_summary(ctx, alloc, b);
+
+            for (uint32_t w = 0; w < BITMAP_WORDS_PER_BLOCK && run_len < count; w++) {
+                uint32_t base = b * BITMAP_BITS_PER_BLOCK + w * 64;
+
+                // Mot plein d'après le résumé : la suite s'arrête
+                if (!((summary[w / 64] >> (w % 64)) & 1)) {
+                    close_run(&run_len, run_start, &best_len, &best_start);
+                    continue;
+                }
+
+                uint64_t free_bits = ~__atomic_load_n(&words[w], __ATOMIC_RELAXED)
+                                     & bitmap_word_valid_mask(sb, b, w);
+
+                // Mot entièrement libre : 64 blocs d'un coup
+                if (free_bits == ~0ULL) {
+                    if (run_len == 0) run_start = base;
+                    run_len += 64;
+                    continue;
+                }
+
+                for (uint32_t bit = 0; bit < 64 && run_len < count; bit++) {
+                    if ((free_bits >> bit) & 1) {
+                        if (run_len == 0) run_start = base + bit;
+                        run_len++;
+                    } else {
+                        close_run(&run_len, run_start, &best_len, &best_start);
+                    }
+                }
+            }
+        }
+        close_run(&run_len, run_start, &best_len, &best_start);
+
+        if (best_len == 0) return 0;
+        if (best_len > count) best_len = count;
+
+        if (mark_range(ctx, alloc, best_start, best_len, 1) == 0) {
+            *first = best_start;
+            return best_len;
+        }
+    }
+    return 0;
+}
+
+int reserve_blocks(fs_context_t *ctx, uint32_t count) {
+    block_alloc_t *alloc = get_alloc_state(ctx);
+    if (!alloc) return -1;
+    if (count > ctx->sb->num_free_blocks) return -1;
+
+    while (count > 0) {
+        uint32_t first;
+        uint32_t got = alloc_extent(ctx, count, &first);
+        if (got == 0) return -1;
+
+        block_extent_t *extents = realloc(alloc->reserved, (alloc->reserved_extents + 1) * sizeof(block_extent_t));
+        if (!extents) {
+            mark_range(ctx, alloc, first, got, 0);
+            return -1;
+        }
+        alloc->reserved = extents;
+        alloc->reserved[alloc->reserved_extents].start = first;
+        alloc->reserved[alloc->reserved_extents].count = got;
+        alloc->reserved_extents++;
+        count -= got;
+    }
+
+    // Réservation faite : bitmaps rehachées avant que l'appelant ne remplisse les blocs
+    fs_commit_alloc(ctx);
+    return 0;
+}
+
+uint32_t reserved_block_count(fs_context_t *ctx) {
+    block_alloc_t *alloc = ctx->alloc;
+    if (!alloc) return 0;
+
+    uint32_t count = 0;
+    for (uint32_t i = alloc->reserved_pos; i < alloc->reserved_extents; i++) {
+        count += alloc->reserved[i].count;
+    }
+    return count;
+}
+
+void release_reserved_blocks(fs_context_t *ctx) {
+    block_alloc_t *alloc = ctx->alloc;
+    if (!alloc) return;
+
+    for (uint32_t i = alloc->reserved_pos; i < alloc->reserved_extents; i++) {
+        if (alloc->reserved[i].count > 0) {
+            mark_range(ctx, alloc, alloc->reserved[i].start, alloc->reserved[i].count, 0);
+        }
+    }
+
+    free(alloc->reserved);
+    alloc->reserved = NULL;
+    alloc->reserved_extents = 0;
+    alloc->reserved_pos = 0;
+    fs_commit_alloc(ctx);
+}
+
+int is_block_used(void *fs_map, uint32_t block_num) {
+    superblock_t *sb = (superblock_t *) (((block_t *) fs_map)->data);
+    uint64_t *words = bitmap_words(fs_map, sb, block_num / BITMAP_BITS_PER_BLOCK, NULL);
+    uint32_t bit = block_num % BITMAP_BITS_PER_BLOCK;
+    return (words[bit / 64] >> (bit % 64)) & 1;
+}
+
+void set_block_free(fs_context_t *ctx, uint32_t block_num) {
+    superblock_t *sb = ctx->sb;
+
+    // Les blocs réservés (superbloc, bitmaps, index, inodes) ne sont jamais libérés
+    if (block_num < sb->data_start || block_num >= sb->num_blocks) return;
+
+    uint32_t bitmap_index = block_num / BITMAP_BITS_PER_BLOCK;
+    uint32_t bit = block_num % BITMAP_BITS_PER_BLOCK;
+    block_t *bitmap_block;
+    uint64_t *words = bitmap_words(ctx->fs_map, sb, bitmap_index, &bitmap_block);
+    uint64_t mask = 1ULL << (bit % 64);
+
+    uint64_t old = __atomic_fetch_and(&words[bit / 64], ~mask, __ATOMIC_ACQ_REL);
+    if (!(old & mask)) return;  // Déjà libre
+
+    block_alloc_t *alloc = get_alloc_state(ctx);
+    if (alloc && alloc->summary_ready[bitmap_index]) {
+        alloc->has_free[bitmap_index * BITMAP_SUMMARY_WORDS + bit / 4096] |= 1ULL << ((bit / 64) % 64);
+    }
+    superblock_update_begin(ctx);
+    account_block(ctx, alloc, bitmap_index, +1);
+    superblock_update_end(ctx);
+
+    mark_block_dirty(ctx, bitmap_block);
+}
+
+
+void set_block_used(fs_context_t *ctx, uint32_t block_num) {
+    superblock_t *sb = ctx->sb;
+
+    if (block_num >= sb->num_blocks) return;
+
+    uint32_t bitmap_index = block_num / BITMAP_BITS_PER_BLOCK;
+    uint32_t bit = block_num % BITMAP_BITS_PER_BLOCK;
+    block_t *bitmap_block;
+    uint64_t *words = bitmap_words(ctx->fs_map, sb, bitmap_index, &bitmap_block);
+    uint64_t mask = 1ULL << (bit % 64);
+
+    uint64_t old = __atomic_fetch_or(&words[bit / 64], mask, __ATOMIC_ACQ_REL);
+    if (old & mask) return;  // Déjà utilisé (par exemple réservé par find_free_block)
+
+    // Le résumé "mot contenant un bloc libre" peut rester à 1 : il est corrigé à la prochaine recherche
+    block_alloc_t *alloc = get_alloc_state(ctx);
+    superblock_update_begin(ctx);
+    account_block(ctx, alloc, bitmap_index, -1);
+    superblock_update_end(ctx);
+
+    mark_block_dirty(ctx, bitmap_block);
+}
+
+
 void increment_free_blocks(void *fs_map) {
     // Récupérer le superbloc
     block_t *superblock = (block_t *) fs_map;
@@ -114,8 +613,8 @@ void increment_free_blocks(void *fs_map) {
     // Incrémenter le compteur de blocs libres
     sb->num_free_blocks++;
 
-    // Mettre à jour le SHA1 du superbloc
-    compute_block_sha1(superblock);
+    // Mettre à jour la somme de contrôle du superbloc
+    checksum_block_compute(checksum_ops_by_id(sb->checksum_algo), superblock, fs_data_size(fs_map));
 }
 
 
@@ -127,16 +626,36 @@ void increment_free_blocks(void *fs_map) {
 void *verify_blocks_thread(void *arg) {
     verify_thread_args_t *args = (verify_thread_args_t *) arg;
     superblock_t *sb = (superblock_t *) (((block_t *) args->fs_map)->data);
+    const checksum_ops_t *checksum = checksum_ops_by_id(sb->checksum_algo);
+    if (!checksum) return NULL;
+    uint32_t data_size = fs_data_size(args->fs_map);
+
+    uint32_t end = args->end_block < sb->num_blocks ? args->end_block : sb->num_blocks;
+    block_t *batch[CHECKSUM_BATCH];
+    uint32_t batch_nums[CHECKSUM_BATCH];
+    uint8_t valid[CHECKSUM_BATCH];
+    uint32_t n = 0;
+
+    // Les blocs sont hachés par lots pour profiter du moteur multi-buffer
+    for (uint32_t i = args->start_block; i <= end; i++) {
+        if (i < end) {
+            block_t *block = get_block(args->fs_map, i);
+            if (block && block_meta(block, data_size)->type != 0) {  // Ignorer les blocs non initialisés
+                batch[n] = block;
+                batch_nums[n++] = i;
+            }
+        }
 
-    for (uint32_t i = args->start_block; i < args->end_block && i < sb->num_blocks; i++) {
-        block_t *block = get_block(args->fs_map, (int) i);
-        if (block && block->type != 0) {  // Ignorer les blocs non initialisés
-            if (!verify_block_sha1(block)) {
+        if (n == CHECKSUM_BATCH || (i == end && n > 0)) {
+            if (checksum_blocks_verify(checksum, batch, n, valid, data_size) > 0) {
                 pthread_mutex_lock(args->mutex);
                 *(args->corruption_found) = 1;
-                fs_error("Corruption détectée dans le bloc %u\n", i);
+                for (uint32_t j = 0; j < n; j++) {
+                    if (!valid[j]) fs_error("Corruption détectée dans le bloc %u\n", batch_nums[j]);
+                }
                 pthread_mutex_unlock(args->mutex);
             }
+            n = 0;
         }
     }
 
@@ -196,9 +715,12 @@ int verify_fs_blocks_parallel(void *fs_map, superblock_t *sb, int num_threads) {
  */
 int verify_inode_blocks_parallel(void *fs_map, int inode_index, int num_threads) {
     superblock_t *sb = (superblock_t *) (((block_t *) fs_map)->data);
+    const checksum_ops_t *checksum = checksum_ops_by_id(sb->checksum_algo);
+    if (!checksum) return 1;
+    uint32_t data_size = fs_data_size(fs_map);
 
-    block_t *inode_block = get_block(fs_map, (int) sb->inode_start + inode_index);
-    if (!inode_block || !verify_block_sha1(inode_block)) {
+    block_t *inode_block = get_inode_block(fs_map, inode_index);
+    if (!inode_block || !checksum_block_verify(checksum, inode_block, data_size)) {
         return 1;  // Corruption détectée dans le bloc d'inode
     }
 
@@ -209,10 +731,10 @@ int verify_inode_blocks_parallel(void *fs_map, int inode_index, int num_threads)
 
     // Analyser l'inode pour obtenir les blocs de données
     // Cette fonction devrait être adaptée à votre structure d'inode
-    inode_t *inode = (inode_t *) inode_block->data;
+    inode_t *inode = get_inode(fs_map, inode_index);
 
     // Allouer de la mémoire pour stocker tous les blocs potentiels
-    max_blocks = 10 + (DATA_SIZE / sizeof(uint32_t));  // Blocs directs + indirects
+    max_blocks = 10 + (data_size / sizeof(uint32_t));  // Blocs directs + indirects
     blocks = (uint32_t *) malloc(max_blocks * sizeof(uint32_t));
     if (!blocks) return 1;
 
@@ -225,12 +747,12 @@ int verify_inode_blocks_parallel(void *fs_map, int inode_index, int num_threads)
 
     // Collecter les blocs indirects
     if (inode->indirect_block != 0) {
-        block_t *indirect_block = get_block(fs_map, (int) inode->indirect_block);
-        if (indirect_block && verify_block_sha1(indirect_block)) {
+        block_t *indirect_block = get_block(fs_map, inode->indirect_block);
+        if (indirect_block && checksum_block_verify(checksum, indirect_block, data_size)) {
             blocks[num_blocks++] = inode->indirect_block;  // Ajouter le bloc d'indirection lui-même
 
             uint32_t *block_refs = (uint32_t *) indirect_block->data;
-            for (unsigned long i = 0; i < DATA_SIZE / sizeof(uint32_t); i++) {
+            for (unsigned long i = 0; i < data_size / sizeof(uint32_t); i++) {
                 if (block_refs[i] != 0) {
                     blocks[num_blocks++] = block_refs[i];
                 }
@@ -242,8 +764,8 @@ int verify_inode_blocks_parallel(void *fs_map, int inode_index, int num_threads)
     if ((int) num_blocks <= num_threads || num_threads <= 1) {
         int corruption = 0;
         for (uint32_t i = 0; i < num_blocks; i++) {
-            block_t *block = get_block(fs_map, (int) blocks[i]);
-            if (block && !verify_block_sha1(block)) {
+            block_t *block = get_block(fs_map, blocks[i]);
+            if (block && !checksum_block_verify(checksum, block, data_size)) {
                 corruption = 1;
                 fs_error("Corruption détectée dans le bloc %u\n", blocks[i]);
             }
@@ -0,0 +1,231 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "checksum.h"
+#include "sha1_mb.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+
+/// Sommes de contrôle des blocs : SHA1 (historique), CRC32C et xxHash64 (bien plus rapides,
+/// non cryptographiques mais suffisantes pour détecter une corruption)
+
+static void sha1_compute(const unsigned char *data, size_t len, unsigned char digest[SHA1_SIZE]) {
+    SHA1(data, len, digest);
+}
+
+/// CRC32C (polynôme de Castagnoli, forme réfléchie)
+
+#define CRC32C_POLY 0x82F63B78u
+
+static uint32_t crc32c_table[256];
+
+static void crc32c_init_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        }
+        crc32c_table[i] = crc;
+    }
+}
+
+static void store_digest(unsigned char digest[SHA1_SIZE], const void *value, size_t size) {
+    memset(digest, 0, SHA1_SIZE);
+    memcpy(digest, value, size);
+}
+
+static void crc32c_compute_soft(const unsigned char *data, size_t len, unsigned char digest[SHA1_SIZE]) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc32c_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    crc = ~crc;
+    store_digest(digest, &crc, sizeof(crc));
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static void crc32c_compute_sse42(const unsigned char *data, size_t len, unsigned char digest[SHA1_SIZE]) {
+    uint64_t crc = 0xFFFFFFFFu;
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        crc = _mm_crc32_u64(crc, word);
+    }
+    for (; i < len; i++) {
+        crc = _mm_crc32_u8((uint32_t) crc, data[i]);
+    }
+
+    uint32_t result = ~(uint32_t) crc;
+    store_digest(digest, &result, sizeof(result));
+}
+#endif
+
+/// xxHash64 (graine 0)
+
+#define XXH_PRIME64_1 11400714785074694791ULL
+#define XXH_PRIME64_2 14029467366897019727ULL
+#define XXH_PRIME64_3 1609587929392839161ULL
+#define XXH_PRIME64_4 9650029242287828579ULL
+#define XXH_PRIME64_5 2870177450012600261ULL
+
+static inline uint64_t xxh_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    acc = xxh_rotl(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh_merge_round(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void xxh64_compute(const unsigned char *data, size_t len, unsigned char digest[SHA1_SIZE]) {
+    const unsigned char *p = data;
+    const unsigned char *end = data + len;
+    uint64_t h64;
+
+    if (len >= 32) {
+        uint64_t v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = XXH_PRIME64_2;
+        uint64_t v3 = 0;
+        uint64_t v4 = -XXH_PRIME64_1;
+
+        // Quatre accumulateurs indépendants : les multiplications se recouvrent dans le pipeline
+        do {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
+            p += 32;
+        } while (p + 32 <= end);
+
+        h64 = xxh_rotl(v1, 1) + xxh_rotl(v2, 7) + xxh_rotl(v3, 12) + xxh_rotl(v4, 18);
+        h64 = xxh_merge_round(h64, v1);
+        h64 = xxh_merge_round(h64, v2);
+        h64 = xxh_merge_round(h64, v3);
+        h64 = xxh_merge_round(h64, v4);
+    } else {
+        h64 = XXH_PRIME64_5;
+    }
+
+    h64 += (uint64_t) len;
+
+    for (; p + 8 <= end; p += 8) {
+        h64 ^= xxh_round(0, xxh_read64(p));
+        h64 = xxh_rotl(h64, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        h64 ^= (uint64_t) v * XXH_PRIME64_1;
+        h64 = xxh_rotl(h64, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h64 ^= (*p) * XXH_PRIME64_5;
+        h64 = xxh_rotl(h64, 11) * XXH_PRIME64_1;
+    }
+
+    h64 ^= h64 >> 33;
+    h64 *= XXH_PRIME64_2;
+    h64 ^= h64 >> 29;
+    h64 *= XXH_PRIME64_3;
+    h64 ^= h64 >> 32;
+
+    store_digest(digest, &h64, sizeof(h64));
+}
+
+/// Table des algorithmes
+
+static checksum_ops_t checksum_algos[] = {
+        {CHECKSUM_SHA1,   "sha1",   SHA1_SIZE,        sha1_compute,        sha1_many},
+        {CHECKSUM_CRC32C, "crc32c", sizeof(uint32_t), crc32c_compute_soft, NULL},
+        {CHECKSUM_XXH64,  "xxh64",  sizeof(uint64_t), xxh64_compute,       NULL},
+};
+
+#define CHECKSUM_ALGO_COUNT (sizeof(checksum_algos) / sizeof(checksum_algos[0]))
+
+static pthread_once_t checksum_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Choisit une seule fois les variantes dépendant du processeur
+ */
+static void checksum_resolve(void) {
+    crc32c_init_table();
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        checksum_algos[CHECKSUM_CRC32C].compute = crc32c_compute_sse42;
+    }
+#endif
+}
+
+const checksum_ops_t *checksum_ops_by_id(uint32_t id) {
+    pthread_once(&checksum_once, checksum_resolve);
+    if (id >= CHECKSUM_ALGO_COUNT) return NULL;
+    return &checksum_algos[id];
+}
+
+const checksum_ops_t *checksum_ops_by_name(const char *name) {
+    pthread_once(&checksum_once, checksum_resolve);
+    for (size_t i = 0; i < CHECKSUM_ALGO_COUNT; i++) {
+        if (strcmp(checksum_algos[i].name, name) == 0) return &checksum_algos[i];
+    }
+    return NULL;
+}
+
+void checksum_block_compute(const checksum_ops_t *ops, block_t *block, uint32_t data_size) {
+    block_meta_t *meta = block_meta(block, data_size);
+
+    // Calcul sur les données uniquement (pas sur l'en-tête)
+    ops->compute(block->data, data_size, meta->sha1);
+
+    // Nouvelle génération : les caches de vérification doivent revérifier ce bloc
+    __atomic_add_fetch(BLOCK_GENERATION(meta), 1, __ATOMIC_RELEASE);
+}
+
+int checksum_block_verify(const checksum_ops_t *ops, block_t *block, uint32_t data_size) {
+    unsigned char computed[SHA1_SIZE];
+    ops->compute(block->data, data_size, computed);
+    return memcmp(computed, block_meta(block, data_size)->sha1, SHA1_SIZE) == 0;
+}
+
+uint32_t checksum_blocks_verify(const checksum_ops_t *ops, block_t *const *blocks, uint32_t count, uint8_t *valid,
+                                uint32_t data_size) {
+    uint32_t corrupted = 0;
+
+    for (uint32_t start = 0; start < count; start += CHECKSUM_BATCH) {
+        uint32_t n = count - start < CHECKSUM_BATCH ? count - start : CHECKSUM_BATCH;
+        unsigned char digests[CHECKSUM_BATCH][SHA1_SIZE];
+
+        if (ops->compute_many) {
+            const unsigned char *data[CHECKSUM_BATCH];
+            for (uint32_t i = 0; i < n; i++) data[i] = blocks[start + i]->data;
+            ops->compute_many(data, data_size, digests, (int) n);
+        } else {
+            for (uint32_t i = 0; i < n; i++) ops->compute(blocks[start + i]->data, data_size, digests[i]);
+        }
+
+        for (uint32_t i = 0; i < n; i++) {
+            valid[start + i] = memcmp(digests[i], block_meta(blocks[start + i], data_size)->sha1, SHA1_SIZE) == 0;
+            if (!valid[start + i]) corrupted++;
+        }
+    }
+    return corrupted;
+}
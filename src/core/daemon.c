@@ -0,0 +1,495 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#define _GNU_SOURCE  // struct ucred (SO_PEERCRED)
+
+#include "../../include/daemon.h"
+#include "../../include/fs_common.h"
+#include "../../include/verify_cache.h"
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+
+/// Démon : une seule ouverture du conteneur pour toutes les commandes, qui ne coûtent plus
+/// qu'un aller-retour sur la socket (pas d'open/fstat/mmap, ni de défauts de page à froid)
+
+// Descripteurs du client transmis avec la requête : entrée, sortie et erreur standard
+#define DAEMON_FDS 3
+
+// Variables d'environnement transmises au démon (PIGNOUFS_VERIFY, PIGNOUFS_THREADS...)
+#define DAEMON_ENV_PREFIX "PIGNOUFS_"
+
+extern char **environ;
+
+static volatile sig_atomic_t daemon_stop = 0;
+
+static void daemon_signal_handler(int signum) {
+    UNUSED(signum);
+    daemon_stop = 1;
+}
+
+int daemon_socket_path(const char *fsname, char *path, size_t size) {
+    int len = snprintf(path, size, "%s.sock", fsname);
+    if (len < 0 || (size_t) len >= size || (size_t) len >= sizeof(((struct sockaddr_un *) 0)->sun_path)) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Remplit l'adresse de la socket du démon
+ */
+static int daemon_address(const char *fsname, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    return daemon_socket_path(fsname, addr->sun_path, sizeof(addr->sun_path));
+}
+
+/**
+ * Lit ou écrit exactement size octets (reprend après une opération partielle)
+ */
+static int transfer_all(int fd, void *buf, size_t size, int writing) {
+    char *p = (char *) buf;
+    while (size > 0) {
+        ssize_t n = writing ? write(fd, p, size) : read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        size -= (size_t) n;
+    }
+    return 0;
+}
+
+/**
+ * Envoie l'en-tête de la requête avec les descripteurs standard du client
+ */
+static int send_request_header(int sock, const daemon_request_t *request) {
+    int fds[DAEMON_FDS] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(fds))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov = {(void *) request, sizeof(*request)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(sock, &msg, 0);
+    } while (sent < 0 && errno == EINTR);
+    return sent == (ssize_t) sizeof(*request) ? 0 : -1;
+}
+
+/**
+ * Reçoit l'en-tête d'une requête et les descripteurs qui l'accompagnent
+ * @return Nombre de descripteurs reçus, -1 en cas d'erreur
+ */
+static int recv_request_header(int sock, daemon_request_t *request, int fds[DAEMON_FDS]) {
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * DAEMON_FDS)];
+    } control;
+
+    struct iovec iov = {request, sizeof(*request)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t received;
+    do {
+        received = recvmsg(sock, &msg, 0);
+    } while (received < 0 && errno == EINTR);
+
+    int count = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            count = (int) ((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            if (count > DAEMON_FDS) count = DAEMON_FDS;
+            memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * (size_t) count);
+        }
+    }
+
+    if (received != (ssize_t) sizeof(*request) || (msg.msg_flags & MSG_CTRUNC)) {
+        for (int i = 0; i < count; i++) close(fds[i]);
+        return -1;
+    }
+    return count;
+}
+
+/**
+ * Vérifie que l'autre extrémité d'une socket connectée appartient à notre utilisateur
+ */
+static int peer_is_same_user(int sock) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    return getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid();
+}
+
+/**
+ * Variable d'environnement à transmettre au démon
+ */
+static int is_forwarded_env(const char *entry) {
+    return strncmp(entry, DAEMON_ENV_PREFIX, strlen(DAEMON_ENV_PREFIX)) == 0;
+}
+
+/**
+ * Copie une chaîne et son '\0' final, et renvoie la position qui suit
+ */
+static char *append_string(char *dst, const char *src) {
+    size_t len = strlen(src) + 1;
+    memcpy(dst, src, len);
+    return dst + len;
+}
+
+int daemon_forward(const char *fsname, uint16_t op, const char *command, int argc, char **argv, int *status) {
+    struct sockaddr_un addr;
+    if (daemon_address(fsname, &addr) < 0) {
+        return -1;
+    }
+
+    // Pas de socket : pas de démon, sans même tenter de connexion. Une socket d'un autre
+    // utilisateur (répertoire partagé) n'est pas le démon : nos descripteurs ne lui sont pas confiés
+    struct stat st;
+    if (lstat(addr.sun_path, &st) != 0 || !S_ISSOCK(st.st_mode) || st.st_uid != getuid()) {
+        return -1;
+    }
+
+    // Payload : répertoire courant (les chemins externes sont relatifs au client), variables
+    // PIGNOUFS_* du client, commande, arguments
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        return -1;
+    }
+
+    size_t payload_size = strlen(cwd) + 1 + strlen(command) + 1;
+    uint32_t envc = 0;
+    for (char **env = environ; *env; env++) {
+        if (!is_forwarded_env(*env)) continue;
+        payload_size += strlen(*env) + 1;
+        envc++;
+    }
+    for (int i = 0; i < argc; i++) {
+        payload_size += strlen(argv[i]) + 1;
+    }
+    if (payload_size > DAEMON_MAX_PAYLOAD) {
+        return -1;
+    }
+
+    char *payload = malloc(payload_size);
+    if (!payload) {
+        return -1;
+    }
+    char *p = payload;
+    p = append_string(p, cwd);
+    for (char **env = environ; *env; env++) {
+        if (is_forwarded_env(*env)) p = append_string(p, *env);
+    }
+    p = append_string(p, command);
+    for (int i = 0; i < argc; i++) {
+        p = append_string(p, argv[i]);
+    }
+
+    int result = -1;
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        goto cleanup;
+    }
+    if (connect(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        goto cleanup;  // Socket orpheline : exécution locale
+    }
+    if (!peer_is_same_user(sock)) {
+        goto cleanup;  // Processus d'un autre utilisateur derrière la socket : exécution locale
+    }
+
+    daemon_request_t request = {DAEMON_MAGIC, DAEMON_VERSION, op, envc, (uint32_t) argc + 1,
+                                (uint32_t) payload_size};
+    if (send_request_header(sock, &request) < 0 || transfer_all(sock, payload, payload_size, 1) < 0) {
+        goto cleanup;
+    }
+
+    // La requête est partie : le démon l'exécute, une réponse manquante est une erreur
+    result = 0;
+    daemon_reply_t reply;
+    if (transfer_all(sock, &reply, sizeof(reply), 0) < 0 || reply.magic != DAEMON_MAGIC) {
+        fs_error("Erreur : pas de réponse du démon");
+        *status = EXIT_FAILURE;
+    } else {
+        *status = reply.status;
+    }
+
+cleanup:
+    if (sock >= 0) close(sock);
+    free(payload);
+    return result;
+}
+
+/**
+ * Exécute une commande avec les descripteurs standard et le répertoire courant du client
+ */
+static int run_for_client(const char *fsname, daemon_runner_t run, const int fds[DAEMON_FDS],
+                          const char *cwd, int argc, char **argv) {
+    int saved[DAEMON_FDS];
+    int here = open(".", O_RDONLY);
+
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = 0; i < DAEMON_FDS; i++) {
+        saved[i] = dup(i);
+        dup2(fds[i], i);
+    }
+    clearerr(stdin);
+
+    int status;
+    if (chdir(cwd) < 0) {
+        status = fs_error("Erreur : répertoire du client inaccessible '%s'", cwd);
+    } else {
+        status = run(fsname, argv[0], argc - 1, argv + 1);
+    }
+
+    // Rendre la sortie au client avant de restaurer les descripteurs du démon
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = 0; i < DAEMON_FDS; i++) {
+        if (saved[i] >= 0) {
+            dup2(saved[i], i);
+            close(saved[i]);
+        } else {
+            close(i);  // Descripteur fermé au lancement du démon
+        }
+    }
+    if (here >= 0) {
+        if (fchdir(here) < 0) perror("Erreur lors du retour au répertoire du démon");
+        close(here);
+    }
+    return status;
+}
+
+/**
+ * Remplace les variables PIGNOUFS_* du démon par celles du client (dans le fils qui exécute
+ * sa commande)
+ */
+static void apply_client_env(fs_context_t *ctx, char **env, uint32_t envc) {
+    // Retirer d'abord celles du démon : une variable absente chez le client doit l'être aussi
+    for (char **entry = environ; *entry;) {
+        char *equal = strchr(*entry, '=');
+        if (is_forwarded_env(*entry) && equal) {
+            char name[256];
+            size_t len = (size_t) (equal - *entry);
+            if (len < sizeof(name)) {
+                memcpy(name, *entry, len);
+                name[len] = '\0';
+                unsetenv(name);
+                continue;  // environ a été décalé : même position
+            }
+        }
+        entry++;
+    }
+    for (uint32_t i = 0; i < envc; i++) {
+        if (is_forwarded_env(env[i]) && strchr(env[i], '=')) putenv(env[i]);
+    }
+    // Le cache du démon vit aussi longtemps que lui, alors qu'une corruption sur disque ne change
+    // pas la génération d'un bloc : sans demande explicite du client, tout accès est revérifié
+    verify_cache_reload_policy(ctx->verify_cache, VERIFY_ALWAYS);
+}
+
+/**
+ * Traite une connexion : lit la requête, puis l'exécute et répond dans un processus fils
+ * @return 1 si le démon doit s'arrêter, 0 sinon
+ */
+static int handle_client(int client, fs_context_t *ctx, const char *fsname, daemon_runner_t run) {
+    daemon_request_t request;
+    int fds[DAEMON_FDS];
+    int fd_count = recv_request_header(client, &request, fds);
+    if (fd_count < 0) {
+        return 0;
+    }
+
+    int stop = 0;
+    int replied = 0;
+    char *payload = NULL;
+    char **strings = NULL;
+    daemon_reply_t reply = {DAEMON_MAGIC, EXIT_FAILURE};
+
+    // Client d'un autre utilisateur (la socket n'est ouverte qu'au nôtre) : refusé
+    if (!peer_is_same_user(client)) {
+        goto cleanup;
+    }
+
+    if (request.magic != DAEMON_MAGIC || request.version != DAEMON_VERSION || fd_count != DAEMON_FDS
+        || request.payload_size == 0 || request.payload_size > DAEMON_MAX_PAYLOAD
+        || request.argc == 0 || request.argc > request.payload_size
+        || request.envc > request.payload_size - request.argc) {
+        goto cleanup;
+    }
+
+    payload = malloc(request.payload_size);
+    strings = malloc(sizeof(char *) * (request.envc + request.argc));
+    if (!payload || !strings || transfer_all(client, payload, request.payload_size, 0) < 0
+        || payload[request.payload_size - 1] != '\0') {
+        goto cleanup;
+    }
+
+    // Découper le payload : répertoire du client, puis ses envc variables et ses argc arguments
+    char *cwd = payload;
+    char *p = cwd + strlen(cwd) + 1;
+    char *end = payload + request.payload_size;
+    for (uint32_t i = 0; i < request.envc + request.argc; i++) {
+        if (p >= end) goto cleanup;
+        strings[i] = p;
+        p += strlen(p) + 1;
+    }
+    char **env = strings;
+    char **argv = strings + request.envc;
+
+    if (request.op == DAEMON_OP_STOP) {
+        stop = 1;
+        reply.status = EXIT_SUCCESS;
+    } else if (request.op == DAEMON_OP_RUN) {
+        // Un fils par commande : une commande qui attend l'entrée standard de son client ou un
+        // verrou d'inode ne retient pas les autres clients. Il partage la projection, le
+        // superbloc vérifié et le cache de vérification du démon
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid == 0) {
+            apply_client_env(ctx, env, request.envc);
+            reply.status = run_for_client(fsname, run, fds, cwd, (int) request.argc, argv);
+            transfer_all(client, &reply, sizeof(reply), 1);
+            _exit(EXIT_SUCCESS);
+        }
+        if (pid > 0) {
+            replied = 1;  // Le fils répond
+        } else {
+            perror("Erreur lors de la création du processus de la commande");
+        }
+    }
+
+cleanup:
+    if (!replied) transfer_all(client, &reply, sizeof(reply), 1);
+    for (int i = 0; i < fd_count; i++) close(fds[i]);
+    free(strings);
+    free(payload);
+    return stop;
+}
+
+int daemon_serve(const char *fsname, daemon_runner_t run) {
+    // Chemin absolu : les commandes s'exécutent dans le répertoire de chaque client
+    char abs_name[PATH_MAX];
+    if (!realpath(fsname, abs_name)) {
+        return fs_error("Conteneur introuvable '%s'", fsname);
+    }
+
+    struct sockaddr_un addr;
+    if (daemon_address(abs_name, &addr) < 0) {
+        return fs_error("Chemin de socket trop long pour '%s'", abs_name);
+    }
+
+    // Refuser de servir un conteneur déjà servi, mais remplacer une socket orpheline
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0 && connect(probe, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+        close(probe);
+        return fs_error("Un démon sert déjà '%s' (%s)", fsname, addr.sun_path);
+    }
+    if (probe >= 0) close(probe);
+    unlink(addr.sun_path);
+
+    fs_context_t ctx;
+    if (init_fs_context_and_verify(abs_name, &ctx, O_RDWR) < 0) {
+        return -1;
+    }
+    ctx.verify_cache = verify_cache_open(ctx.fd, ctx.sb->fs_id, ctx.sb->num_blocks);
+    verify_cache_share(ctx.verify_cache);  // Commun aux fils qui exécutent les commandes
+
+    // Précharger la projection : les commandes ne subissent plus de défauts de page à froid
+    volatile char touch = 0;
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (ssize_t offset = 0; offset < ctx.fs_size; offset += page_size) {
+        touch ^= ((volatile char *) ctx.fs_map)[offset];
+    }
+    UNUSED(touch);
+
+    int result = -1;
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        perror("Erreur lors de la création de la socket");
+        goto cleanup;
+    }
+
+    // Socket réservée à l'utilisateur du démon (les commandes s'exécutent avec ses droits)
+    mode_t old_umask = umask(0077);
+    int bound = bind(listener, (struct sockaddr *) &addr, sizeof(addr));
+    umask(old_umask);
+    if (bound < 0 || listen(listener, 64) < 0) {
+        perror("Erreur lors de l'écoute sur la socket");
+        goto cleanup;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = daemon_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);   // Sans SA_RESTART : accept est interrompu
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);       // Un client parti ne doit pas tuer le démon
+
+    // Fils des commandes récupérés automatiquement (pas de zombies)
+    struct sigaction sa_child;
+    memset(&sa_child, 0, sizeof(sa_child));
+    sa_child.sa_handler = SIG_DFL;
+    sa_child.sa_flags = SA_NOCLDWAIT;
+    sigemptyset(&sa_child.sa_mask);
+    sigaction(SIGCHLD, &sa_child, NULL);
+
+    fs_set_resident_context(abs_name, &ctx);
+    printf("Démon prêt : %s\n", addr.sun_path);
+    fflush(stdout);
+
+    while (!daemon_stop) {
+        int client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("Erreur lors de l'acceptation d'une connexion");
+            break;
+        }
+        if (handle_client(client, &ctx, abs_name, run)) {
+            daemon_stop = 1;
+        }
+        close(client);
+    }
+
+    // Attendre les commandes encore en cours avant de libérer le contexte
+    while (wait(NULL) > 0 || errno == EINTR) {}
+
+    fs_set_resident_context(NULL, NULL);
+    printf("Démon arrêté\n");
+    result = 0;
+
+cleanup:
+    if (listener >= 0) {
+        close(listener);
+        unlink(addr.sun_path);
+    }
+    fs_free_context(&ctx);
+    return result;
+}
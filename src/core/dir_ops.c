@@ -6,14 +6,16 @@
 #include "../../include/dir_ops.h"
 #include "../../include/inode_ops.h"
 #include "../../include/block_ops.h"
+#include "../../include/name_index.h"
+#include "../../include/inode_summary.h"
+#include "../../include/trigram_index.h"
 
 int create_directory(fs_context_t *ctx, const char *dirname) {
     // Vérifie si le répertoire existe déjà
-    int inode_index = find_inode_by_name(ctx->fs_map, dirname);
+    int inode_index = find_inode_by_name(ctx, dirname);
     if (inode_index >= 0) {
         // Le répertoire existe déjà, vérifier s'il s'agit bien d'un répertoire
-        block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
-        inode_t *inode = (inode_t *) inode_block->data;
+        inode_t *inode = get_inode(ctx->fs_map, inode_index);
 
         if (!(inode->flags & PERM_DIR)) {
             return FS_ERROR_NOTFOUND; // Un fichier avec le même nom existe déjà
@@ -29,26 +31,26 @@ int create_directory(fs_context_t *ctx, const char *dirname) {
 
     // Configure l'inode comme un répertoire
     block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
-    inode_t *inode = (inode_t *) inode_block->data;
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
     inode->flags |= PERM_DIR; // Marque comme répertoire
-    inode->size = 0;          // Taille initiale à zéro
+    inode_set_size(inode, 0); // Taille initiale à zéro
 
     // Met à jour le checksum du bloc inode
-    compute_block_sha1(inode_block);
+    mark_block_dirty(ctx, inode_block);
+    inode_summary_update(ctx, inode_index, inode);
 
     return inode_index;
 }
 
 int remove_directory(fs_context_t *ctx, const char *dirname) {
     // Trouve l'inode du répertoire
-    int inode_index = find_inode_by_name(ctx->fs_map, dirname);
+    int inode_index = find_inode_by_name(ctx, dirname);
     if (inode_index < 0) {
         return FS_ERROR_NOTFOUND; // Répertoire non trouvé
     }
 
     // Vérifie que c'est bien un répertoire
-    block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
-    inode_t *inode = (inode_t *) inode_block->data;
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
 
     if (!(inode->flags & PERM_DIR)) {
         return FS_ERROR_NOTFOUND; // Ce n'est pas un répertoire
@@ -59,40 +61,22 @@ int remove_directory(fs_context_t *ctx, const char *dirname) {
         return FS_ERROR_NOTFOUND; // Le répertoire n'est pas vide
     }
 
-    // Libère les blocs de données associés au répertoire
-    for (int i = 0; i < 10; i++) {
-        if (inode->direct_blocks[i] != 0) {
-            set_block_free(ctx->fs_map, inode->direct_blocks[i]);
-            increment_free_blocks(ctx->fs_map);
-        }
-    }
-
-    // Gère le bloc d'indirection si présent
-    if (inode->indirect_block != 0) {
-        block_t *indirect_block = get_block(ctx->fs_map, (int) inode->indirect_block);
-        uint32_t *indirect_ptrs = (uint32_t *) indirect_block->data;
+    // Libère les blocs de données et d'indirection associés au répertoire
+    block_map_truncate(ctx, inode, 0);
 
-        for (unsigned long i = 0; i < DATA_SIZE / sizeof(uint32_t); i++) {
-            if (indirect_ptrs[i] != 0) {
-                set_block_free(ctx->fs_map, indirect_ptrs[i]);
-                increment_free_blocks(ctx->fs_map);
-            }
-        }
-
-        set_block_free(ctx->fs_map, inode->indirect_block);
-        increment_free_blocks(ctx->fs_map);
+    // Retire le nom des index puis libère l'inode
+    if (ctx->sb->features & FS_FEATURE_NAME_INDEX) {
+        name_index_remove(ctx, inode->filename, inode_index);
     }
-
-    // Libère l'inode
-    set_inode_free(ctx->fs_map, inode_index);
+    trigram_index_remove(ctx, inode->filename, inode_index);
+    set_inode_free(ctx, inode_index);
 
     return FS_SUCCESS;
 }
 
 
 int is_directory_empty(fs_context_t *ctx, int dir_inode_index) {
-    block_t *dir_inode_block = get_inode_block(ctx->fs_map, dir_inode_index);
-    inode_t *dir_inode = (inode_t *) dir_inode_block->data;
+    inode_t *dir_inode = get_inode(ctx->fs_map, dir_inode_index);
 
     // Vérifie que l'inode est bien un répertoire
     if (!(dir_inode->flags & PERM_DIR)) {
@@ -100,7 +84,7 @@ int is_directory_empty(fs_context_t *ctx, int dir_inode_index) {
     }
 
     // Si la taille est 0, le répertoire est vide
-    if (dir_inode->size == 0) {
+    if (inode_size(dir_inode) == 0) {
         return 1;
     }
 
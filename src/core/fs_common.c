@@ -5,6 +5,19 @@
 #include "../../include/fs_common.h"
 #include "../../include/block_ops.h"
 #include <stdarg.h>
+#include <errno.h>
+
+// Messages de fs_error supprimés (bibliothèque : l'appelant n'a que errno)
+static int errors_silenced = 0;
+
+// Contexte gardé ouvert par le démon, et conteneur correspondant
+static fs_context_t *resident_ctx = NULL;
+static const char *resident_name = NULL;
+
+void fs_set_resident_context(const char *fsname, fs_context_t *ctx) {
+    resident_name = fsname;
+    resident_ctx = fsname ? ctx : NULL;
+}
 
 int fs_init_context(const char *fsname, fs_context_t *ctx, int mode) {
     // Initialiser le contexte avec des valeurs par défaut
@@ -12,31 +25,72 @@ int fs_init_context(const char *fsname, fs_context_t *ctx, int mode) {
     ctx->fd = -1;
     ctx->fs_map = NULL;
 
-    // Ouvrir le fichier conteneur
-    ctx->fd = open(fsname, mode);
+    // Conteneur servi par le démon : emprunter sa projection (allocateur et blocs modifiés restent propres à la commande)
+    if (resident_ctx && strcmp(fsname, resident_name) == 0) {
+        ctx->fd = resident_ctx->fd;
+        ctx->fs_map = resident_ctx->fs_map;
+        ctx->fs_size = resident_ctx->fs_size;
+        ctx->sb = resident_ctx->sb;
+        ctx->data_size = resident_ctx->data_size;
+        ctx->checksum = resident_ctx->checksum;
+        ctx->verify_cache = resident_ctx->verify_cache;
+        ctx->read_only = resident_ctx->read_only;
+        ctx->resident = 1;
+
+        // Lot : un seul ensemble de blocs modifiés pour toutes les commandes
+        if (resident_ctx->deferred) {
+            ctx->dirty = resident_ctx->dirty;
+            ctx->deferred = 1;
+        }
+        return 0;
+    }
+
+    // Ouvrir le fichier conteneur ; en lecture, il est tout de même ouvert en écriture quand c'est
+    // permis : les verrous des blocs sont dans la projection, et une vérification qui échoue
+    // pendant une mise à jour concurrente attend sa fin sous le verrou
+    if (mode == O_RDONLY) {
+        ctx->fd = open(fsname, O_RDWR);
+        if (ctx->fd >= 0) mode = O_RDWR;
+    }
+    if (ctx->fd < 0) ctx->fd = open(fsname, mode);
     if (ctx->fd < 0) {
-        perror("Erreur lors de l'ouverture du fichier conteneur");
+        int err = errno;
+        fs_error("Erreur lors de l'ouverture du fichier conteneur : %s", strerror(err));
+        errno = err;
         return -1;
     }
 
     // Récupérer la taille du fichier
     struct stat st;
     if (fstat(ctx->fd, &st) < 0) {
-        perror("Erreur lors de la récupération des informations du fichier");
+        int err = errno;
+        fs_error("Erreur lors de la récupération des informations du fichier : %s", strerror(err));
         close(ctx->fd);
         ctx->fd = -1;
+        errno = err;
         return -1;
     }
     ctx->fs_size = st.st_size;
 
     // Projeter le fichier en mémoire
-    int prot = (mode == O_RDONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+    ctx->read_only = mode == O_RDONLY;
+    int prot = ctx->read_only ? PROT_READ : (PROT_READ | PROT_WRITE);
     ctx->fs_map = mmap(NULL, ctx->fs_size, prot, MAP_SHARED, ctx->fd, 0);
     if (ctx->fs_map == MAP_FAILED) {
-        perror("Erreur lors de la projection mémoire");
+        int err = errno;
+        fs_error("Erreur lors de la projection mémoire : %s", strerror(err));
         close(ctx->fd);
         ctx->fd = -1;
         ctx->fs_map = NULL;
+        errno = err;
+        return -1;
+    }
+
+    // Le superbloc doit être entièrement dans le fichier
+    if ((size_t) ctx->fs_size < sizeof(block_t) + BLOCK_META_SIZE) {
+        fs_error("Erreur : conteneur trop petit\n");
+        fs_free_context(ctx);
+        errno = EINVAL;
         return -1;
     }
 
@@ -44,14 +98,135 @@ int fs_init_context(const char *fsname, fs_context_t *ctx, int mode) {
     block_t *superblock = (block_t *) ctx->fs_map;
     ctx->sb = (superblock_t *) superblock->data;
 
+    // Géométrie : pas entre les blocs, données par bloc (v1 : fixes ; v2 : pages, en-tête de
+    // BLOCK_META_SIZE octets après les données) et taille du conteneur cohérents avec le superbloc
+    int page_blocks = (ctx->sb->features & FS_FEATURE_PAGE_BLOCKS) != 0;
+    size_t stride = ctx->sb->block_size;
+    ctx->data_size = fs_data_size(ctx->fs_map);
+    int geometry_ok = page_blocks
+                      ? stride % PAGE_BLOCK_SIZE == 0 && stride <= MAX_BLOCK_SIZE
+                        && ctx->data_size == stride - BLOCK_META_SIZE
+                      : stride == BLOCK_SIZE && ctx->data_size == DATA_SIZE;
+    if ((ctx->sb->features & FS_FEATURE_PACKED_INODES)
+        && (ctx->sb->inodes_per_block == 0 || ctx->data_size / ctx->sb->inodes_per_block < sizeof(inode_t))) {
+        geometry_ok = 0;  // Table compacte : chaque place doit contenir un inode
+    }
+    size_t lock_table = page_blocks ? (size_t) ctx->sb->num_blocks * LOCK_SIZE : 0;
+    if (!geometry_ok || (size_t) ctx->fs_size < (size_t) ctx->sb->num_blocks * stride + lock_table) {
+        fs_error("Erreur : géométrie du conteneur invalide (bloc de %u octets, %u blocs)\n",
+                 ctx->sb->block_size, ctx->sb->num_blocks);
+        fs_free_context(ctx);
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Résoudre une fois pour toutes l'algorithme de somme de contrôle des blocs
+    ctx->checksum = checksum_ops_by_id(ctx->sb->checksum_algo);
+    if (!ctx->checksum) {
+        fs_error("Erreur : algorithme de somme de contrôle inconnu (%u)\n", ctx->sb->checksum_algo);
+        fs_free_context(ctx);
+        errno = EINVAL;
+        return -1;
+    }
+
     return 0;
 }
 
+/**
+ * Bloc d'une bitmap (blocs ou inodes) : seuls l'allocateur, qui ne le vérifie pas, et fsck le lisent
+ */
+static int block_in_bitmap(const superblock_t *sb, uint32_t index) {
+    uint32_t bitmap_blocks = (sb->num_blocks + BITMAP_BITS_PER_BLOCK - 1) / BITMAP_BITS_PER_BLOCK;
+    return (index >= sb->bitmap_start && index - sb->bitmap_start < bitmap_blocks)
+           || (index >= sb->inode_bitmap_start && index - sb->inode_bitmap_start < sb->inode_bitmap_blocks);
+}
+
+/**
+ * Recalcule la somme de contrôle d'un bloc en attente et le retire de l'ensemble
+ * Les bitmaps sont modifiées par plusieurs processus à la fois : leur hachage se fait sous
+ * superblock_lock, sans quoi un hachage commencé avant la modification d'un autre processus
+ * pourrait être rangé après le sien (somme périmée pour de bon)
+ */
+static void commit_block(fs_context_t *ctx, uint32_t index) {
+    dirty_set_t *dirty = &ctx->dirty;
+    dirty->map[index / 8] &= (uint8_t) ~(1 << (index % 8));
+
+    if (index == 0 || block_in_bitmap(ctx->sb, index)) {
+        pthread_mutex_t *commit_lock = superblock_lock(ctx->fs_map);
+        pthread_mutex_lock(commit_lock);
+        compute_block_checksum(ctx, get_block(ctx->fs_map, index));
+        pthread_mutex_unlock(commit_lock);
+    } else {
+        compute_block_checksum(ctx, get_block(ctx->fs_map, index));
+    }
+}
+
+void fs_commit(fs_context_t *ctx) {
+    dirty_set_t *dirty = &ctx->dirty;
+
+    // Dans un lot, seules les bitmaps attendent la fin : tout autre bloc (inode, données,
+    // superbloc, index) peut être vérifié par un autre processus dès que son verrou est rendu
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < dirty->count; i++) {
+        uint32_t index = dirty->list[i];
+        if (!((dirty->map[index / 8] >> (index % 8)) & 1)) continue;  // Déjà haché par fs_commit_alloc
+        if (ctx->deferred && block_in_bitmap(ctx->sb, index)) {
+            dirty->list[kept++] = index;
+            continue;
+        }
+        commit_block(ctx, index);
+    }
+    dirty->count = kept;
+}
+
+void fs_commit_alloc(fs_context_t *ctx) {
+    dirty_set_t *dirty = &ctx->dirty;
+    if (!dirty->map) return;
+
+    // Lot : bitmaps hachées à la fin
+    if (ctx->deferred) return;
+
+    // Blocs encore présents dans la liste : fs_commit les sautera, leur bit étant effacé
+    superblock_t *sb = ctx->sb;
+    uint32_t bitmap_blocks = (sb->num_blocks + BITMAP_BITS_PER_BLOCK - 1) / BITMAP_BITS_PER_BLOCK;
+    for (uint32_t index = sb->bitmap_start; index < sb->bitmap_start + bitmap_blocks; index++) {
+        if ((dirty->map[index / 8] >> (index % 8)) & 1) commit_block(ctx, index);
+    }
+}
+
 void fs_free_context(fs_context_t *ctx) {
     if (ctx) {
+        // Libérer l'état de l'allocateur (rend les blocs réservés non utilisés)
+        free_alloc_state(ctx);
+
+        // Contexte emprunté par une commande d'un lot : hacher ce qu'elle a modifié hors de tout
+        // verrou (superbloc rendu par l'allocateur...), puis rendre les bitmaps en attente au lot
+        if (ctx->resident && ctx->deferred) {
+            fs_commit(ctx);
+            resident_ctx->dirty = ctx->dirty;
+            memset(ctx, 0, sizeof(fs_context_t));
+            ctx->fd = -1;
+            return;
+        }
+
+        // Recalculer les sommes de contrôle différées avant de libérer la projection
+        if (ctx->fs_map && ctx->fs_map != MAP_FAILED) {
+            fs_commit(ctx);
+        }
+        free(ctx->dirty.map);
+        free(ctx->dirty.list);
+
+        // Contexte emprunté : la projection, le descripteur et le cache appartiennent au démon
+        if (ctx->resident) {
+            memset(ctx, 0, sizeof(fs_context_t));
+            ctx->fd = -1;
+            return;
+        }
+        verify_cache_close(ctx->verify_cache);
+
         // Libérer la projection mémoire
         if (ctx->fs_map && ctx->fs_map != MAP_FAILED) {
-            munmap(ctx->fs_map, (int) ctx->fs_size);
+            munmap(ctx->fs_map, (size_t) ctx->fs_size);
         }
 
         // Fermer le descripteur de fichier
@@ -65,8 +240,17 @@ void fs_free_context(fs_context_t *ctx) {
     }
 }
 
+void fs_sync(fs_context_t *ctx) {
+    if (ctx->deferred) return;
+
+    if (msync(ctx->fs_map, (size_t) ctx->fs_size, MS_SYNC) < 0) {
+        fs_error("Erreur msync : %s", strerror(errno));
+    }
+}
+
 int fs_verify(fs_context_t *ctx) {
     if (!ctx || !ctx->fs_map || !ctx->sb) {
+        errno = EINVAL;
         return -1;
     }
 
@@ -75,24 +259,45 @@ int fs_verify(fs_context_t *ctx) {
     // Vérifier la signature magique
     if (memcmp(ctx->sb->magic, "pignoufs", 8) != 0) {
         fs_error("Fichier conteneur non valide (signature incorrecte)\n");
+        errno = EINVAL;
         return -1;
     }
 
-    // Vérifier l'intégrité du superbloc
-    if (!verify_block_sha1(superblock)) {
-        fs_error("Fichier conteneur corrompu (superbloc)\n");
-        return -1;
+    // Vérifier l'intégrité du superbloc ; en cas d'échec, de nouveau sous son verrou (projection
+    // accessible en écriture) : une modification en cours (superblock_update_begin) est alors
+    // terminée et hachée
+    if (!verify_block_checksum(ctx, superblock)) {
+        int valid = 0;
+        if (!ctx->read_only) {
+            pthread_mutex_lock(superblock_lock(ctx->fs_map));
+            valid = verify_block_checksum(ctx, superblock);
+            pthread_mutex_unlock(superblock_lock(ctx->fs_map));
+        }
+        if (!valid) {
+            fs_error("Fichier conteneur corrompu (superbloc)\n");
+            errno = EIO;
+            return -1;
+        }
     }
 
     return 0;
 }
 
+void fs_silence_errors(int silenced) {
+    errors_silenced = silenced;
+}
+
 int fs_error(const char *format, ...) {
+    if (errors_silenced) return -1;
+
+    // errno positionné par l'appelant survit à l'affichage
+    int err = errno;
     va_list args;
     va_start(args, format);
     vfprintf(stderr, format, args);
     va_end(args);
     fprintf(stderr, "\n");
+    errno = err;
     return -1;
 }
 
@@ -102,7 +307,9 @@ int init_fs_context_and_verify(const char *fsname, fs_context_t *ctx, int flags)
     }
 
     if (fs_verify(ctx) < 0) {
+        int err = errno;
         fs_free_context(ctx);
+        errno = err;
         return -1;
     }
 
@@ -6,6 +6,7 @@
 /// Toute les fonctions type 'utils' pour le projet pourrait etre ici
 
 #include "../../include/fs_utils.h"
+#include <errno.h>
 
 int lock_file(int fd, int inode_number, int lock_type) {
     struct flock fl;
@@ -30,4 +31,25 @@ int read_lock_file(int fd, int inode_number) {
 
 int write_lock_file(int fd, int inode_number) {
     return lock_file(fd, inode_number, F_WRLCK);
-}
\ No newline at end of file
+}
+int write_all_iov(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        // Sauter les morceaux entièrement écrits, puis avancer dans le morceau entamé
+        while (count > 0 && (size_t) written >= iov->iov_len) {
+            written -= (ssize_t) iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *) iov->iov_base + written;
+            iov->iov_len -= (size_t) written;
+        }
+    }
+    return 0;
+}
@@ -4,16 +4,26 @@
 
 #include "inode_ops.h"
 #include "block_ops.h"
+#include "name_index.h"
+#include "inode_summary.h"
+#include "trigram_index.h"
+#include "fs_utils.h"
+#include <errno.h>
 
 
-int find_inode_by_name(void *addr, const char *filename) {
-    // Accéder correctement au superbloc
-    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+int find_inode_by_name(fs_context_t *ctx, const char *filename) {
+    void *addr = ctx->fs_map;
+    superblock_t *sb = ctx->sb;
+
+    // Utiliser l'index des noms s'il existe et n'est pas corrompu
+    if (sb->features & FS_FEATURE_NAME_INDEX) {
+        int inode_index = name_index_lookup(ctx, filename);
+        if (inode_index != NAME_INDEX_CORRUPT) return inode_index;
+    }
 
-    // Parcourir tous les blocs d'inodes
+    // Sinon parcourir toutes les places de la table des inodes
     for (uint32_t i = 0; i < sb->max_inodes; i++) {
-        block_t *inode_block = (block_t *) (addr + (sb->inode_start + i) * BLOCK_SIZE);
-        inode_t *inode = (inode_t *) inode_block->data;
+        inode_t *inode = get_inode(addr, (int) i);
 
         // Vérifier si l'inode existe et correspond au nom
         if ((inode->flags & PERM_EXISTS) && strcmp(inode->filename, filename) == 0) {
@@ -33,10 +43,58 @@ block_t *get_inode_block(void *addr, int inode_index) {
     }
 
     // Retourner le bloc correspondant à l'inode
-    return (block_t *) (addr + (sb->inode_start + inode_index) * BLOCK_SIZE);
+    return get_block(addr, (sb->inode_start + (uint32_t) inode_index / inodes_per_block(sb)));
+}
+
+inode_t *get_inode(void *addr, int inode_index) {
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    block_t *inode_block = get_inode_block(addr, inode_index);
+    if (!inode_block) return NULL;
+
+    uint32_t per_block = inodes_per_block(sb);
+    uint32_t slot_size = fs_data_size(addr) / per_block;
+    return (inode_t *) (inode_block->data + (uint32_t) inode_index % per_block * slot_size);
+}
+
+uint32_t inodes_per_block(const superblock_t *sb) {
+    return (sb->features & FS_FEATURE_PACKED_INODES) && sb->inodes_per_block > 0 ? sb->inodes_per_block : 1;
 }
 
-void set_inode_free(void *addr, int inode_index) {
+void inode_scan_init(inode_scan_t *scan, fs_context_t *ctx, int report) {
+    memset(scan, 0, sizeof(*scan));
+    scan->ctx = ctx;
+    scan->report = report;
+}
+
+inode_t *inode_scan_next(inode_scan_t *scan, int *inode_index) {
+    fs_context_t *ctx = scan->ctx;
+
+    while (scan->next < ctx->sb->max_inodes) {
+        int index = (int) scan->next++;
+        block_t *inode_block = get_inode_block(ctx->fs_map, index);
+        if (!inode_block) continue;
+
+        // Premier inode du bloc : vérifier le bloc pour tous ses inodes
+        if (inode_block != scan->block) {
+            scan->block = inode_block;
+            scan->block_ok = verify_block_checksum(ctx, inode_block);
+            if (!scan->block_ok && scan->report) {
+                fs_error("Erreur: Le bloc d'inode %d est corrompu\n", index);
+            }
+        }
+        if (!scan->block_ok) continue;
+
+        inode_t *inode = get_inode(ctx->fs_map, index);
+        if (inode->flags & PERM_EXISTS) {
+            *inode_index = index;
+            return inode;
+        }
+    }
+    return NULL;
+}
+
+void set_inode_free(fs_context_t *ctx, int inode_index) {
+    void *addr = ctx->fs_map;
     // Récupérer le bloc d'inode
     block_t *inode_block = get_inode_block(addr, inode_index);
     if (!inode_block) {
@@ -44,11 +102,102 @@ void set_inode_free(void *addr, int inode_index) {
     }
 
     // Réinitialiser l'inode
-    inode_t *inode = (inode_t *) inode_block->data;
+    inode_t *inode = get_inode(addr, inode_index);
     memset(inode, 0, sizeof(inode_t));
 
     // Mise à jour du SHA1 du bloc d'inode
-    compute_block_sha1(inode_block);
+    mark_block_dirty(ctx, inode_block);
+    inode_summary_update(ctx, inode_index, inode);
+
+    release_inode(ctx, inode_index);
+}
+
+// Nombre de mots de 64 bits (et d'inodes) couverts par un bloc de bitmap des inodes
+#define INODE_BITMAP_WORDS (DATA_SIZE / sizeof(uint64_t))
+#define INODE_BITMAP_BITS  (INODE_BITMAP_WORDS * 64)
+
+uint32_t inode_bitmap_blocks_for(uint32_t nb_inode) {
+    return (uint32_t) ((nb_inode + INODE_BITMAP_BITS - 1) / INODE_BITMAP_BITS);
+}
+
+int alloc_inode(fs_context_t *ctx) {
+    void *addr = ctx->fs_map;
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+
+    for (uint32_t b = 0; b < sb->inode_bitmap_blocks; b++) {
+        block_t *bitmap_block = get_block(addr, (sb->inode_bitmap_start + b));
+        uint64_t *words = (uint64_t *) bitmap_block->data;
+
+        for (uint32_t w = 0; w < INODE_BITMAP_WORDS; w++) {
+            uint64_t word = __atomic_load_n(&words[w], __ATOMIC_RELAXED);
+
+            // Un autre processus peut prendre le bit entre la lecture et le fetch_or :
+            // dans ce cas on réessaie sur le même mot
+            while (~word != 0) {
+                uint64_t mask = 1ULL << __builtin_ctzll(~word);
+                uint64_t old = __atomic_fetch_or(&words[w], mask, __ATOMIC_ACQ_REL);
+
+                if (!(old & mask)) {
+                    uint32_t inode_index = b * INODE_BITMAP_BITS + w * 64 + __builtin_ctzll(mask);
+                    mark_block_dirty(ctx, bitmap_block);
+                    return (int) inode_index;
+                }
+                word = old | mask;
+            }
+        }
+    }
+    return -1;
+}
+
+void release_inode(fs_context_t *ctx, int inode_index) {
+    void *addr = ctx->fs_map;
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    if (!(sb->features & FS_FEATURE_INODE_BITMAP)) return;
+    if (inode_index < 0 || inode_index >= (int) sb->max_inodes) return;
+
+    block_t *bitmap_block = get_block(addr, (sb->inode_bitmap_start + inode_index / INODE_BITMAP_BITS));
+    uint64_t *words = (uint64_t *) bitmap_block->data;
+    uint32_t bit = inode_index % INODE_BITMAP_BITS;
+
+    __atomic_fetch_and(&words[bit / 64], ~(1ULL << (bit % 64)), __ATOMIC_ACQ_REL);
+    mark_block_dirty(ctx, bitmap_block);
+}
+
+uint32_t sync_inode_bitmap(fs_context_t *ctx, int check_only) {
+    void *addr = ctx->fs_map;
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    if (!(sb->features & FS_FEATURE_INODE_BITMAP)) return 0;
+
+    uint32_t mismatches = 0;
+    for (uint32_t b = 0; b < sb->inode_bitmap_blocks; b++) {
+        block_t *bitmap_block = get_block(addr, (sb->inode_bitmap_start + b));
+        uint64_t *words = (uint64_t *) bitmap_block->data;
+        int modified = 0;
+
+        for (uint32_t bit = 0; bit < INODE_BITMAP_BITS; bit++) {
+            uint32_t inode_index = b * INODE_BITMAP_BITS + bit;
+
+            // Les bits au-delà du dernier inode restent toujours à 1
+            int used = 1;
+            if (inode_index < sb->max_inodes) {
+                inode_t *inode = get_inode(addr, (int) inode_index);
+                used = (inode->flags & PERM_EXISTS) != 0;
+            }
+
+            uint64_t mask = 1ULL << (bit % 64);
+            if (((words[bit / 64] & mask) != 0) == used) continue;
+
+            if (inode_index < sb->max_inodes) mismatches++;
+            if (!check_only) {
+                if (used) words[bit / 64] |= mask;
+                else words[bit / 64] &= ~mask;
+                modified = 1;
+            }
+        }
+
+        if (modified) mark_block_dirty(ctx, bitmap_block);
+    }
+    return mismatches;
 }
 
 
@@ -56,6 +205,170 @@ int check_permissions(inode_t *inode, uint32_t perm) {
     return (inode->flags & perm) == perm;
 }
 
+uint64_t inode_max_size(fs_context_t *ctx) {
+    uint64_t addressable = (uint64_t) block_map_max_blocks(ctx) * ctx->data_size;
+    if (!(ctx->sb->features & FS_FEATURE_LARGE_FILES) && addressable > UINT32_MAX) return UINT32_MAX;
+    return addressable;
+}
+
+uint32_t inode_inline_capacity(fs_context_t *ctx) {
+    if (!(ctx->sb->features & FS_FEATURE_INLINE_DATA)) return 0;
+    return ctx->data_size / inodes_per_block(ctx->sb) - (uint32_t) sizeof(inode_t);
+}
+
+/**
+ * Passe un fichier PERM_INLINE en stockage par blocs avant qu'il ne déborde du bloc d'inode :
+ * son contenu (toujours moins d'un bloc) est recopié dans un premier bloc de données
+ * L'appelant détient les verrous de l'inode et le rehache
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+static int leave_inline(fs_context_t *ctx, inode_t *inode) {
+    if (!(inode->flags & PERM_INLINE)) return 0;
+
+    uint32_t size = (uint32_t) inode_size(inode);
+    if (size > 0) {
+        uint32_t block_num = find_free_block(ctx);
+        block_t *data_block = block_num ? get_block(ctx->fs_map, block_num) : NULL;
+        if (!data_block) {
+            return fs_error("Espace insuffisant sur le système de fichiers");
+        }
+        memcpy(data_block->data, inode_inline_data(inode), size);
+        memset(data_block->data + size, 0, ctx->data_size - size);
+        BLOCK_META(ctx, data_block)->type = BLOCK_TYPE_DATA;
+        mark_block_dirty(ctx, data_block);
+        inode->direct_blocks[0] = block_num;
+    }
+
+    inode->flags &= ~PERM_INLINE;
+    return 0;
+}
+
+
+/**
+ * Vérifie un bloc d'inodes ; en cas d'échec, de nouveau une fois terminée l'écriture en cours
+ * (un inode_writer garde le verrou de lecture du bloc et ne rehache l'inode qu'à sa fermeture)
+ * @return 1 si le bloc est valide, 0 sinon
+ */
+static int verify_inode_block(fs_context_t *ctx, block_t *inode_block) {
+    if (verify_block_checksum(ctx, inode_block)) return 1;
+    if (ctx->read_only) return 0;
+
+    pthread_mutex_t *mutex_ptr = block_read_lock(ctx->fs_map, inode_block);
+    if (pthread_mutex_lock(mutex_ptr) != 0) return 0;
+    pthread_mutex_unlock(mutex_ptr);
+    return verify_block_checksum(ctx, inode_block);
+}
+
+/**
+ * Prépare la lecture d'un fichier : vérifie l'inode, attend la fin d'une écriture en cours,
+ * puis contrôle l'existence et le droit de lecture
+ * @param ctx Contexte du système de fichiers
+ * @param inode_index Index de l'inode à lire
+ * @param reader Lecteur à initialiser
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+int inode_reader_open(fs_context_t *ctx, int inode_index, inode_reader_t *reader) {
+    memset(reader, 0, sizeof(inode_reader_t));
+    reader->ctx = ctx;
+
+    block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
+    if (!inode_block || !verify_inode_block(ctx, inode_block)) {
+        return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
+    }
+
+    // On ne garde pas le verrou pendant la lecture : on attend seulement qu'aucune
+    // écriture ne soit en cours
+    pthread_mutex_t *mutex_ptr = block_read_lock(ctx->fs_map, inode_block);
+    if (pthread_mutex_lock(mutex_ptr) != 0) {
+        return fs_error("Erreur lors du verrouillage");
+    }
+    pthread_mutex_unlock(mutex_ptr);
+
+    // Récupérer les informations de l'inode
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
+
+    // Vérifier les permissions et l'existence
+    if (!(inode->flags & PERM_EXISTS)) {
+        return fs_error("Le fichier n'existe pas");
+    }
+
+    if (!check_permissions(inode, PERM_READ)) {
+        return fs_error("Permission de lecture refusée");
+    }
+
+    reader->inode = inode;
+    reader->size = inode_size(inode);
+
+    // Les blocs d'indirection ne sont lus (et vérifiés) qu'au premier bloc qui en dépend
+    block_map_init(&reader->map, ctx, inode);
+    return 0;
+}
+
+/**
+ * Bloc de données de rang n du fichier (NULL si la référence est absente)
+ */
+static block_t *inode_reader_block(inode_reader_t *reader, uint32_t n, uint32_t *block_num) {
+    uint32_t *ref = block_map_slot(&reader->map, n, 0);
+    *block_num = ref ? *ref : 0;
+    return *block_num ? get_block(reader->ctx->fs_map, *block_num) : NULL;
+}
+
+void inode_reader_seek(inode_reader_t *reader, uint64_t offset, uint64_t length) {
+    if (offset > reader->size) offset = reader->size;
+    if (length < reader->size - offset) reader->size = offset + length;
+
+    reader->offset = offset;
+    reader->next_block = (uint32_t) (offset / reader->ctx->data_size);
+}
+
+int inode_reader_next(inode_reader_t *reader, struct iovec *iov, int max_iov) {
+    fs_context_t *ctx = reader->ctx;
+    block_t *data_blocks[INODE_READER_IOV];
+    uint32_t block_nums[INODE_READER_IOV];
+    int count = 0;
+
+    if (max_iov > INODE_READER_IOV) max_iov = INODE_READER_IOV;
+
+    // Contenu dans le bloc d'inode, déjà vérifié à l'ouverture : un seul morceau
+    if (reader->inode->flags & PERM_INLINE) {
+        if (reader->offset >= reader->size || max_iov < 1) return 0;
+        iov[0].iov_base = inode_inline_data(reader->inode) + reader->offset;
+        iov[0].iov_len = reader->size - reader->offset;
+        reader->offset = reader->size;
+        return 1;
+    }
+
+    // Rassembler les blocs suivants, dans l'ordre du fichier
+    // Seul le premier bloc peut être entamé (après inode_reader_seek) : une seule division par appel
+    uint32_t data_size = ctx->data_size;
+    uint64_t offset = reader->offset;
+    uint32_t within = (uint32_t) (offset % data_size);
+    while (count < max_iov && offset < reader->size) {
+        uint32_t block_num;
+        data_blocks[count] = inode_reader_block(reader, reader->next_block + (uint32_t) count, &block_num);
+        if (!data_blocks[count]) {
+            return fs_error("Erreur lors de l'accès au bloc de données %d", block_num);
+        }
+        block_nums[count] = block_num;
+
+        uint32_t len = reader->size - offset < data_size - within ? (uint32_t) (reader->size - offset) : data_size - within;
+        iov[count].iov_base = data_blocks[count]->data + within;
+        iov[count].iov_len = len;
+        offset += len;
+        within = 0;
+        count++;
+    }
+
+    // Vérifier le lot avant de rendre les pointeurs (hachage multi-buffer)
+    int corrupted = verify_blocks_checksum(ctx, data_blocks, (uint32_t) count);
+    if (corrupted >= 0) {
+        return fs_error("Erreur : bloc de données %d corrompu", block_nums[corrupted]);
+    }
+
+    reader->next_block += (uint32_t) count;
+    reader->offset = offset;
+    return count;
+}
 
 /**
  * Lit le contenu complet d'un fichier à partir de son inode
@@ -70,168 +383,419 @@ int read_inode_content(fs_context_t *ctx, int inode_index, char **buffer, uint32
     *buffer = NULL;
     *size = 0;
 
-    block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
-    if (!inode_block || !verify_block_sha1(inode_block)) {
-        return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
+    inode_reader_t reader;
+    if (inode_reader_open(ctx, inode_index, &reader) < 0) {
+        return -1;
+    }
+    if (reader.size > UINT32_MAX) {
+        return fs_error("Fichier trop volumineux pour être chargé en mémoire");
     }
 
-    int result = 0;
-    int mutex_locked = 0;
+    // Allouer un buffer pour stocker le contenu complet du fichier
+    // (au moins 1 octet : un fichier vide rend un buffer vide mais valide)
+    *buffer = malloc(reader.size ? reader.size : 1);
+    if (!*buffer) {
+        return fs_error("Erreur d'allocation mémoire");
+    }
+    (*buffer)[0] = '\0';
+
+    struct iovec iov[INODE_READER_IOV];
+    int count;
+    while ((count = inode_reader_next(&reader, iov, INODE_READER_IOV)) > 0) {
+        for (int i = 0; i < count; i++) {
+            memcpy(*buffer + *size, iov[i].iov_base, iov[i].iov_len);
+            *size += (uint32_t) iov[i].iov_len;
+        }
+    }
 
-    pthread_mutex_t *mutex_ptr = (pthread_mutex_t *) inode_block->lock_read;
+    if (count < 0) {
+        free(*buffer);
+        *buffer = NULL;
+        *size = 0;
+        return -1;
+    }
+    return 0;
+}
 
-    // On ne verrouille jamais pour la lecture, on vérifie juste s'il est libre
-    // Si le trylock réussit, cela signifie qu'aucune écriture n'est en cours
-    int lock_result = pthread_mutex_trylock(mutex_ptr);
+/// E/S parallèles : la liste des blocs d'un fichier est découpée en plages disjointes,
+/// chacune traitée par un thread (le hachage, pas la mémoire, limite le débit)
 
-    if (lock_result == 0) {
-        // Le verrou était libre, on l'a obtenu
-        // On le libère immédiatement car on n'en a pas besoin pour la lecture
-        pthread_mutex_unlock(mutex_ptr);
-    } else {
-        // Le verrou est occupé, on attend
-        int wait_result = pthread_mutex_lock(mutex_ptr);
-        if (wait_result != 0) {
-            result = fs_error("Erreur lors du verrouillage");
-            goto cleanup;
+// Nombre maximal de threads d'E/S, et nombre minimal de blocs confiés à chacun
+#define IO_MAX_THREADS 16
+#define IO_MIN_BLOCKS_PER_THREAD 32
+
+int io_thread_count(uint32_t blocks) {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *forced = getenv("PIGNOUFS_THREADS");
+    if (forced && atoi(forced) > 0) threads = atoi(forced);
+
+    if (threads > IO_MAX_THREADS) threads = IO_MAX_THREADS;
+    if (threads > (long) (blocks / IO_MIN_BLOCKS_PER_THREAD)) threads = blocks / IO_MIN_BLOCKS_PER_THREAD;
+    return threads < 1 ? 1 : (int) threads;
+}
+
+typedef struct {
+    void (*work)(void *arg, uint32_t first, uint32_t last);
+    void *arg;
+    uint32_t first;
+    uint32_t last;
+} io_range_t;
+
+static void *io_range_thread(void *arg) {
+    io_range_t *range = (io_range_t *) arg;
+    range->work(range->arg, range->first, range->last);
+    return NULL;
+}
+
+void run_io_ranges(uint32_t count, int threads, void (*work)(void *, uint32_t, uint32_t), void *arg) {
+    if (threads <= 1 || count < 2) {
+        work(arg, 0, count);
+        return;
+    }
+
+    pthread_t tids[IO_MAX_THREADS];
+    io_range_t ranges[IO_MAX_THREADS];
+    int started = 0;
+    uint32_t per_thread = (count + threads - 1) / threads;
+
+    for (uint32_t first = 0; first < count; first += per_thread) {
+        uint32_t last = first + per_thread < count ? first + per_thread : count;
+
+        if (last < count) {
+            ranges[started] = (io_range_t) {work, arg, first, last};
+            if (pthread_create(&tids[started], NULL, io_range_thread, &ranges[started]) == 0) {
+                started++;
+                continue;
+            }
         }
+        work(arg, first, last);
     }
 
-    // Variable pour suivre si on a verrouillé avec succès
-    mutex_locked = 1;
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
 
-    // Récupérer les informations de l'inode
-    inode_t *inode = (inode_t *) inode_block->data;
+typedef struct {
+    fs_context_t *ctx;
+    block_t **blocks;
+    char *buffer;
+    uint32_t size;
+    int corrupted;          // Plus petit rang de bloc corrompu (INT32_MAX si aucun)
+} read_work_t;
+
+static void read_range(void *arg, uint32_t first, uint32_t last) {
+    read_work_t *work = (read_work_t *) arg;
+
+    int bad = verify_blocks_checksum(work->ctx, work->blocks + first, last - first);
+    if (bad >= 0) {
+        int position = (int) first + bad;
+        int seen = __atomic_load_n(&work->corrupted, __ATOMIC_RELAXED);
+        while (position < seen
+               && !__atomic_compare_exchange_n(&work->corrupted, &seen, position, 0, __ATOMIC_RELAXED,
+                                               __ATOMIC_RELAXED)) {}
+        return;
+    }
 
-    // Vérifier les permissions et l'existence
-    if (!(inode->flags & PERM_EXISTS)) {
-        result = fs_error("Le fichier n'existe pas");
-        goto cleanup;
+    for (uint32_t i = first; i < last; i++) {
+        uint32_t offset = i * work->ctx->data_size;
+        uint32_t len = work->size - offset < work->ctx->data_size ? work->size - offset : work->ctx->data_size;
+        memcpy(work->buffer + offset, work->blocks[i]->data, len);
     }
+}
 
-    if (!check_permissions(inode, PERM_READ)) {
-        result = fs_error("Permission de lecture refusée");
-        goto cleanup;
+int read_inode_content_threaded(fs_context_t *ctx, int inode_index, char **buffer, uint32_t *size) {
+    *buffer = NULL;
+    *size = 0;
+
+    inode_reader_t reader;
+    if (inode_reader_open(ctx, inode_index, &reader) < 0) {
+        return -1;
+    }
+    if (reader.size > UINT32_MAX) {
+        return fs_error("Fichier trop volumineux pour être chargé en mémoire");
+    }
+    if (reader.inode->flags & PERM_INLINE) {
+        return read_inode_content(ctx, inode_index, buffer, size);  // Aucun bloc à répartir
     }
 
-    // Allouer un buffer pour stocker le contenu complet du fichier
-    *size = inode->size;
-    if (*size == 0) {
-        // Si le fichier est vide, retourner un buffer vide mais valide
-        *buffer = malloc(1);  // Allouer au moins 1 octet
-        if (!*buffer) {
-            result = fs_error("Erreur d'allocation mémoire");
+    // Résoudre toute la liste des blocs avant de lancer les threads
+    uint32_t block_count = (uint32_t) ((reader.size + ctx->data_size - 1) / ctx->data_size);
+    block_t **blocks = malloc((block_count + 1) * sizeof(block_t *));
+    uint32_t *block_nums = malloc((block_count + 1) * sizeof(uint32_t));
+    int result = 0;
+    if (!blocks || !block_nums) {
+        result = fs_error("Erreur d'allocation mémoire");
+        goto cleanup;
+    }
+    for (uint32_t i = 0; i < block_count; i++) {
+        blocks[i] = inode_reader_block(&reader, i, &block_nums[i]);
+        if (!blocks[i]) {
+            result = fs_error("Erreur lors de l'accès au bloc de données %d", block_nums[i]);
             goto cleanup;
         }
-        (*buffer)[0] = '\0';
-        goto cleanup;  // Succès avec un fichier vide
     }
 
-    *buffer = malloc(*size);
+    *buffer = malloc(reader.size ? reader.size : 1);
     if (!*buffer) {
         result = fs_error("Erreur d'allocation mémoire");
         goto cleanup;
     }
+    (*buffer)[0] = '\0';
 
-    uint32_t bytes_read = 0;
-    uint32_t remaining = inode->size;
+    // Créer le cache de vérification avant que les threads ne le partagent
+    verify_blocks_checksum(ctx, blocks, 0);
 
-    // Parcourir les blocs directs
-    for (int i = 0; i < 10 && remaining > 0; i++) {
-        uint32_t block_num = inode->direct_blocks[i];
-        if (block_num == 0) {
-            break;  // Fin des blocs directs
+    read_work_t work = {ctx, blocks, *buffer, (uint32_t) reader.size, INT32_MAX};
+    run_io_ranges(block_count, io_thread_count(block_count), read_range, &work);
+
+    if (work.corrupted != INT32_MAX) {
+        free(*buffer);
+        *buffer = NULL;
+        result = fs_error("Erreur : bloc de données %d corrompu", block_nums[work.corrupted]);
+        goto cleanup;
+    }
+
+    *size = (uint32_t) reader.size;
+
+    cleanup:
+    free(blocks);
+    free(block_nums);
+    return result;
+}
+
+int stream_inode_content(fs_context_t *ctx, int inode_index, int fd, uint64_t *written) {
+    return stream_inode_range(ctx, inode_index, fd, 0, UINT64_MAX, written);
+}
+
+int stream_inode_range(fs_context_t *ctx, int inode_index, int fd, uint64_t offset, uint64_t length,
+                       uint64_t *written) {
+    *written = 0;
+
+    inode_reader_t reader;
+    if (inode_reader_open(ctx, inode_index, &reader) < 0) {
+        return -1;
+    }
+    inode_reader_seek(&reader, offset, length);
+    uint64_t start = reader.offset;
+
+    // Les iovecs pointent directement dans la projection : aucune copie intermédiaire
+    struct iovec iov[INODE_READER_IOV];
+    int count;
+    while ((count = inode_reader_next(&reader, iov, INODE_READER_IOV)) > 0) {
+        if (write_all_iov(fd, iov, count) < 0) {
+            return fs_error("Erreur lors de l'écriture des données");
         }
+    }
 
-        block_t *data_block = get_block(ctx->fs_map, (int) block_num);
-        if (!data_block || !verify_block_sha1(data_block)) {
-            result = fs_error("Erreur lors de l'accès au bloc de données %d ou bloc corrompu", block_num);
-            goto cleanup;
+    if (count < 0) return -1;
+    *written = reader.offset - start;
+    return 0;
+}
+
+int read_inode_at(fs_context_t *ctx, int inode_index, char *buffer, uint32_t length, uint64_t offset,
+                  uint32_t *bytes_read) {
+    *bytes_read = 0;
+
+    inode_reader_t reader;
+    if (inode_reader_open(ctx, inode_index, &reader) < 0) {
+        return -1;
+    }
+    inode_reader_seek(&reader, offset, length);
+
+    // Seuls les blocs couvrant la plage sont vérifiés et copiés
+    struct iovec iov[INODE_READER_IOV];
+    int count;
+    while ((count = inode_reader_next(&reader, iov, INODE_READER_IOV)) > 0) {
+        for (int i = 0; i < count; i++) {
+            memcpy(buffer + *bytes_read, iov[i].iov_base, iov[i].iov_len);
+            *bytes_read += (uint32_t) iov[i].iov_len;
         }
+    }
+    return count < 0 ? -1 : 0;
+}
 
-        uint32_t to_read = (remaining < DATA_SIZE) ? remaining : DATA_SIZE;
-        memcpy(*buffer + bytes_read, data_block->data, to_read);
+// Un nouveau bloc de données à remplir par l'écriture
+typedef struct {
+    block_t *block;
+    const char *src;
+    uint32_t len;
+} write_job_t;
+
+/**
+ * Remplit un nouveau bloc de données et calcule sa somme de contrôle
+ * (pendant que les données sont encore en cache)
+ */
+static void fill_data_block(fs_context_t *ctx, const write_job_t *job) {
+    block_t *data_block = job->block;
 
-        bytes_read += to_read;
-        remaining -= to_read;
+    memcpy(data_block->data, job->src, job->len);
+    if (job->len < ctx->data_size) {
+        memset(data_block->data + job->len, 0, ctx->data_size - job->len);
     }
+    BLOCK_META(ctx, data_block)->type = BLOCK_TYPE_DATA;
+    compute_block_checksum(ctx, data_block);
+}
 
-    // Traiter le bloc d'indirection si nécessaire
-    if (remaining > 0 && inode->indirect_block != 0) {
-        // Récupérer le bloc d'indirection
-        block_t *indirect_block = get_block(ctx->fs_map, (int) inode->indirect_block);
-        if (!indirect_block || !verify_block_sha1(indirect_block)) {
-            result = fs_error("Erreur lors de l'accès au bloc d'indirection ou bloc corrompu");
-            goto cleanup;
-        }
+typedef struct {
+    fs_context_t *ctx;
+    const write_job_t *jobs;
+} fill_work_t;
 
-        // Parcourir les références aux blocs de données dans le bloc d'indirection
-        uint32_t *block_refs = (uint32_t *) indirect_block->data;
-        int max_refs = DATA_SIZE / sizeof(uint32_t);  // Nombre max de références
+static void fill_range(void *arg, uint32_t first, uint32_t last) {
+    fill_work_t *work = (fill_work_t *) arg;
+    for (uint32_t i = first; i < last; i++) {
+        fill_data_block(work->ctx, &work->jobs[i]);
+    }
+}
 
-        for (int i = 0; i < max_refs && remaining > 0; i++) {
-            uint32_t block_num = block_refs[i];
-            if (block_num == 0) {
-                break;  // Fin des blocs référencés
-            }
+/**
+ * Corps de write_locked_inode : alloue les blocs en remplissant jobs, puis les remplit
+ */
+static int fill_locked_inode(fs_context_t *ctx, inode_t *inode, const char *data, uint32_t size, int append,
+                             int threaded, write_job_t *jobs) {
+    uint32_t job_count = 0;
 
-            block_t *data_block = get_block(ctx->fs_map, (int) block_num);
-            if (!data_block || !verify_block_sha1(data_block)) {
-                result = fs_error("Erreur lors de l'accès au bloc de données %d (indirect) ou bloc corrompu",
-                                  block_num);
-                goto cleanup;
-            }
+    uint64_t original_size = append ? inode_size(inode) : 0;
+    uint64_t total_size = original_size + size;
+    uint32_t current_blocks = (uint32_t) ((original_size + ctx->data_size - 1) / ctx->data_size);
 
-            uint32_t to_read = (remaining < DATA_SIZE) ? remaining : DATA_SIZE;
-            memcpy(*buffer + bytes_read, data_block->data, to_read);
+    if (total_size > inode_max_size(ctx)) {
+        return fs_error("Espace insuffisant pour écrire toutes les données");
+    }
 
-            bytes_read += to_read;
-            remaining -= to_read;
-        }
+    // Tant que le fichier tient dans son inode, aucune allocation
+    if ((inode->flags & PERM_INLINE) && total_size <= inode_inline_capacity(ctx)) {
+        memcpy(inode_inline_data(inode) + original_size, data, size);
+        inode_set_size(inode, total_size);
+        return 0;
     }
 
-    // Si toutes les données n'ont pas été lues avec succès
-    if (bytes_read != inode->size) {
-        result = fs_error("Attention: seulement %u octets lus sur %u", bytes_read, inode->size);
+    uint32_t missing = blocks_to_allocate(ctx, original_size, total_size);
+    uint32_t reserved = reserved_block_count(ctx);
+    if (missing > ctx->sb->num_free_blocks + reserved) {
+        return fs_error("Espace insuffisant sur le système de fichiers");
     }
 
-    cleanup:
-    // Déverrouiller le mutex avant de quitter
-    if (mutex_locked) {
-        pthread_mutex_unlock(mutex_ptr);
+    // Blocs pas encore réservés par l'appelant : pris d'un coup, le superbloc n'est modifié
+    // (et rehaché) qu'une fois ; en cas d'échec, find_free_block les cherche un par un
+    if (missing > reserved) {
+        reserve_blocks(ctx, missing - reserved);
+    }
+    if (leave_inline(ctx, inode) < 0) {
+        return -1;
     }
 
-    // Nettoyer le buffer si une erreur s'est produite
-    if (result != 0 && *buffer != NULL) {
-        free(*buffer);
-        *buffer = NULL;
-        *size = 0;
+    block_map_t map;
+    block_map_init(&map, ctx, inode);
+    uint32_t bytes_written = 0, remaining = size;
+
+    // Compléter d'abord le dernier bloc entamé
+    uint32_t last_block_position = (uint32_t) (original_size % ctx->data_size);
+    if (append && last_block_position > 0) {
+        uint32_t *ref = block_map_slot(&map, current_blocks - 1, 0);
+        block_t *last_block = ref && *ref ? get_block(ctx->fs_map, *ref) : NULL;
+        if (!last_block || !verify_block_checksum(ctx, last_block)) {
+            return fs_error("Erreur lors de l'accès au dernier bloc ou bloc corrompu");
+        }
+
+        uint32_t space_left = ctx->data_size - last_block_position;
+        uint32_t to_write = (remaining < space_left) ? remaining : space_left;
+
+        memcpy(last_block->data + last_block_position, data, to_write);
+        mark_block_dirty(ctx, last_block);
+
+        bytes_written += to_write;
+        remaining -= to_write;
     }
 
+    // Nouveaux blocs, alloués dans l'ordre du fichier (blocs d'indirection créés au passage)
+    for (uint32_t n = current_blocks; remaining > 0; n++) {
+        uint32_t *ref = block_map_slot(&map, n, 1);
+        if (!ref) {
+            return -1;  // L'erreur a déjà été affichée
+        }
+
+        uint32_t block_num = find_free_block(ctx);
+        if (block_num == 0) {
+            return fs_error("Erreur lors de l'allocation d'un bloc de données");
+        }
+#ifdef DEBUG
+        printf("[DEBUG] Bloc alloué (rang %u): %u\n", n, block_num);
+#endif
+        *ref = block_num;
+
+        block_t *data_block = get_block(ctx->fs_map, block_num);
+        if (!data_block) {
+            return fs_error("Erreur lors de l'accès à un bloc de données");
+        }
+
+        uint32_t to_write = (remaining < ctx->data_size) ? remaining : ctx->data_size;
+        jobs[job_count++] = (write_job_t) {data_block, data + bytes_written, to_write};
+
+        bytes_written += to_write;
+        remaining -= to_write;
+    }
+
+    // Tous les blocs sont alloués : superbloc et bitmaps rehachés, puis les remplir (plages
+    // disjointes, un thread par plage)
+    fs_commit_alloc(ctx);
+    fill_work_t work = {ctx, jobs};
+    run_io_ranges(job_count, threaded ? io_thread_count(job_count) : 1, fill_range, &work);
+
+    // Mettre à jour la taille de l'inode uniquement si tout s'est bien passé
+    inode_set_size(inode, total_size);
+    return 0;
+}
+
+/**
+ * Écrit des données dans un fichier dont l'appelant détient les verrous
+ * Les blocs sont tous alloués d'abord, puis remplis (en parallèle si demandé)
+ * @param ctx Contexte du système de fichiers
+ * @param inode Inode du fichier
+ * @param data Données à écrire
+ * @param size Taille des données à écrire
+ * @param append Mode d'écriture (0: écrasement d'un fichier vidé, 1: ajout)
+ * @param threaded Répartir le remplissage entre plusieurs threads
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+static int write_locked_inode(fs_context_t *ctx, inode_t *inode, const char *data, uint32_t size, int append,
+                              int threaded) {
+    // Un bloc par tranche de données, plus le dernier bloc entamé (sa taille dépend de la géométrie)
+    write_job_t *jobs = malloc((size / ctx->data_size + 2) * sizeof(write_job_t));
+    if (!jobs) {
+        return fs_error("Erreur d'allocation mémoire");
+    }
+    int result = fill_locked_inode(ctx, inode, data, size, append, threaded, jobs);
+    free(jobs);
     return result;
 }
 
 /**
  * Écrit des données dans un fichier à partir de son inode
+ * Les blocs sont d'abord tous alloués (dans l'ordre du fichier), puis remplis et hachés,
+ * éventuellement par plusieurs threads sur des plages disjointes
  * @param ctx Contexte du système de fichiers
  * @param inode_index Index de l'inode à utiliser
  * @param data Données à écrire
  * @param size Taille des données à écrire
  * @param append Mode d'écriture (0: écrasement, 1: ajout)
+ * @param threaded Répartir le remplissage entre plusieurs threads
  * @return 0 en cas de succès, -1 en cas d'erreur
  */
-int write_inode_content(fs_context_t *ctx, int inode_index, const char *data, uint32_t size, int append) {
+static int write_inode_blocks(fs_context_t *ctx, int inode_index, const char *data, uint32_t size, int append,
+                              int threaded) {
     block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
-    if (!inode_block || !verify_block_sha1(inode_block)) {
+    if (!inode_block || !verify_block_checksum(ctx, inode_block)) {
         return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
     }
 
     int result = 0;
     int mutex_locked = 0;
 
-    inode_t *inode = (inode_t *) inode_block->data;
-    pthread_mutex_t *mutex_ptr = (pthread_mutex_t *) inode_block->lock_write;
-    pthread_mutex_t *mutex_ptr_r = (pthread_mutex_t *) inode_block->lock_read;
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
+    pthread_mutex_t *mutex_ptr = block_write_lock(ctx->fs_map, inode_block);
+    pthread_mutex_t *mutex_ptr_r = block_read_lock(ctx->fs_map, inode_block);
 
     pthread_mutex_lock(mutex_ptr_r);
 
@@ -252,291 +816,537 @@ int write_inode_content(fs_context_t *ctx, int inode_index, const char *data, ui
         goto cleanup;
     }
 
-    uint32_t original_size = append ? inode->size : 0;
-    uint32_t total_size = original_size + size;
+    result = write_locked_inode(ctx, inode, data, size, append, threaded);
 
-    uint32_t current_blocks = (original_size + DATA_SIZE - 1) / DATA_SIZE;
-    uint32_t total_blocks = (total_size + DATA_SIZE - 1) / DATA_SIZE;
-    uint32_t blocks_needed = total_blocks - current_blocks;
+    cleanup:
+    // Les SHA1 différés doivent être à jour avant qu'un autre processus ne relise l'inode
+    mark_block_dirty(ctx, inode_block);
+    inode_summary_update(ctx, inode_index, inode);
+    fs_commit(ctx);
 
-    if (blocks_needed > ctx->sb->num_free_blocks) {
-        result = fs_error("Espace insuffisant sur le système de fichiers");
-        goto cleanup;
+    // Déverrouiller le mutex s'il a été verrouillé
+    if (mutex_locked) {
+        pthread_mutex_unlock(mutex_ptr_r);
+        pthread_mutex_unlock(mutex_ptr);
     }
 
-    uint32_t bytes_written = 0, remaining = size;
+    return result;
+}
 
-    int direct_blocks_used = 0;
-    for (int i = 0; i < 10; i++) {
-        if (inode->direct_blocks[i] != 0) direct_blocks_used++;
-        else break;
-    }
+int write_inode_content(fs_context_t *ctx, int inode_index, const char *data, uint32_t size, int append) {
+    return write_inode_blocks(ctx, inode_index, data, size, append, 0);
+}
 
-    uint32_t last_block_position = 0;
-    if (append && original_size > 0) {
-        last_block_position = original_size % DATA_SIZE;
+int write_inode_content_threaded(fs_context_t *ctx, int inode_index, const char *data, uint32_t size, int append) {
+    return write_inode_blocks(ctx, inode_index, data, size, append, 1);
+}
+
+/**
+ * Modifie sur place les octets [offset, offset + size[ d'un fichier, déjà couverts par ses blocs
+ * Les blocs dont une partie utile est conservée sont vérifiés avant d'être modifiés (sinon une
+ * corruption serait scellée par le nouveau haché) ; les blocs entièrement remplacés ne le sont
+ * pas. Seuls les blocs touchés sont marqués à rehacher
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+static int patch_inode_blocks(fs_context_t *ctx, inode_t *inode, const char *data, uint32_t size, uint64_t offset) {
+    uint32_t first = (uint32_t) (offset / ctx->data_size);
+    uint32_t last = (uint32_t) ((offset + size - 1) / ctx->data_size);
+    uint64_t file_size = inode_size(inode);
+
+    if (inode->flags & PERM_INLINE) {
+        memcpy(inode_inline_data(inode) + offset, data, size);
+        return 0;  // L'appelant rehache le bloc d'inode
     }
 
-    if (append && original_size > 0 && last_block_position > 0) {
-        uint32_t block_num;
+    block_map_t map;
+    block_map_init(&map, ctx, inode);
+
+    block_t *blocks[INODE_READER_IOV];
+    uint32_t block_nums[INODE_READER_IOV];
+    block_t *partial[2];
+    uint32_t partial_nums[2];
+    for (uint32_t batch = first; batch <= last; batch += INODE_READER_IOV) {
+        uint32_t count = last - batch + 1 < INODE_READER_IOV ? last - batch + 1 : INODE_READER_IOV;
+        uint32_t partial_count = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t n = batch + i;
+            uint32_t *ref = block_map_slot(&map, n, 0);
+            block_nums[i] = ref ? *ref : 0;
+            blocks[i] = block_nums[i] ? get_block(ctx->fs_map, block_nums[i]) : NULL;
+            if (!blocks[i]) {
+                return fs_error("Erreur lors de l'accès au bloc de données %d", block_nums[i]);
+            }
 
-        if (direct_blocks_used < 10) {
-            block_num = inode->direct_blocks[direct_blocks_used - 1];
-        } else {
-            block_t *indirect_block = get_block(ctx->fs_map, (int) inode->indirect_block);
-            if (!indirect_block || !verify_block_sha1(indirect_block)) {
-                result = fs_error("Erreur lors de l'accès au bloc d'indirection ou bloc corrompu");
-                goto cleanup;
+            // Seuls le premier et le dernier bloc de la plage peuvent garder des octets utiles
+            uint64_t block_start = (uint64_t) n * ctx->data_size;
+            uint64_t block_end = block_start + ctx->data_size < file_size ? block_start + ctx->data_size : file_size;
+            if (offset > block_start || offset + size < block_end) {
+                if (n == first || n == last) {
+                    partial[partial_count] = blocks[i];
+                    partial_nums[partial_count++] = block_nums[i];
+                }
             }
+        }
 
-            uint32_t *block_refs = (uint32_t *) indirect_block->data;
-            int indirect_index = (int) (original_size - 10 * DATA_SIZE + DATA_SIZE - 1) / DATA_SIZE - 1;
-            block_num = block_refs[indirect_index];
+        int corrupted = verify_blocks_checksum(ctx, partial, partial_count);
+        if (corrupted >= 0) {
+            return fs_error("Erreur : bloc de données %d corrompu", partial_nums[corrupted]);
         }
 
-        block_t *last_block = get_block(ctx->fs_map, (int) block_num);
-        if (!last_block || !verify_block_sha1(last_block)) {
-            result = fs_error("Erreur lors de l'accès au dernier bloc ou bloc corrompu");
-            goto cleanup;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t within = (uint32_t) (offset % ctx->data_size);
+            uint32_t len = size < ctx->data_size - within ? size : ctx->data_size - within;
+            memcpy(blocks[i]->data + within, data, len);
+            mark_block_dirty(ctx, blocks[i]);
+
+            data += len;
+            offset += len;
+            size -= len;
         }
+    }
+    return 0;
+}
 
-        uint32_t space_left = DATA_SIZE - last_block_position;
-        uint32_t to_write = (remaining < space_left) ? remaining : space_left;
+/**
+ * Écrit à une position d'un fichier dont l'appelant détient les verrous : partie couverte
+ * modifiée sur place, puis trou éventuel rempli de zéros et ajout du reste
+ * @param grown Mis à 1 si le fichier a grandi (l'inode est à rehacher)
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+static int write_at_locked(fs_context_t *ctx, inode_t *inode, const char *data, uint32_t size, uint64_t offset,
+                           int *grown) {
+    // Partie déjà couverte par le fichier : modifiée sur place, sans allocation
+    uint64_t file_size = inode_size(inode);
+    uint32_t in_place = offset < file_size ? (size < file_size - offset ? size : (uint32_t) (file_size - offset)) : 0;
+    if (in_place > 0 && patch_inode_blocks(ctx, inode, data, in_place, offset) < 0) {
+        return -1;
+    }
 
-        memcpy(last_block->data + last_block_position, data, to_write);
-        compute_block_sha1(last_block);
+    // Au-delà de la fin : trou éventuel rempli de zéros (par morceaux : il peut dépasser la mémoire),
+    // puis ajout du reste
+    if (offset > file_size) {
+        uint64_t hole = offset - file_size;
+        uint32_t chunk = hole < INODE_WRITER_CHUNK ? (uint32_t) hole : INODE_WRITER_CHUNK;
+        char *zeros = calloc(chunk, 1);
+        if (!zeros) {
+            return fs_error("Erreur d'allocation mémoire");
+        }
+        *grown = 1;
+        int result = 0;
+        while (result == 0 && hole > 0) {
+            uint32_t len = hole < chunk ? (uint32_t) hole : chunk;
+            result = write_locked_inode(ctx, inode, zeros, len, 1, 0);
+            hole -= len;
+        }
+        free(zeros);
+        if (result < 0) return -1;
+    }
+    if (size > in_place) {
+        *grown = 1;
+        return write_locked_inode(ctx, inode, data + in_place, size - in_place, 1, 0);
+    }
+    return 0;
+}
 
-        bytes_written += to_write;
-        remaining -= to_write;
+/**
+ * Raccourcit un fichier dont l'appelant détient les verrous : seuls les blocs au-delà de la
+ * nouvelle taille sont rendus à la bitmap (et les blocs d'indirection qui ne servent plus) ;
+ * un fichier qui tient alors dans son inode y est ramené
+ * @return 0 en cas de succès, -1 en cas d'erreur
+ */
+static int truncate_locked(fs_context_t *ctx, inode_t *inode, uint64_t new_size) {
+    if (new_size >= inode_size(inode)) return 0;
+
+    // Ce qui reste tient dans l'inode : le ramener du premier bloc et rendre tous les blocs
+    if (!(inode->flags & PERM_INLINE) && new_size <= inode_inline_capacity(ctx)) {
+        block_t *first_block = new_size > 0 ? get_block(ctx->fs_map, inode->direct_blocks[0]) : NULL;
+        if (new_size > 0 && (inode->direct_blocks[0] == 0 || !first_block || !verify_block_checksum(ctx, first_block))) {
+            return fs_error("Erreur lors de l'accès au premier bloc ou bloc corrompu");
+        }
+        if (first_block) memcpy(inode_inline_data(inode), first_block->data, new_size);
+        if (block_map_truncate(ctx, inode, 0) < 0) {
+            return -1;
+        }
+        inode->flags |= PERM_INLINE;
     }
 
-    int block_index = append ? direct_blocks_used : 0;
+    if (inode->flags & PERM_INLINE) {
+        inode_set_size(inode, new_size);
+        return 0;
+    }
 
-    while (remaining > 0 && block_index < 10) {
-        uint32_t block_num;
+    uint32_t new_blocks = (uint32_t) ((new_size + ctx->data_size - 1) / ctx->data_size);
+    if (block_map_truncate(ctx, inode, new_blocks) < 0) {
+        return -1;
+    }
 
-        if (!append || block_index >= direct_blocks_used) {
-            block_num = find_free_block(ctx->fs_map, ctx->sb);
-            if (block_num == 0) {
-                result = fs_error("Erreur lors de l'allocation d'un bloc direct");
-                goto cleanup;
-            }
+    inode_set_size(inode, new_size);
+    return 0;
+}
 
-            set_block_used(ctx->fs_map, block_num);
-            printf("[DEBUG] Bloc alloué (direct): %u\n", block_num);
-            inode->direct_blocks[block_index] = block_num;
-        } else {
-            block_num = inode->direct_blocks[block_index];
-        }
+int inode_writer_open(fs_context_t *ctx, int inode_index, inode_writer_t *writer, int mode) {
+    memset(writer, 0, sizeof(*writer));
 
-        block_t *data_block = get_block(ctx->fs_map, (int) block_num);
-        if (!data_block) {
-            result = fs_error("Erreur lors de l'accès à un bloc direct");
-            goto cleanup;
+    block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
+    if (!inode_block || !verify_block_checksum(ctx, inode_block)) {
+        return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
+    }
+
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
+    pthread_mutex_t *mutex_ptr = block_write_lock(ctx->fs_map, inode_block);
+    pthread_mutex_t *mutex_ptr_r = block_read_lock(ctx->fs_map, inode_block);
+
+    pthread_mutex_lock(mutex_ptr_r);
+    if (pthread_mutex_lock(mutex_ptr) != 0) {
+        pthread_mutex_unlock(mutex_ptr_r);
+        return fs_error("Erreur lors du lock");
+    }
+
+    if (!(inode->flags & PERM_EXISTS) || !check_permissions(inode, PERM_WRITE)) {
+        pthread_mutex_unlock(mutex_ptr_r);
+        pthread_mutex_unlock(mutex_ptr);
+        return fs_error(!(inode->flags & PERM_EXISTS) ? "Le fichier n'existe pas" : "Permission d'écriture refusée");
+    }
+
+    writer->ctx = ctx;
+    writer->inode_index = inode_index;
+    writer->inode_block = inode_block;
+    writer->inode = inode;
+    writer->original_size = inode_size(inode);
+    writer->offset = mode == INODE_WRITER_APPEND ? writer->original_size : 0;
+    writer->mode = mode;
+    block_map_init(&writer->map, ctx, inode);
+    return 0;
+}
+
+/**
+ * Rend le numéro du bloc de rang n du fichier, en l'allouant (avec les blocs d'indirection
+ * si besoin) s'il n'existe pas encore
+ * @return Numéro du bloc, 0 en cas d'erreur
+ */
+static uint32_t writer_block(inode_writer_t *writer, uint32_t n) {
+    fs_context_t *ctx = writer->ctx;
+    uint32_t allocated = (uint32_t) ((inode_size(writer->inode) + ctx->data_size - 1) / ctx->data_size);
+
+    if (n >= block_map_max_blocks(ctx)) {
+        fs_error("Espace insuffisant pour écrire toutes les données");
+        return 0;
+    }
+
+    // Blocs d'indirection gardés par la table pour tout le flux
+    uint32_t *ref = block_map_slot(&writer->map, n, n >= allocated);
+    if (!ref) {
+        return 0;  // L'erreur a déjà été affichée
+    }
+    if (n < allocated) {
+        return *ref;
+    }
+
+    uint32_t block_num = find_free_block(ctx);
+    if (block_num == 0) {
+        fs_error("Espace insuffisant sur le système de fichiers");
+        return 0;
+    }
+    block_t *data_block = get_block(ctx->fs_map, block_num);
+    memset(data_block->data, 0, ctx->data_size);
+    BLOCK_META(ctx, data_block)->type = BLOCK_TYPE_DATA;
+
+    *ref = block_num;
+    return block_num;
+}
+
+int inode_writer_write(inode_writer_t *writer, const char *data, uint32_t size) {
+    fs_context_t *ctx = writer->ctx;
+    inode_t *inode = writer->inode;
+
+    if (writer->offset + size > inode_max_size(ctx)) {
+        return fs_error("Écriture au-delà de la taille maximale d'un fichier");
+    }
+
+    // Contenu dans le bloc d'inode tant qu'il y tient, sinon passage aux blocs
+    if (inode->flags & PERM_INLINE) {
+        if (writer->offset + size <= inode_inline_capacity(ctx)) {
+            memcpy(inode_inline_data(inode) + writer->offset, data, size);
+            writer->offset += size;
+            if (writer->offset > inode_size(inode)) inode_set_size(inode, writer->offset);
+            return 0;
         }
+        if (leave_inline(ctx, inode) < 0) return -1;
+    }
 
-        if (!append || block_index >= direct_blocks_used) {
-            memset(data_block->data, 0, DATA_SIZE);
-            data_block->type = BLOCK_TYPE_DATA;
+    // Blocs du morceau réservés d'un coup, bitmaps rehachées à la fin du morceau : seul l'inode
+    // attend la fermeture
+    uint64_t current_size = inode_size(inode);
+    int allocated = writer->offset + size > current_size;
+    if (allocated) {
+        uint32_t missing = blocks_to_allocate(ctx, current_size, writer->offset + size);
+        uint32_t reserved = reserved_block_count(ctx);
+        if (missing > reserved) reserve_blocks(ctx, missing - reserved);
+    }
+    while (size > 0) {
+        uint32_t n = (uint32_t) (writer->offset / ctx->data_size);
+        uint32_t position = (uint32_t) (writer->offset % ctx->data_size);
+        uint32_t to_write = size < ctx->data_size - position ? size : ctx->data_size - position;
+
+        // Un bloc existant n'est vérifié que s'il garde des octets utiles de l'ancien contenu
+        uint64_t file_size = inode_size(inode);
+        int existing = n < (file_size + ctx->data_size - 1) / ctx->data_size;
+        uint32_t block_num = writer_block(writer, n);
+        block_t *data_block = block_num ? get_block(ctx->fs_map, block_num) : NULL;
+        if (!data_block) return -1;
+
+        uint64_t block_start = (uint64_t) n * ctx->data_size;
+        uint64_t block_end = block_start + ctx->data_size < file_size ? block_start + ctx->data_size : file_size;
+        if (existing && (position > 0 || writer->offset + to_write < block_end)
+            && !verify_block_checksum(ctx, data_block)) {
+            return fs_error("Erreur lors de l'accès à un bloc de données ou bloc corrompu");
         }
 
-        uint32_t to_write = (remaining < DATA_SIZE) ? remaining : DATA_SIZE;
-        memcpy(data_block->data, data + bytes_written, to_write);
-        compute_block_sha1(data_block);
+        memcpy(data_block->data + position, data, to_write);
+        mark_block_dirty(ctx, data_block);
 
-        bytes_written += to_write;
-        remaining -= to_write;
-        block_index++;
+        writer->offset += to_write;
+        if (writer->offset > inode_size(inode)) inode_set_size(inode, writer->offset);
+        data += to_write;
+        size -= to_write;
     }
+    if (allocated) fs_commit_alloc(ctx);
+    return 0;
+}
 
-    if (remaining > 0) {
-        block_t *indirect_block;
-        uint32_t *block_refs;
-        int indirect_blocks_used = 0;
+int inode_writer_close(inode_writer_t *writer) {
+    fs_context_t *ctx = writer->ctx;
+    inode_t *inode = writer->inode;
+    int result = 0;
 
-        if (inode->indirect_block == 0) {
-            uint32_t indirect_block_num = find_free_block(ctx->fs_map, ctx->sb);
-            if (indirect_block_num == 0) {
-                result = fs_error("Erreur lors de l'allocation du bloc d'indirection");
-                goto cleanup;
-            }
+    // Réécriture : l'ancien contenu au-delà de ce qui a été écrit est rendu à la bitmap
+    if (writer->mode == INODE_WRITER_REPLACE) {
+        result = truncate_locked(ctx, inode, writer->offset);
+    }
 
-            set_block_used(ctx->fs_map, indirect_block_num);
-            printf("[DEBUG] Bloc alloué (bloc d'indirection): %u\n", indirect_block_num);
-            inode->indirect_block = indirect_block_num;
+    // Point de commit du flux : chaque bloc modifié n'est haché qu'une fois
+    if (inode_size(inode) != writer->original_size || writer->map.allocated > 0 || (inode->flags & PERM_INLINE)) {
+        mark_block_dirty(ctx, writer->inode_block);
+        inode_summary_update(ctx, writer->inode_index, inode);
+    }
+    fs_commit(ctx);
 
-            indirect_block = get_block(ctx->fs_map, (int) indirect_block_num);
-            if (!indirect_block) {
-                result = fs_error("Erreur lors de l'accès au bloc d'indirection");
-                goto cleanup;
-            }
+    pthread_mutex_unlock(block_read_lock(ctx->fs_map, writer->inode_block));
+    pthread_mutex_unlock(block_write_lock(ctx->fs_map, writer->inode_block));
+    return result;
+}
 
-            memset(indirect_block->data, 0, DATA_SIZE);
-            indirect_block->type = BLOCK_TYPE_INDIRECT;
-            block_refs = (uint32_t *) indirect_block->data;
-        } else {
-            indirect_block = get_block(ctx->fs_map, (int) inode->indirect_block);
-            if (!indirect_block || !verify_block_sha1(indirect_block)) {
-                result = fs_error("Erreur lors de l'accès au bloc d'indirection ou bloc corrompu");
-                goto cleanup;
-            }
-            block_refs = (uint32_t *) indirect_block->data;
+// Opérations positionnelles faites sous les verrous de l'inode
+#define INODE_OP_WRITE_AT  0   // Écrire à une position
+#define INODE_OP_OVERWRITE 1   // Remplacer le contenu en réutilisant les blocs existants
+#define INODE_OP_TRUNCATE  2   // Raccourcir
 
-            if (append) {
-                for (unsigned long i = 0; i < DATA_SIZE / sizeof(uint32_t); i++) {
-                    if (block_refs[i] != 0) indirect_blocks_used++;
-                    else break;
-                }
-            }
-        }
+/**
+ * Prend les verrous d'un fichier, vérifie le droit d'écriture, fait l'opération,
+ * puis rehache les blocs touchés avant de relâcher les verrous
+ * (INODE_OP_TRUNCATE : offset est la nouvelle taille)
+ */
+static int locked_inode_op(fs_context_t *ctx, int inode_index, int op, const char *data, uint32_t size,
+                           uint64_t offset) {
+    if (offset > inode_max_size(ctx) || size > inode_max_size(ctx) - offset) {
+        return fs_error("Écriture au-delà de la taille maximale d'un fichier");
+    }
 
-        int indirect_index = append ? indirect_blocks_used : 0;
-        while (remaining > 0 && (unsigned long) indirect_index < DATA_SIZE / sizeof(uint32_t)) {
-            uint32_t block_num;
-            if (!append || indirect_index >= indirect_blocks_used) {
-                block_num = find_free_block(ctx->fs_map, ctx->sb);
-                if (block_num == 0) {
-                    result = fs_error("Erreur lors de l'allocation d'un bloc indirect");
-                    goto cleanup;
-                }
+    block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
+    if (!inode_block || !verify_block_checksum(ctx, inode_block)) {
+        return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
+    }
 
-                set_block_used(ctx->fs_map, block_num);
-                printf("[DEBUG] Bloc alloué (indirect): %u\n", block_num);
-                block_refs[indirect_index] = block_num;
-            } else {
-                block_num = block_refs[indirect_index];
-            }
+    int result = 0;
+    int mutex_locked = 0;
+    int grown = 0;
 
-            block_t *data_block = get_block(ctx->fs_map, (int) block_num);
-            if (!data_block) {
-                result = fs_error("Erreur lors de l'accès à un bloc indirect");
-                goto cleanup;
-            }
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
+    uint64_t original_size = inode_size(inode);
+    pthread_mutex_t *mutex_ptr = block_write_lock(ctx->fs_map, inode_block);
+    pthread_mutex_t *mutex_ptr_r = block_read_lock(ctx->fs_map, inode_block);
 
-            if (!append || indirect_index >= indirect_blocks_used) {
-                memset(data_block->data, 0, DATA_SIZE);
-                data_block->type = BLOCK_TYPE_DATA;
-            }
+    pthread_mutex_lock(mutex_ptr_r);
 
-            uint32_t to_write = (remaining < DATA_SIZE) ? remaining : DATA_SIZE;
-            memcpy(data_block->data, data + bytes_written, to_write);
-            compute_block_sha1(data_block);
+    int lock_result = pthread_mutex_lock(mutex_ptr);
+    if (lock_result != 0) {
+        result = fs_error("Erreur lors du lock");
+        goto cleanup;
+    }
+    mutex_locked = 1;
+    original_size = inode_size(inode);
 
-            bytes_written += to_write;
-            remaining -= to_write;
-            indirect_index++;
-        }
+    if (!(inode->flags & PERM_EXISTS)) {
+        result = fs_error("Le fichier n'existe pas");
+        goto cleanup;
+    }
 
-        compute_block_sha1(indirect_block);
+    if (!check_permissions(inode, PERM_WRITE)) {
+        result = fs_error("Permission d'écriture refusée");
+        goto cleanup;
+    }
 
-        if (remaining > 0) {
-            result = fs_error("Espace insuffisant pour écrire toutes les données");
-            goto cleanup;
+    if (op == INODE_OP_TRUNCATE) {
+        result = truncate_locked(ctx, inode, offset);
+    } else {
+        result = write_at_locked(ctx, inode, data, size, offset, &grown);
+        if (result == 0 && op == INODE_OP_OVERWRITE) {
+            result = truncate_locked(ctx, inode, size);
         }
     }
 
-    // Mettre à jour la taille de l'inode uniquement si tout s'est bien passé
-    inode->size = total_size;
-
     cleanup:
-    // Déverrouiller le mutex s'il a été verrouillé
+    // Seuls les blocs touchés (et l'inode si sa taille, sa table ou son contenu ont changé) sont rehachés
+    if (grown || inode_size(inode) != original_size || (inode->flags & PERM_INLINE)) {
+        mark_block_dirty(ctx, inode_block);
+        inode_summary_update(ctx, inode_index, inode);
+    }
+    fs_commit(ctx);
+
     if (mutex_locked) {
         pthread_mutex_unlock(mutex_ptr_r);
         pthread_mutex_unlock(mutex_ptr);
     }
-    compute_block_sha1(inode_block);
-
     return result;
 }
 
+int write_inode_at(fs_context_t *ctx, int inode_index, const char *data, uint32_t size, uint64_t offset) {
+    return locked_inode_op(ctx, inode_index, INODE_OP_WRITE_AT, data, size, offset);
+}
+
+int overwrite_inode_content(fs_context_t *ctx, int inode_index, const char *data, uint32_t size) {
+    return locked_inode_op(ctx, inode_index, INODE_OP_OVERWRITE, data, size, 0);
+}
+
+int truncate_inode(fs_context_t *ctx, int inode_index, uint64_t size) {
+    return locked_inode_op(ctx, inode_index, INODE_OP_TRUNCATE, NULL, 0, size);
+}
+
+uint32_t blocks_to_allocate(fs_context_t *ctx, uint64_t current_size, uint64_t new_size) {
+    uint32_t inline_capacity = inode_inline_capacity(ctx);
+    uint64_t current_blocks = current_size <= inline_capacity ? 0 : (current_size + ctx->data_size - 1) / ctx->data_size;
+    uint64_t total_blocks = new_size <= inline_capacity ? 0 : (new_size + ctx->data_size - 1) / ctx->data_size;
+    if (total_blocks <= current_blocks) return 0;
+
+    // Blocs de données, plus les blocs d'indirection des nouveaux rangs
+    uint64_t needed = total_blocks - current_blocks
+                      + block_map_indirect_count(ctx, total_blocks) - block_map_indirect_count(ctx, current_blocks);
+    return needed > UINT32_MAX ? UINT32_MAX : (uint32_t) needed;
+}
+
 /**
  * Crée un nouveau fichier ou réinitialise un fichier existant
  * @param ctx Contexte du système de fichiers
  * @param filename Nom du fichier à créer/réinitialiser
  * @param check_write Vérifier les permissions d'écriture si le fichier existe
- * @return Index de l'inode créé/réinitialisé ou -1 en cas d'erreur
+ * @return Index de l'inode créé/réinitialisé ou -1 en cas d'erreur (errno positionné)
  */
 int create_or_reset_file(fs_context_t *ctx, const char *filename, int check_write) {
-    int inode_index = find_inode_by_name(ctx->fs_map, filename);
+    int inode_index = find_inode_by_name(ctx, filename);
     int result;
     int mutex_locked = 0;
     pthread_mutex_t *mutex_ptr = NULL;
     block_t *inode_block = NULL;
     inode_t *inode = NULL;
+    int *rejected = NULL;
+    uint32_t rejected_count = 0;
 
     if (inode_index >= 0) {
         // Cas de réinitialisation d'un fichier existant
         inode_block = get_inode_block(ctx->fs_map, inode_index);
-        if (!inode_block || !verify_block_sha1(inode_block)) {
+        if (!inode_block) {
+            errno = EIO;
             return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
         }
 
-        inode = (inode_t *) inode_block->data;
-        mutex_ptr = (pthread_mutex_t *) inode_block->lock_write;
+        inode = get_inode(ctx->fs_map, inode_index);
+        mutex_ptr = block_write_lock(ctx->fs_map, inode_block);
 
         int lock_result = pthread_mutex_lock(mutex_ptr);
         if (lock_result != 0) {
+            errno = EIO;
             return fs_error("Erreur lors du lock");
         }
 
         mutex_locked = 1;
 
+        // Vérifié sous le verrou, comme à la création
+        if (!verify_block_checksum(ctx, inode_block)) {
+            errno = EIO;
+            result = fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
+            goto cleanup;
+        }
+
         if (!(inode->flags & PERM_EXISTS)) {
+            errno = ENOENT;
             result = fs_error("Le fichier '%s' n'existe pas", filename);
             goto cleanup;
         }
 
         if (check_write && !check_permissions(inode, PERM_WRITE)) {
+            errno = EACCES;
             result = fs_error("Permission d'écriture refusée pour '%s'", filename);
             goto cleanup;
         }
 
-        // Libérer tous les blocs directs
-        for (int i = 0; i < 10; i++) {
-            if (inode->direct_blocks[i] != 0) {
-                set_block_free(ctx->fs_map, inode->direct_blocks[i]);
-                increment_free_blocks(ctx->fs_map);
-                inode->direct_blocks[i] = 0;
-            }
-        }
-
-        // Libérer tous les blocs indirects et le bloc d'indirection
-        if (inode->indirect_block != 0) {
-            block_t *indirect_block = get_block(ctx->fs_map, (int) inode->indirect_block);
-            if (indirect_block && verify_block_sha1(indirect_block)) {
-                uint32_t *block_refs = (uint32_t *) indirect_block->data;
-                for (unsigned long i = 0; i < DATA_SIZE / sizeof(uint32_t); i++) {
-                    if (block_refs[i] != 0) {
-                        set_block_free(ctx->fs_map, block_refs[i]);
-                        increment_free_blocks(ctx->fs_map);
-                    } else {
-                        break;
-                    }
-                }
-            }
-            set_block_free(ctx->fs_map, inode->indirect_block);
-            increment_free_blocks(ctx->fs_map);
-            inode->indirect_block = 0;
+        // Libérer tous les blocs de données et d'indirection
+        if (block_map_truncate(ctx, inode, 0) < 0) {
+            errno = EIO;
+            result = -1;
+            goto cleanup;
         }
 
-        // Réinitialiser la taille du fichier
-        inode->size = 0;
-        compute_block_sha1(inode_block);
+        // Réinitialiser la taille du fichier (le nouveau contenu commence dans l'inode)
+        if (inode_inline_capacity(ctx) > 0) inode->flags |= PERM_INLINE;
+        inode_set_size(inode, 0);
+        mark_block_dirty(ctx, inode_block);
+        inode_summary_update(ctx, inode_index, inode);
         result = inode_index;
     } else {
         // Cas de création d'un nouveau fichier
+        // Avec la bitmap des inodes, le slot est réservé par un seul bit atomique ;
+        // sinon on parcourt la table des inodes
+        int use_bitmap = (ctx->sb->features & FS_FEATURE_INODE_BITMAP) != 0;
+
         for (uint32_t i = 0; i < ctx->sb->max_inodes; i++) {
-            inode_block = get_inode_block(ctx->fs_map, (int) i);
-            if (!inode_block || !verify_block_sha1(inode_block)) continue;
+            int candidate = (int) i;
+            if (use_bitmap) {
+                candidate = alloc_inode(ctx);
+                if (candidate < 0) break;
+            }
+
+            inode_block = get_inode_block(ctx->fs_map, candidate);
+            if (!inode_block) {
+                if (use_bitmap) release_inode(ctx, candidate);
+                continue;
+            }
 
-            inode = (inode_t *) inode_block->data;
-            mutex_ptr = (pthread_mutex_t *) inode_block->lock_write;
+            inode = get_inode(ctx->fs_map, candidate);
+            mutex_ptr = block_write_lock(ctx->fs_map, inode_block);
 
             int lock_result = pthread_mutex_lock(mutex_ptr);
             if (lock_result != 0) {
+                if (use_bitmap) release_inode(ctx, candidate);
                 continue;  // Essayer avec le prochain inode
             }
 
+            // Vérifié sous le verrou : un voisin du même bloc ne peut plus être entre sa
+            // modification et son rehachage. Un bloc corrompu met son bit de côté jusqu'à la fin
+            // de la recherche (sinon alloc_inode le reproposerait aussitôt), puis le rend
+            if (!verify_block_checksum(ctx, inode_block)) {
+                pthread_mutex_unlock(mutex_ptr);
+                if (use_bitmap) {
+                    int *grown = realloc(rejected, (rejected_count + 1) * sizeof(int));
+                    if (grown) {
+                        rejected = grown;
+                        rejected[rejected_count++] = candidate;
+                    } else {
+                        release_inode(ctx, candidate);
+                    }
+                }
+                continue;
+            }
+
             mutex_locked = 1;
 
             if (!(inode->flags & PERM_EXISTS)) {
@@ -545,23 +1355,46 @@ int create_or_reset_file(fs_context_t *ctx, const char *filename, int check_writ
                 strncpy(inode->filename, filename, 255);
                 inode->filename[255] = '\0';
                 inode->flags = PERM_EXISTS | PERM_READ | PERM_WRITE;
-                inode->size = 0;
+                if (inode_inline_capacity(ctx) > 0) inode->flags |= PERM_INLINE;
+                inode_set_size(inode, 0);
+
+                // Référencer le nouveau fichier dans l'index des noms
+                if ((ctx->sb->features & FS_FEATURE_NAME_INDEX)
+                    && name_index_insert(ctx, inode->filename, candidate) < 0) {
+                    memset(inode, 0, sizeof(inode_t));
+                    mark_block_dirty(ctx, inode_block);
+                    if (use_bitmap) release_inode(ctx, candidate);
+                    errno = ENOSPC;
+                    result = fs_error("Index des noms plein");
+                    goto cleanup;
+                }
 
-                compute_block_sha1(inode_block);
-                result = (int) i;
+                mark_block_dirty(ctx, inode_block);
+                inode_summary_update(ctx, candidate, inode);
+                trigram_index_insert(ctx, inode->filename, candidate);
+                result = candidate;
                 goto cleanup;
             }
 
             // Libérer le mutex et essayer avec le prochain inode
+            // (un inode existant marqué libre dans la bitmap garde son bit à 1)
             pthread_mutex_unlock(mutex_ptr);
             mutex_locked = 0;
         }
 
         // Si on arrive ici, aucun inode libre n'a été trouvé
+        errno = ENOSPC;
         result = fs_error("Aucun inode libre disponible");
     }
 
     cleanup:
+    // Rendre les inodes écartés pendant la recherche
+    for (uint32_t i = 0; i < rejected_count; i++) {
+        release_inode(ctx, rejected[i]);
+    }
+    free(rejected);
+    fs_commit(ctx);
+
     // Déverrouiller le mutex s'il a été verrouillé
     if (mutex_locked && mutex_ptr) {
         pthread_mutex_unlock(mutex_ptr);
@@ -571,6 +1404,14 @@ int create_or_reset_file(fs_context_t *ctx, const char *filename, int check_writ
 }
 
 
+int create_or_open_file(fs_context_t *ctx, const char *filename) {
+    // Fichier existant : ses blocs sont gardés pour être réécrits sur place
+    if (find_inode_by_name(ctx, filename) >= 0) {
+        return find_file_with_perm_check(ctx, filename, PERM_WRITE);
+    }
+    return create_or_reset_file(ctx, filename, 1);
+}
+
 /**
  * Trouve un fichier par son nom et vérifie les permissions d'accès
  * @param ctx Contexte du système de fichiers
@@ -579,19 +1420,19 @@ int create_or_reset_file(fs_context_t *ctx, const char *filename, int check_writ
  * @return Index de l'inode trouvé ou -1 en cas d'erreur
  */
 int find_file_with_perm_check(fs_context_t *ctx, const char *filename, uint32_t check_perm) {
-    int inode_index = find_inode_by_name(ctx->fs_map, filename);
+    int inode_index = find_inode_by_name(ctx, filename);
     if (inode_index < 0) {
         return fs_error("Fichier '%s' non trouvé", filename);
     }
 
     // Récupérer le bloc de l'inode
     block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
-    if (!inode_block || !verify_block_sha1(inode_block)) {
+    if (!inode_block || !verify_inode_block(ctx, inode_block)) {
         return fs_error("Erreur lors de l'accès à l'inode ou inode corrompu");
     }
 
     // Récupérer les informations de l'inode
-    inode_t *inode = (inode_t *) inode_block->data;
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
 
     // Vérifier l'existence
     if (!(inode->flags & PERM_EXISTS)) {
@@ -0,0 +1,383 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "inode_summary.h"
+#include "name_index.h"
+#include "block_ops.h"
+
+
+/// Résumé des inodes : ls, find et df n'ont besoin que du nom, des drapeaux et de la taille ;
+/// rangés en colonnes, ils se lisent en quelques centaines de Ko au lieu de vérifier toute la
+/// table des inodes. Les colonnes sont tenues à jour par les chemins qui modifient les inodes
+
+// Octets d'une case de chaque colonne
+static const uint32_t column_width[SUMMARY_COLUMNS] = {
+    sizeof(uint32_t), sizeof(uint32_t), sizeof(uint64_t), sizeof(uint32_t)
+};
+
+/**
+ * Nombre de blocs d'une colonne (les blocs du résumé n'utilisent que DATA_SIZE octets)
+ */
+static uint32_t column_blocks(uint32_t nb_inode, int column) {
+    uint32_t per_block = DATA_SIZE / column_width[column];
+    return (nb_inode + per_block - 1) / per_block;
+}
+
+/**
+ * Premier bloc d'une colonne ; column = SUMMARY_COLUMNS donne le premier bloc du tas des noms
+ */
+static uint32_t column_start(superblock_t *sb, int column) {
+    uint32_t start = sb->summary_start;
+    for (int c = 0; c < column; c++) {
+        start += column_blocks(sb->max_inodes, c);
+    }
+    return start;
+}
+
+/**
+ * Taille du tas des noms en octets
+ */
+static uint64_t heap_bytes(superblock_t *sb) {
+    return (uint64_t) (sb->summary_start + sb->summary_blocks - column_start(sb, SUMMARY_COLUMNS)) * DATA_SIZE;
+}
+
+/**
+ * Le conteneur a un résumé, et ses colonnes tiennent dans la zone annoncée par le superbloc
+ */
+static int summary_present(superblock_t *sb) {
+    return (sb->features & FS_FEATURE_INODE_SUMMARY)
+           && column_start(sb, SUMMARY_COLUMNS) <= sb->summary_start + sb->summary_blocks
+           && sb->summary_start + sb->summary_blocks <= sb->inode_start;
+}
+
+uint32_t inode_summary_blocks_for(uint32_t nb_inode) {
+    uint32_t blocks = 0;
+    for (int c = 0; c < SUMMARY_COLUMNS; c++) {
+        blocks += column_blocks(nb_inode, c);
+    }
+    return blocks + (uint32_t) (((uint64_t) nb_inode * SUMMARY_NAME_BYTES + DATA_SIZE - 1) / DATA_SIZE);
+}
+
+/**
+ * Case d'un inode dans une colonne commençant au bloc start
+ */
+static void *column_cell(void *addr, uint32_t start, int column, uint32_t inode_index, block_t **block) {
+    uint32_t per_block = DATA_SIZE / column_width[column];
+    block_t *column_block = get_block(addr, start + inode_index / per_block);
+    *block = column_block;
+    return column_block->data + (inode_index % per_block) * column_width[column];
+}
+
+/**
+ * Case d'un inode dans une colonne
+ * @param block Reçoit le bloc contenant la case (pour la mise à jour de sa somme de contrôle)
+ */
+static void *summary_cell(void *addr, superblock_t *sb, int column, uint32_t inode_index, block_t **block) {
+    return column_cell(addr, column_start(sb, column), column, inode_index, block);
+}
+
+/**
+ * Verrou des modifications du résumé : celui de son premier bloc. Les cases de 1024 inodes
+ * partagent un bloc ; sans verrou, deux écritures modifient le même bloc et la somme calculée par
+ * l'une peut être rangée après la modification de l'autre (bloc faux pour de bon)
+ */
+static pthread_mutex_t *summary_lock(void *addr, superblock_t *sb) {
+    return block_write_lock(addr, get_block(addr, sb->summary_start));
+}
+
+/**
+ * Bloc du résumé modifié : rehaché tout de suite sous le verrou du résumé, ou laissé à fs_commit
+ * pendant une reconstruction (aucun autre processus)
+ */
+static void summary_touch(fs_context_t *ctx, block_t *block, int immediate) {
+    if (immediate) {
+        compute_block_checksum(ctx, block);
+    } else {
+        mark_block_dirty(ctx, block);
+    }
+}
+
+/**
+ * Vérifie un bloc du résumé ; en cas d'échec, de nouveau sous le verrou du résumé : une mise à
+ * jour en cours est alors terminée et hachée
+ */
+static int summary_block_valid(fs_context_t *ctx, block_t *block) {
+    if (verify_block_checksum(ctx, block)) return 1;
+    if (ctx->read_only) return 0;
+
+    pthread_mutex_t *lock = summary_lock(ctx->fs_map, ctx->sb);
+    pthread_mutex_lock(lock);
+    int valid = verify_block_checksum(ctx, block);
+    pthread_mutex_unlock(lock);
+    return valid;
+}
+
+/**
+ * Nom rangé dans le tas qui commence au bloc heap_start
+ * @param name_ref Position du nom + 1
+ * @param block Reçoit le bloc du tas contenant le nom
+ * @return Le nom, NULL si name_ref ne désigne aucun nom
+ */
+static char *heap_name_at(void *addr, superblock_t *sb, uint32_t heap_start, uint32_t name_ref, block_t **block) {
+    uint64_t heap_size = (uint64_t) (sb->summary_start + sb->summary_blocks - heap_start) * DATA_SIZE;
+    if (name_ref == 0 || name_ref > sb->summary_heap_used || name_ref - 1 >= heap_size) return NULL;
+
+    uint32_t offset = name_ref - 1;
+    *block = get_block(addr, heap_start + offset / DATA_SIZE);
+    char *name = (char *) (*block)->data + offset % DATA_SIZE;
+
+    // Un nom ne chevauche jamais deux blocs : sa fin doit être dans le même bloc
+    return memchr(name, '\0', DATA_SIZE - offset % DATA_SIZE) ? name : NULL;
+}
+
+/**
+ * Nom rangé dans le tas
+ */
+static char *heap_name(void *addr, superblock_t *sb, uint32_t name_ref, block_t **block) {
+    return heap_name_at(addr, sb, column_start(sb, SUMMARY_COLUMNS), name_ref, block);
+}
+
+/**
+ * Ajoute un nom à la fin du tas (place réservée sous le verrou du superbloc, sans chevaucher deux blocs)
+ * @return Position du nom + 1, 0 si le tas est plein
+ */
+static uint32_t heap_append(fs_context_t *ctx, const char *filename, int immediate) {
+    superblock_t *sb = ctx->sb;
+    uint32_t len = (uint32_t) strlen(filename) + 1;
+    uint64_t capacity = heap_bytes(sb);
+    // Le compteur du tas est dans le superbloc : réservé et rehaché sous son verrou
+    superblock_update_begin(ctx);
+    uint32_t start = sb->summary_heap_used;
+    if (start % DATA_SIZE + len > DATA_SIZE) {
+        start += DATA_SIZE - start % DATA_SIZE;
+    }
+    int full = start + len > capacity;
+    if (!full) sb->summary_heap_used = start + len;
+    superblock_update_end(ctx);
+    if (full) return 0;
+
+    block_t *heap_block = get_block(ctx->fs_map, column_start(sb, SUMMARY_COLUMNS) + start / DATA_SIZE);
+    memcpy(heap_block->data + start % DATA_SIZE, filename, len);
+    summary_touch(ctx, heap_block, immediate);
+    return start + 1;
+}
+
+/**
+ * Recopie un inode dans les colonnes (verrou du résumé détenu, ou reconstruction)
+ * @param immediate Rehacher chaque bloc modifié avant de rendre la main
+ */
+static void summary_update_locked(fs_context_t *ctx, int inode_index, const inode_t *inode, int immediate) {
+    superblock_t *sb = ctx->sb;
+    void *addr = ctx->fs_map;
+    int exists = (inode->flags & PERM_EXISTS) != 0;
+    block_t *block;
+
+    uint32_t *flags = summary_cell(addr, sb, SUMMARY_FLAGS, (uint32_t) inode_index, &block);
+    uint32_t new_flags = exists ? inode->flags : 0;
+    if (*flags != new_flags) {
+        *flags = new_flags;
+        summary_touch(ctx, block, immediate);
+    }
+
+    uint64_t *size = summary_cell(addr, sb, SUMMARY_SIZE, (uint32_t) inode_index, &block);
+    uint64_t new_size = exists ? inode_size(inode) : 0;
+    if (*size != new_size) {
+        *size = new_size;
+        summary_touch(ctx, block, immediate);
+    }
+
+    // Un inode libéré garde son nom : recréé sous le même nom, il n'ajoute rien au tas
+    if (!exists) return;
+
+    // Le nom ne change pas lors d'une écriture : seules les créations touchent au tas
+    block_t *hash_block, *name_block, *heap_block;
+    uint32_t *hash = summary_cell(addr, sb, SUMMARY_HASH, (uint32_t) inode_index, &hash_block);
+    uint32_t *name_ref = summary_cell(addr, sb, SUMMARY_NAME, (uint32_t) inode_index, &name_block);
+    const char *current = heap_name(addr, sb, *name_ref, &heap_block);
+    if (current && strcmp(current, inode->filename) == 0) return;
+
+    uint32_t new_hash = name_hash(inode->filename);
+    if (!current && *name_ref == 0 && *hash == new_hash) return;  // Tas déjà plein pour ce nom
+
+    *hash = new_hash;
+    *name_ref = heap_append(ctx, inode->filename, immediate);
+    summary_touch(ctx, hash_block, immediate);
+    summary_touch(ctx, name_block, immediate);
+}
+
+void inode_summary_update(fs_context_t *ctx, int inode_index, const inode_t *inode) {
+    superblock_t *sb = ctx->sb;
+    if (!summary_present(sb) || inode_index < 0 || (uint32_t) inode_index >= sb->max_inodes) return;
+
+    // Modification et rehachage sous le verrou du résumé (celui du superbloc, pris par
+    // heap_append, vient toujours après)
+    pthread_mutex_t *lock = summary_lock(ctx->fs_map, sb);
+    pthread_mutex_lock(lock);
+    summary_update_locked(ctx, inode_index, inode, 1);
+    pthread_mutex_unlock(lock);
+}
+
+int inode_summary_check(fs_context_t *ctx) {
+    superblock_t *sb = ctx->sb;
+    if (!(sb->features & FS_FEATURE_INODE_SUMMARY)) return 0;
+    if (!summary_present(sb) || sb->summary_heap_used > heap_bytes(sb)) return -1;
+
+    void *addr = ctx->fs_map;
+    for (uint32_t i = 0; i < sb->summary_blocks; i++) {
+        if (!verify_block_checksum(ctx, get_block(addr, sb->summary_start + i))) return -1;
+    }
+
+    for (uint32_t i = 0; i < sb->max_inodes; i++) {
+        inode_t *inode = get_inode(addr, (int) i);
+        int exists = (inode->flags & PERM_EXISTS) != 0;
+        block_t *block;
+
+        uint32_t flags = *(uint32_t *) summary_cell(addr, sb, SUMMARY_FLAGS, i, &block);
+        uint64_t size = *(uint64_t *) summary_cell(addr, sb, SUMMARY_SIZE, i, &block);
+        if (flags != (exists ? inode->flags : 0) || size != (exists ? inode_size(inode) : 0)) return -1;
+        if (!exists) continue;
+
+        uint32_t hash = *(uint32_t *) summary_cell(addr, sb, SUMMARY_HASH, i, &block);
+        uint32_t name_ref = *(uint32_t *) summary_cell(addr, sb, SUMMARY_NAME, i, &block);
+        if (hash != name_hash(inode->filename)) return -1;
+
+        const char *name = heap_name(addr, sb, name_ref, &block);
+        if (name_ref != 0 && (!name || strcmp(name, inode->filename) != 0)) return -1;
+    }
+    return 0;
+}
+
+int inode_summary_rebuild(fs_context_t *ctx) {
+    superblock_t *sb = ctx->sb;
+    if (!(sb->features & FS_FEATURE_INODE_SUMMARY)) return 0;
+    if (!summary_present(sb)) return -1;
+
+    // Vider les colonnes et le tas
+    for (uint32_t i = 0; i < sb->summary_blocks; i++) {
+        block_t *summary_block = get_block(ctx->fs_map, sb->summary_start + i);
+        memset(summary_block->data, 0, DATA_SIZE);
+        BLOCK_META(ctx, summary_block)->type = BLOCK_TYPE_INODE_SUMMARY;
+        mark_block_dirty(ctx, summary_block);
+    }
+    superblock_update_begin(ctx);
+    sb->summary_heap_used = 0;
+    superblock_update_end(ctx);
+
+    // Recopier chaque inode existant (le tas ne garde que les noms encore utilisés)
+    for (uint32_t i = 0; i < sb->max_inodes; i++) {
+        inode_t *inode = get_inode(ctx->fs_map, (int) i);
+        if (inode->flags & PERM_EXISTS) {
+            summary_update_locked(ctx, (int) i, inode, 0);
+        }
+    }
+    return 0;
+}
+
+void summary_scan_init(summary_scan_t *scan, fs_context_t *ctx) {
+    summary_scan_init_range(scan, ctx, 0, ctx->sb->max_inodes);
+}
+
+void summary_scan_init_range(summary_scan_t *scan, fs_context_t *ctx, uint32_t first, uint32_t end) {
+    memset(scan, 0, sizeof(*scan));
+    scan->ctx = ctx;
+    scan->use_summary = summary_present(ctx->sb);
+    scan->next = first;
+    scan->end = end < ctx->sb->max_inodes ? end : ctx->sb->max_inodes;
+    for (int c = 0; c <= SUMMARY_COLUMNS; c++) {
+        scan->column_first[c] = column_start(ctx->sb, c);
+    }
+    inode_scan_init(&scan->inodes, ctx, 1);
+    scan->inodes.next = first;
+}
+
+/**
+ * Case d'un inode dans une colonne, son bloc vérifié une seule fois par parcours
+ * @return La case, NULL si le bloc est corrompu
+ */
+static void *scan_cell(summary_scan_t *scan, int column, uint32_t inode_index) {
+    block_t *block;
+    void *cell = column_cell(scan->ctx->fs_map, scan->column_first[column], column, inode_index, &block);
+    if (block != scan->verified[column]) {
+        if (!summary_block_valid(scan->ctx, block)) return NULL;
+        scan->verified[column] = block;
+    }
+    return cell;
+}
+
+/**
+ * Nom d'un fichier pendant le parcours : dans le tas, sinon dans son inode
+ * @return Le nom, NULL si aucun bloc valide ne le contient
+ */
+static const char *scan_name(summary_scan_t *scan, uint32_t name_ref, uint32_t inode_index) {
+    fs_context_t *ctx = scan->ctx;
+    block_t *block;
+
+    const char *name = heap_name_at(ctx->fs_map, ctx->sb, scan->column_first[SUMMARY_COLUMNS], name_ref, &block);
+    if (name && (block == scan->verified[SUMMARY_COLUMNS] || summary_block_valid(ctx, block))) {
+        scan->verified[SUMMARY_COLUMNS] = block;
+        return name;
+    }
+
+    block = get_inode_block(ctx->fs_map, (int) inode_index);
+    if (!block || !verify_block_checksum(ctx, block)) {
+        fs_error("Erreur: Le bloc d'inode %u est corrompu\n", inode_index);
+        return NULL;
+    }
+    return get_inode(ctx->fs_map, (int) inode_index)->filename;
+}
+
+int summary_scan_next(summary_scan_t *scan, summary_entry_t *entry) {
+    fs_context_t *ctx = scan->ctx;
+
+    while (scan->use_summary && scan->next < scan->end) {
+        uint32_t index = scan->next;
+
+        // Colonne des drapeaux d'abord : les inodes libres ne coûtent qu'une case
+        uint32_t *flags = scan_cell(scan, SUMMARY_FLAGS, index);
+        if (!flags) break;
+        if (!(*flags & PERM_EXISTS)) {
+            scan->next++;
+            continue;
+        }
+
+        uint32_t *hash = scan_cell(scan, SUMMARY_HASH, index);
+        uint64_t *size = scan_cell(scan, SUMMARY_SIZE, index);
+        uint32_t *name_ref = scan_cell(scan, SUMMARY_NAME, index);
+        if (!hash || !size || !name_ref) break;
+
+        scan->next++;
+        const char *filename = scan_name(scan, *name_ref, index);
+        if (!filename) continue;
+
+        entry->inode_index = (int) index;
+        entry->filename = filename;
+        entry->hash = *hash;
+        entry->flags = *flags;
+        entry->size = *size;
+        return 1;
+    }
+
+    if (scan->use_summary) {
+        if (scan->next >= scan->end) return 0;
+
+        // Bloc du résumé corrompu : finir le parcours sur la table des inodes
+        fs_error("Résumé des inodes corrompu, lecture de la table des inodes\n");
+        scan->use_summary = 0;
+        scan->inodes.next = scan->next;
+    }
+
+    int inode_index;
+    inode_t *inode = inode_scan_next(&scan->inodes, &inode_index);
+    if (!inode || (uint32_t) inode_index >= scan->end) {
+        scan->inodes.next = ctx->sb->max_inodes;
+        return 0;
+    }
+
+    entry->inode_index = inode_index;
+    entry->filename = inode->filename;
+    entry->hash = name_hash(inode->filename);
+    entry->flags = inode->flags;
+    entry->size = inode_size(inode);
+    return 1;
+}
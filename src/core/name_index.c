@@ -0,0 +1,243 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "name_index.h"
+#include "inode_ops.h"
+#include "block_ops.h"
+
+
+/// Index des noms : table de hachage persistante (adressage ouvert) qui associe
+/// un nom de fichier à son inode, pour éviter de parcourir toute la table des inodes
+
+uint32_t name_hash(const char *filename) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *) filename; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t name_index_blocks_for(uint32_t nb_inode) {
+    uint32_t slots = 2 * nb_inode;
+    return (uint32_t) ((slots + NAME_INDEX_ENTRIES_PER_BLOCK - 1) / NAME_INDEX_ENTRIES_PER_BLOCK);
+}
+
+/**
+ * Nombre total d'entrées de l'index
+ */
+static uint32_t name_index_slots(superblock_t *sb) {
+    return (uint32_t) (sb->name_index_blocks * NAME_INDEX_ENTRIES_PER_BLOCK);
+}
+
+/**
+ * Retourne l'entrée correspondant à une position de la table
+ * @param block Reçoit le bloc contenant l'entrée (pour la mise à jour du SHA1)
+ */
+static name_index_entry_t *name_index_entry(void *addr, superblock_t *sb, uint32_t slot, block_t **block) {
+    block_t *index_block = get_block(addr, (sb->name_index_start + slot / NAME_INDEX_ENTRIES_PER_BLOCK));
+    if (block) *block = index_block;
+    return (name_index_entry_t *) index_block->data + slot % NAME_INDEX_ENTRIES_PER_BLOCK;
+}
+
+/**
+ * Verrou des modifications de l'index : celui du premier bloc de l'index. Une insertion et une
+ * suppression parcourent des entrées de plusieurs blocs (et la suppression vide des entrées qui
+ * précèdent la sienne), elles ne peuvent pas se contenter d'un échange atomique par entrée
+ */
+static pthread_mutex_t *name_index_lock(void *addr, superblock_t *sb) {
+    return block_write_lock(addr, get_block(addr, sb->name_index_start));
+}
+
+/**
+ * Sonde l'index à la recherche d'un nom
+ * @param ctx Contexte dont le cache vérifie chaque bloc traversé, NULL pour lire l'index tel quel
+ * @return Index de l'inode, -1 si le nom est absent, NAME_INDEX_CORRUPT si un bloc traversé est corrompu
+ */
+static int name_index_probe(fs_context_t *ctx, void *addr, const char *filename) {
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    uint32_t slots = name_index_slots(sb);
+    if (slots == 0) return -1;
+
+    uint32_t hash = name_hash(filename);
+    uint32_t slot = hash % slots;
+    block_t *verified = NULL;
+
+    for (uint32_t probe = 0; probe < slots; probe++) {
+        block_t *index_block;
+        name_index_entry_t *entry = name_index_entry(addr, sb, slot, &index_block);
+        if (ctx && index_block != verified) {
+            if (!verify_block_checksum(ctx, index_block)) return NAME_INDEX_CORRUPT;
+            verified = index_block;
+        }
+
+        // L'empreinte est publiée avant l'inode (voir name_index_insert)
+        uint32_t entry_inode = __atomic_load_n(&entry->inode, __ATOMIC_ACQUIRE);
+        if (entry_inode == 0) {
+            return -1;  // Entrée vide : le nom n'est pas dans l'index
+        }
+
+        if (entry_inode != NAME_INDEX_TOMBSTONE && entry->hash == hash && entry_inode - 1 < sb->max_inodes) {
+            // Confirmer avec le nom stocké dans l'inode (collisions d'empreinte)
+            int inode_index = (int) (entry_inode - 1);
+            inode_t *inode = get_inode(addr, inode_index);
+            if ((inode->flags & PERM_EXISTS) && strcmp(inode->filename, filename) == 0) {
+                return inode_index;
+            }
+        }
+
+        slot = (slot + 1) % slots;
+    }
+    return -1;
+}
+
+int name_index_lookup(fs_context_t *ctx, const char *filename) {
+    return name_index_probe(ctx, ctx->fs_map, filename);
+}
+
+/**
+ * Ajoute un nom dans la première entrée vide ou supprimée de sa sonde (verrou de l'index détenu)
+ */
+static int name_index_insert_locked(fs_context_t *ctx, void *addr, superblock_t *sb, const char *filename,
+                                    int inode_index) {
+    uint32_t slots = name_index_slots(sb);
+    uint32_t hash = name_hash(filename);
+    uint32_t slot = hash % slots;
+
+    for (uint32_t probe = 0; probe < slots; probe++) {
+        block_t *index_block;
+        name_index_entry_t *entry = name_index_entry(addr, sb, slot, &index_block);
+
+        if (entry->inode == 0 || entry->inode == NAME_INDEX_TOMBSTONE) {
+            // Empreinte d'abord : une recherche sans verrou qui voit l'inode voit aussi l'empreinte
+            entry->hash = hash;
+            __atomic_store_n(&entry->inode, (uint32_t) inode_index + 1, __ATOMIC_RELEASE);
+            mark_block_dirty(ctx, index_block);
+            return 0;
+        }
+
+        slot = (slot + 1) % slots;
+    }
+    return -1;
+}
+
+int name_index_insert(fs_context_t *ctx, const char *filename, int inode_index) {
+    void *addr = ctx->fs_map;
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    if (name_index_slots(sb) == 0) return -1;
+
+    // Deux créations dont les sondes passent par la même entrée libre ne doivent pas l'écrire
+    // toutes les deux
+    pthread_mutex_t *lock = name_index_lock(addr, sb);
+    pthread_mutex_lock(lock);
+    int result = name_index_insert_locked(ctx, addr, sb, filename, inode_index);
+    pthread_mutex_unlock(lock);
+    return result;
+}
+
+/**
+ * Retire l'entrée d'un inode en sondant à partir de slot (verrou de l'index détenu)
+ */
+static void name_index_remove_locked(fs_context_t *ctx, void *addr, superblock_t *sb, uint32_t slot, uint32_t slots,
+                                     int inode_index) {
+    for (uint32_t probe = 0; probe < slots; probe++) {
+        block_t *index_block;
+        name_index_entry_t *entry = name_index_entry(addr, sb, slot, &index_block);
+
+        if (entry->inode == 0) return;  // Nom absent de l'index
+
+        if (entry->inode == (uint32_t) inode_index + 1) {
+            // Si l'entrée suivante est vide, aucune sonde ne passe par ici :
+            // on peut vider l'entrée (et les entrées supprimées qui la précèdent)
+            name_index_entry_t *next = name_index_entry(addr, sb, (slot + 1) % slots, NULL);
+            if (next->inode != 0) {
+                __atomic_store_n(&entry->inode, NAME_INDEX_TOMBSTONE, __ATOMIC_RELEASE);
+                mark_block_dirty(ctx, index_block);
+                return;
+            }
+
+            __atomic_store_n(&entry->inode, 0, __ATOMIC_RELEASE);
+            entry->hash = 0;
+            mark_block_dirty(ctx, index_block);
+
+            for (uint32_t back = 1; back < slots; back++) {
+                uint32_t prev_slot = (slot + slots - back) % slots;
+                name_index_entry_t *prev = name_index_entry(addr, sb, prev_slot, &index_block);
+                if (prev->inode != NAME_INDEX_TOMBSTONE) break;
+                __atomic_store_n(&prev->inode, 0, __ATOMIC_RELEASE);
+                prev->hash = 0;
+                mark_block_dirty(ctx, index_block);
+            }
+            return;
+        }
+
+        slot = (slot + 1) % slots;
+    }
+}
+
+void name_index_remove(fs_context_t *ctx, const char *filename, int inode_index) {
+    void *addr = ctx->fs_map;
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    uint32_t slots = name_index_slots(sb);
+    if (slots == 0) return;
+
+    uint32_t hash = name_hash(filename);
+    uint32_t slot = hash % slots;
+
+    pthread_mutex_t *lock = name_index_lock(addr, sb);
+    pthread_mutex_lock(lock);
+    name_index_remove_locked(ctx, addr, sb, slot, slots, inode_index);
+    pthread_mutex_unlock(lock);
+}
+
+int name_index_check(void *addr) {
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    if (!(sb->features & FS_FEATURE_NAME_INDEX)) return 0;
+
+    uint32_t live_entries = 0;
+    for (uint32_t slot = 0; slot < name_index_slots(sb); slot++) {
+        name_index_entry_t *entry = name_index_entry(addr, sb, slot, NULL);
+        if (entry->inode != 0 && entry->inode != NAME_INDEX_TOMBSTONE) live_entries++;
+    }
+
+    uint32_t existing = 0;
+    for (uint32_t i = 0; i < sb->max_inodes; i++) {
+        inode_t *inode = get_inode(addr, (int) i);
+        if (!(inode->flags & PERM_EXISTS)) continue;
+
+        existing++;
+        if (name_index_probe(NULL, addr, inode->filename) != (int) i) {
+            return -1;
+        }
+    }
+
+    return live_entries == existing ? 0 : -1;
+}
+
+int name_index_rebuild(fs_context_t *ctx) {
+    void *addr = ctx->fs_map;
+    superblock_t *sb = (superblock_t *) (((block_t *) addr)->data);
+    if (!(sb->features & FS_FEATURE_NAME_INDEX)) return 0;
+
+    // Vider tous les blocs de l'index
+    for (uint32_t i = 0; i < sb->name_index_blocks; i++) {
+        block_t *index_block = get_block(addr, (sb->name_index_start + i));
+        memset(index_block->data, 0, DATA_SIZE);
+        BLOCK_META(ctx, index_block)->type = BLOCK_TYPE_NAME_INDEX;
+        mark_block_dirty(ctx, index_block);
+    }
+
+    // Réinsérer chaque inode existant (fsck : seul sur le conteneur, sans prendre le verrou de
+    // l'index, qu'un processus interrompu a pu laisser pris)
+    if (name_index_slots(sb) == 0) return -1;
+    for (uint32_t i = 0; i < sb->max_inodes; i++) {
+        inode_t *inode = get_inode(addr, (int) i);
+        if (!(inode->flags & PERM_EXISTS)) continue;
+
+        if (name_index_insert_locked(ctx, addr, sb, inode->filename, (int) i) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,260 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "name_match.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+/// Recherche de sous-chaîne sans tenir compte de la casse : une position n'est candidate que
+/// si son premier et son dernier octet correspondent à ceux du motif. Les registres SIMD
+/// testent 16 ou 32 positions à la fois, le milieu du motif n'est comparé qu'aux candidates
+
+typedef const char *(*substring_fn)(const char *haystack, size_t n, const char *needle, size_t len);
+
+static inline unsigned char ascii_lower(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? (unsigned char) (c | 0x20) : c;
+}
+
+/**
+ * Compare le milieu du motif à une position candidate (premier et dernier octets déjà égaux)
+ */
+static inline int middle_matches(const char *candidate, const char *needle, size_t len) {
+    for (size_t k = 1; k + 1 < len; k++) {
+        if (ascii_lower((unsigned char) candidate[k]) != (unsigned char) needle[k]) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Positions from à n - len, une par une
+ */
+static const char *substring_scalar_from(const char *haystack, size_t n, const char *needle, size_t len,
+                                         size_t from) {
+    unsigned char first = (unsigned char) needle[0];
+    unsigned char last = (unsigned char) needle[len - 1];
+
+    for (size_t i = from; i + len <= n; i++) {
+        if (ascii_lower((unsigned char) haystack[i]) == first
+            && ascii_lower((unsigned char) haystack[i + len - 1]) == last
+            && middle_matches(haystack + i, needle, len)) {
+            return haystack + i;
+        }
+    }
+    return NULL;
+}
+
+static const char *substring_scalar(const char *haystack, size_t n, const char *needle, size_t len) {
+    return substring_scalar_from(haystack, n, needle, len, 0);
+}
+
+#if defined(__x86_64__)
+
+// Les deux chargements d'un pas lisent au plus jusqu'au zéro final (haystack[n]) : au-delà
+// de n - len, le dernier octet chargé est ce zéro et ne correspond jamais à celui du motif
+
+/**
+ * Passe en minuscules les lettres ASCII de 16 octets (les octets >= 0x80 sont négatifs : inchangés)
+ */
+static inline __m128i lower16(__m128i x) {
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(x, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(x, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+static const char *substring_sse2(const char *haystack, size_t n, const char *needle, size_t len) {
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i last = _mm_set1_epi8(needle[len - 1]);
+    size_t i = 0;
+
+    for (; i + len + 14 <= n; i += 16) {
+        __m128i head = lower16(_mm_loadu_si128((const __m128i *) (haystack + i)));
+        __m128i tail = lower16(_mm_loadu_si128((const __m128i *) (haystack + i + len - 1)));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first),
+                                                                   _mm_cmpeq_epi8(tail, last)));
+        while (mask) {
+            int bit = __builtin_ctz(mask);
+            if (middle_matches(haystack + i + bit, needle, len)) return haystack + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return substring_scalar_from(haystack, n, needle, len, i);
+}
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i lower32(__m256i x) {
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('A' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), x));
+    return _mm256_or_si256(x, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+AVX2 static const char *substring_avx2(const char *haystack, size_t n, const char *needle, size_t len) {
+    // Nom trop court pour deux pas de 32 positions : ne pas toucher aux registres 256 bits,
+    // dont le passage au code SSE2 coûterait plus que ce que le pas gagne
+    if (len + 62 > n) return substring_sse2(haystack, n, needle, len);
+
+    __m256i first = _mm256_set1_epi8(needle[0]);
+    __m256i last = _mm256_set1_epi8(needle[len - 1]);
+    size_t i = 0;
+
+    for (; i + len + 30 <= n; i += 32) {
+        __m256i head = lower32(_mm256_loadu_si256((const __m256i *) (haystack + i)));
+        __m256i tail = lower32(_mm256_loadu_si256((const __m256i *) (haystack + i + len - 1)));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first),
+                                                                         _mm256_cmpeq_epi8(tail, last)));
+        while (mask) {
+            int bit = __builtin_ctz(mask);
+            if (middle_matches(haystack + i + bit, needle, len)) return haystack + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    // Fin du nom par 16 positions à la fois, registres 256 bits remis à zéro avant le code SSE2
+    _mm256_zeroupper();
+    return substring_sse2(haystack + i, n - i, needle, len);
+}
+
+#endif
+
+/// Choix du moteur
+
+static substring_fn substring_engine = substring_scalar;
+static const char *substring_engine_label = "scalar";
+static pthread_once_t substring_engine_once = PTHREAD_ONCE_INIT;
+
+static void substring_engine_resolve(void) {
+    const char *forced = getenv("PIGNOUFS_MATCH_ENGINE");
+    if (forced && strcmp(forced, "scalar") == 0) return;
+
+#if defined(__x86_64__)
+    substring_engine = substring_sse2;  // Toujours présent en x86-64
+    substring_engine_label = "sse2";
+    if (__builtin_cpu_supports("avx2") && !(forced && strcmp(forced, "sse2") == 0)) {
+        substring_engine = substring_avx2;
+        substring_engine_label = "avx2";
+    }
+#endif
+}
+
+const char *name_match_engine_name(void) {
+    pthread_once(&substring_engine_once, substring_engine_resolve);
+    return substring_engine_label;
+}
+
+/// Motifs glob
+
+/**
+ * Compare un octet (en minuscules) à une classe [...] ; *pattern pointe après le '['
+ * @return 1 ou 0 et *pattern avancé après le ']', -1 si la classe n'est pas fermée
+ */
+static int glob_class(const char **pattern, unsigned char c) {
+    const char *p = *pattern;
+    int negate = *p == '!' || *p == '^';
+    int matched = 0;
+    if (negate) p++;
+
+    // Un ']' juste après l'ouverture fait partie de la classe
+    const char *start = p;
+    while (*p && (*p != ']' || p == start)) {
+        unsigned char low = (unsigned char) *p;
+        unsigned char high = low;
+        if (p[1] == '-' && p[2] && p[2] != ']') {
+            high = (unsigned char) p[2];
+            p += 2;
+        }
+        if (c >= low && c <= high) matched = 1;
+        p++;
+    }
+    if (*p != ']') return -1;
+
+    *pattern = p + 1;
+    return matched != negate;
+}
+
+/**
+ * Motif glob (en minuscules) contre un nom entier ; une étoile est retentée un octet plus
+ * loin à chaque échec, sans récursion
+ */
+static int glob_match(const char *pattern, const char *name) {
+    const char *star_pattern = NULL;
+    const char *star_name = NULL;
+
+    while (*name) {
+        unsigned char c = ascii_lower((unsigned char) *name);
+        int matched = 0;
+
+        if (*pattern == '*') {
+            star_pattern = ++pattern;
+            star_name = name;
+            continue;
+        }
+
+        if (*pattern == '?') {
+            pattern++;
+            matched = 1;
+        } else if (*pattern == '[') {
+            const char *after = pattern + 1;
+            int result = glob_class(&after, c);
+            if (result >= 0) {
+                pattern = after;
+                matched = result;
+            } else if (c == '[') {
+                pattern++;  // Classe non fermée : '[' ordinaire
+                matched = 1;
+            }
+        } else if (*pattern && (unsigned char) *pattern == c) {
+            pattern++;
+            matched = 1;
+        }
+
+        if (matched) {
+            name++;
+            continue;
+        }
+        if (!star_pattern) return 0;
+        pattern = star_pattern;
+        name = ++star_name;
+    }
+
+    while (*pattern == '*') pattern++;
+    return *pattern == '\0';
+}
+
+/// Motif préparé
+
+void name_matcher_init(name_matcher_t *matcher, const char *pattern, name_match_mode_t mode) {
+    pthread_once(&substring_engine_once, substring_engine_resolve);
+
+    matcher->mode = mode;
+    size_t len = 0;
+    while (pattern[len] && len < sizeof(matcher->pattern) - 1) {
+        matcher->pattern[len] = (char) ascii_lower((unsigned char) pattern[len]);
+        len++;
+    }
+    matcher->pattern[len] = '\0';
+    matcher->len = len;
+}
+
+int name_matcher_match(const name_matcher_t *matcher, const char *name) {
+    switch (matcher->mode) {
+        case NAME_MATCH_PREFIX:
+            for (size_t k = 0; k < matcher->len; k++) {
+                if (ascii_lower((unsigned char) name[k]) != (unsigned char) matcher->pattern[k]) return 0;
+            }
+            return 1;
+
+        case NAME_MATCH_GLOB:
+            return glob_match(matcher->pattern, name);
+
+        case NAME_MATCH_SUBSTRING:
+        default:
+            if (matcher->len == 0) return 1;
+            return substring_engine(name, strlen(name), matcher->pattern, matcher->len) != NULL;
+    }
+}
@@ -0,0 +1,233 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "sha1_mb.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+/// SHA1 multi-buffer : les blocs vérifiés en masse ont tous la même taille (sb->data_size),
+/// donc leurs rembourrages sont identiques et 8 messages peuvent avancer au même pas,
+/// un message par voie 32 bits d'un registre AVX2
+
+typedef void (*sha1_many_fn)(const unsigned char *const *, size_t, unsigned char (*)[SHA1_SIZE], int);
+
+static void sha1_many_scalar(const unsigned char *const *data, size_t len, unsigned char (*digests)[SHA1_SIZE],
+                             int count) {
+    for (int i = 0; i < count; i++) {
+        SHA1(data[i], len, digests[i]);
+    }
+}
+
+#if defined(__x86_64__)
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i rotl32(__m256i x, int r) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, r), _mm256_srli_epi32(x, 32 - r));
+}
+
+/**
+ * Transpose une matrice 8x8 de mots de 32 bits : la ligne i (8 mots d'un message) devient
+ * la colonne i (voie i des 8 registres)
+ */
+AVX2 static inline void transpose8(__m256i r[8]) {
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/**
+ * Charge 16 mots big-endian d'un bloc de 64 octets de chaque voie
+ */
+AVX2 static inline void load_schedule(const unsigned char *const chunk[SHA1_MB_LANES], __m256i w[16]) {
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (int half = 0; half < 2; half++) {
+        __m256i rows[8];
+        for (int lane = 0; lane < SHA1_MB_LANES; lane++) {
+            rows[lane] = _mm256_loadu_si256((const __m256i *) (chunk[lane] + half * 32));
+        }
+        transpose8(rows);
+        for (int j = 0; j < 8; j++) {
+            w[half * 8 + j] = _mm256_shuffle_epi8(rows[j], bswap);
+        }
+    }
+}
+
+#define SHA1_ROUND(f, k)                                                             \
+    do {                                                                             \
+        __m256i tmp = _mm256_add_epi32(_mm256_add_epi32(rotl32(a, 5), (f)),          \
+                                       _mm256_add_epi32(_mm256_add_epi32(e, (k)), wt)); \
+        e = d; d = c; c = rotl32(b, 30); b = a; a = tmp;                             \
+    } while (0)
+
+/**
+ * Applique la fonction de compression à un bloc de 64 octets de chaque voie
+ */
+AVX2 static void sha1_compress8(__m256i state[5], const unsigned char *const chunk[SHA1_MB_LANES]) {
+    const __m256i k0 = _mm256_set1_epi32(0x5A827999);
+    const __m256i k1 = _mm256_set1_epi32(0x6ED9EBA1);
+    const __m256i k2 = _mm256_set1_epi32(0x8F1BBCDC);
+    const __m256i k3 = _mm256_set1_epi32((int) 0xCA62C1D6);
+
+    __m256i w[16];
+    load_schedule(chunk, w);
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+    for (int t = 0; t < 80; t++) {
+        __m256i wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            wt = _mm256_xor_si256(_mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]),
+                                  _mm256_xor_si256(w[(t - 14) & 15], w[t & 15]));
+            wt = rotl32(wt, 1);
+            w[t & 15] = wt;
+        }
+
+        if (t < 20) {
+            SHA1_ROUND(_mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d))), k0);
+        } else if (t < 40) {
+            SHA1_ROUND(_mm256_xor_si256(_mm256_xor_si256(b, c), d), k1);
+        } else if (t < 60) {
+            SHA1_ROUND(_mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c))), k2);
+        } else {
+            SHA1_ROUND(_mm256_xor_si256(_mm256_xor_si256(b, c), d), k3);
+        }
+    }
+
+    state[0] = _mm256_add_epi32(state[0], a);
+    state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c);
+    state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e);
+}
+
+/**
+ * Hache 8 messages de même longueur (les voies inutilisées répètent le premier message)
+ */
+AVX2 static void sha1_x8(const unsigned char *const data[SHA1_MB_LANES], size_t len,
+                         unsigned char (*digests)[SHA1_SIZE], int count) {
+    __m256i state[5] = {
+            _mm256_set1_epi32(0x67452301), _mm256_set1_epi32((int) 0xEFCDAB89),
+            _mm256_set1_epi32((int) 0x98BADCFE), _mm256_set1_epi32(0x10325476),
+            _mm256_set1_epi32((int) 0xC3D2E1F0)
+    };
+    const unsigned char *chunk[SHA1_MB_LANES];
+
+    size_t full = len / 64;
+    for (size_t i = 0; i < full; i++) {
+        for (int lane = 0; lane < SHA1_MB_LANES; lane++) chunk[lane] = data[lane] + i * 64;
+        sha1_compress8(state, chunk);
+    }
+
+    // Dernier(s) bloc(s) : reste du message, 0x80, zéros puis longueur en bits (big-endian)
+    size_t rest = len % 64;
+    size_t tail_len = (rest + 9 <= 64) ? 64 : 128;
+    unsigned char tail[SHA1_MB_LANES][128];
+    uint64_t bits = (uint64_t) len * 8;
+
+    for (int lane = 0; lane < SHA1_MB_LANES; lane++) {
+        memset(tail[lane], 0, tail_len);
+        memcpy(tail[lane], data[lane] + full * 64, rest);
+        tail[lane][rest] = 0x80;
+        for (int i = 0; i < 8; i++) {
+            tail[lane][tail_len - 1 - i] = (unsigned char) (bits >> (8 * i));
+        }
+    }
+    for (size_t off = 0; off < tail_len; off += 64) {
+        for (int lane = 0; lane < SHA1_MB_LANES; lane++) chunk[lane] = tail[lane] + off;
+        sha1_compress8(state, chunk);
+    }
+
+    uint32_t words[5][SHA1_MB_LANES];
+    for (int i = 0; i < 5; i++) {
+        _mm256_storeu_si256((__m256i *) words[i], state[i]);
+    }
+    for (int lane = 0; lane < count; lane++) {
+        for (int i = 0; i < 5; i++) {
+            uint32_t v = words[i][lane];
+            digests[lane][4 * i] = (unsigned char) (v >> 24);
+            digests[lane][4 * i + 1] = (unsigned char) (v >> 16);
+            digests[lane][4 * i + 2] = (unsigned char) (v >> 8);
+            digests[lane][4 * i + 3] = (unsigned char) v;
+        }
+    }
+}
+
+static void sha1_many_avx2(const unsigned char *const *data, size_t len, unsigned char (*digests)[SHA1_SIZE],
+                           int count) {
+    int i = 0;
+    for (; i + SHA1_MB_LANES <= count; i += SHA1_MB_LANES) {
+        sha1_x8(data + i, len, digests + i, SHA1_MB_LANES);
+    }
+
+    // Dernier lot incomplet : peu de messages, le scalaire est plus rentable
+    int left = count - i;
+    if (left > SHA1_MB_LANES / 2) {
+        const unsigned char *lanes[SHA1_MB_LANES];
+        for (int lane = 0; lane < SHA1_MB_LANES; lane++) lanes[lane] = data[i + (lane < left ? lane : 0)];
+        sha1_x8(lanes, len, digests + i, left);
+    } else {
+        sha1_many_scalar(data + i, len, digests + i, left);
+    }
+}
+
+#endif
+
+/// Choix du moteur
+
+static sha1_many_fn sha1_engine = sha1_many_scalar;
+static const char *sha1_engine_label = "openssl";
+static pthread_once_t sha1_engine_once = PTHREAD_ONCE_INIT;
+
+static void sha1_engine_resolve(void) {
+    const char *forced = getenv("PIGNOUFS_SHA1_ENGINE");
+    if (forced && strcmp(forced, "openssl") == 0) return;
+
+#if defined(__x86_64__)
+    // Même face au SHA1 d'OpenSSL sur SHA-NI, 8 voies AVX2 restent devant sur des lots de blocs
+    if (__builtin_cpu_supports("avx2")) {
+        sha1_engine = sha1_many_avx2;
+        sha1_engine_label = "avx2";
+    }
+#endif
+}
+
+void sha1_many(const unsigned char *const *data, size_t len, unsigned char (*digests)[SHA1_SIZE], int count) {
+    pthread_once(&sha1_engine_once, sha1_engine_resolve);
+    sha1_engine(data, len, digests, count);
+}
+
+const char *sha1_engine_name(void) {
+    pthread_once(&sha1_engine_once, sha1_engine_resolve);
+    return sha1_engine_label;
+}
@@ -0,0 +1,193 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "trigram_index.h"
+#include "inode_ops.h"
+#include "block_ops.h"
+
+
+/// Index des trigrammes : une recherche de sous-chaîne ne compare au motif que les noms qui
+/// contiennent tous ses trigrammes (à une collision de seau près), trouvés par l'intersection
+/// des listes de ses seaux au lieu d'un parcours de tous les noms
+
+// Mots de 64 bits rangés dans un bloc de l'index
+#define TRIGRAM_WORDS_PER_BLOCK (DATA_SIZE / sizeof(uint64_t))
+
+static inline unsigned char trigram_lower(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? (unsigned char) (c | 0x20) : c;
+}
+
+/**
+ * Seau du trigramme qui commence en text (trois octets, casse ASCII ignorée)
+ */
+static uint32_t trigram_bucket(const char *text) {
+    uint32_t trigram = trigram_lower((unsigned char) text[0])
+                       | (uint32_t) trigram_lower((unsigned char) text[1]) << 8
+                       | (uint32_t) trigram_lower((unsigned char) text[2]) << 16;
+    return (trigram * 2654435761u) >> 16 & (TRIGRAM_BUCKETS - 1);
+}
+
+/**
+ * Mots de la liste d'un seau
+ */
+static uint32_t trigram_words(superblock_t *sb) {
+    return (sb->max_inodes + 63) / 64;
+}
+
+uint32_t trigram_index_blocks_for(uint32_t nb_inode) {
+    uint64_t words = (uint64_t) TRIGRAM_BUCKETS * ((nb_inode + 63) / 64);
+    return (uint32_t) ((words + TRIGRAM_WORDS_PER_BLOCK - 1) / TRIGRAM_WORDS_PER_BLOCK);
+}
+
+/**
+ * Mot w de la liste d'un seau
+ * @param block Reçoit le bloc contenant le mot
+ */
+static uint64_t *trigram_word(void *addr, superblock_t *sb, uint32_t bucket, uint32_t w, block_t **block) {
+    uint64_t word = (uint64_t) bucket * trigram_words(sb) + w;
+    *block = get_block(addr, sb->trigram_start + (uint32_t) (word / TRIGRAM_WORDS_PER_BLOCK));
+    return (uint64_t *) (*block)->data + word % TRIGRAM_WORDS_PER_BLOCK;
+}
+
+/**
+ * Met à 1 (set) ou à 0 le bit d'un inode dans les seaux de tous les trigrammes d'un nom
+ */
+static void trigram_index_update(fs_context_t *ctx, const char *filename, int inode_index, int set) {
+    superblock_t *sb = ctx->sb;
+    if (!(sb->features & FS_FEATURE_TRIGRAM_INDEX)) return;
+    if (inode_index < 0 || (uint32_t) inode_index >= sb->max_inodes) return;
+
+    uint64_t mask = 1ULL << (inode_index % 64);
+    size_t len = strlen(filename);
+
+    // Bits posés atomiquement : plusieurs processus créent et suppriment en même temps
+    for (size_t i = 0; i + 3 <= len; i++) {
+        block_t *block;
+        uint64_t *word = trigram_word(ctx->fs_map, sb, trigram_bucket(filename + i), (uint32_t) inode_index / 64,
+                                      &block);
+        uint64_t old = set ? __atomic_fetch_or(word, mask, __ATOMIC_ACQ_REL)
+                           : __atomic_fetch_and(word, ~mask, __ATOMIC_ACQ_REL);
+        if (((old & mask) != 0) != set) {
+            mark_block_dirty(ctx, block);
+        }
+    }
+}
+
+void trigram_index_insert(fs_context_t *ctx, const char *filename, int inode_index) {
+    trigram_index_update(ctx, filename, inode_index, 1);
+}
+
+void trigram_index_remove(fs_context_t *ctx, const char *filename, int inode_index) {
+    trigram_index_update(ctx, filename, inode_index, 0);
+}
+
+int trigram_index_check(fs_context_t *ctx) {
+    superblock_t *sb = ctx->sb;
+    if (!(sb->features & FS_FEATURE_TRIGRAM_INDEX)) return 0;
+    if (sb->trigram_blocks < trigram_index_blocks_for(sb->max_inodes)) return -1;
+
+    // Listes attendues, construites en mémoire à partir des noms, puis comparées à la zone
+    uint32_t words = trigram_words(sb);
+    uint64_t *expected = calloc((size_t) TRIGRAM_BUCKETS * words, sizeof(uint64_t));
+    if (!expected) return -1;
+
+    for (uint32_t i = 0; i < sb->max_inodes; i++) {
+        inode_t *inode = get_inode(ctx->fs_map, (int) i);
+        if (!(inode->flags & PERM_EXISTS)) continue;
+
+        size_t len = strlen(inode->filename);
+        for (size_t k = 0; k + 3 <= len; k++) {
+            expected[(size_t) trigram_bucket(inode->filename + k) * words + i / 64] |= 1ULL << (i % 64);
+        }
+    }
+
+    int result = 0;
+    for (uint32_t bucket = 0; bucket < TRIGRAM_BUCKETS && result == 0; bucket++) {
+        for (uint32_t w = 0; w < words; w++) {
+            block_t *block;
+            if (*trigram_word(ctx->fs_map, sb, bucket, w, &block) != expected[(size_t) bucket * words + w]) {
+                result = -1;
+                break;
+            }
+        }
+    }
+
+    free(expected);
+    return result;
+}
+
+int trigram_index_rebuild(fs_context_t *ctx) {
+    superblock_t *sb = ctx->sb;
+    if (!(sb->features & FS_FEATURE_TRIGRAM_INDEX)) return 0;
+    if (sb->trigram_blocks < trigram_index_blocks_for(sb->max_inodes)) return -1;
+
+    // Vider toutes les listes
+    for (uint32_t i = 0; i < sb->trigram_blocks; i++) {
+        block_t *index_block = get_block(ctx->fs_map, sb->trigram_start + i);
+        memset(index_block->data, 0, DATA_SIZE);
+        BLOCK_META(ctx, index_block)->type = BLOCK_TYPE_TRIGRAM_INDEX;
+        mark_block_dirty(ctx, index_block);
+    }
+
+    // Réinsérer chaque inode existant
+    for (uint32_t i = 0; i < sb->max_inodes; i++) {
+        inode_t *inode = get_inode(ctx->fs_map, (int) i);
+        if (inode->flags & PERM_EXISTS) {
+            trigram_index_insert(ctx, inode->filename, (int) i);
+        }
+    }
+    return 0;
+}
+
+void trigram_query_add(trigram_query_t *query, const char *literal, size_t len) {
+    for (size_t i = 0; i + 3 <= len && query->count < TRIGRAM_MAX_QUERY; i++) {
+        uint32_t bucket = trigram_bucket(literal + i);
+
+        uint32_t k = 0;
+        while (k < query->count && query->buckets[k] != bucket) k++;
+        if (k == query->count) {
+            query->buckets[query->count++] = bucket;
+        }
+    }
+}
+
+int64_t trigram_index_search(fs_context_t *ctx, const trigram_query_t *query,
+                             void (*visit)(void *arg, int inode_index), void *arg) {
+    superblock_t *sb = ctx->sb;
+    if (!(sb->features & FS_FEATURE_TRIGRAM_INDEX) || query->count == 0) return -1;
+    if (sb->trigram_blocks < trigram_index_blocks_for(sb->max_inodes)) return -1;
+
+    // Vérifier une fois les blocs des listes lues
+    uint32_t words = trigram_words(sb);
+    for (uint32_t k = 0; k < query->count; k++) {
+        uint64_t first = (uint64_t) query->buckets[k] * words;
+        uint64_t last = first + words - 1;
+        for (uint64_t b = first / TRIGRAM_WORDS_PER_BLOCK; b <= last / TRIGRAM_WORDS_PER_BLOCK; b++) {
+            if (!verify_block_checksum(ctx, get_block(ctx->fs_map, sb->trigram_start + (uint32_t) b))) {
+                fs_error("Index des trigrammes corrompu, parcours de tous les noms\n");
+                return -1;
+            }
+        }
+    }
+
+    // Intersection mot par mot : un mot nul dans une liste suffit à passer au suivant
+    int64_t candidates = 0;
+    for (uint32_t w = 0; w < words; w++) {
+        uint64_t bits = ~0ULL;
+        for (uint32_t k = 0; k < query->count && bits; k++) {
+            block_t *block;
+            bits &= *trigram_word(ctx->fs_map, sb, query->buckets[k], w, &block);
+        }
+
+        while (bits) {
+            uint32_t inode_index = w * 64 + (uint32_t) __builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (inode_index >= sb->max_inodes) break;
+
+            visit(arg, (int) inode_index);
+            candidates++;
+        }
+    }
+    return candidates;
+}
@@ -0,0 +1,146 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "verify_cache.h"
+#include <sys/types.h>
+
+
+/// Cache "déjà vérifié" : chaque recalcul de somme de contrôle incrémente la génération
+/// du bloc, donc un bloc dont la génération n'a pas bougé depuis sa dernière vérification
+/// n'a pas besoin d'être haché de nouveau
+
+#define VERIFY_SHM_MAGIC 0x50564333u  // "PVC3" (génération rangée dans lock_read, compteur d'utilisateurs)
+
+// En-tête du segment partagé, suivi du tableau verified
+typedef struct {
+    uint32_t magic;
+    uint32_t num_blocks;
+    uint32_t users;          // Caches ouverts sur le segment : le dernier à le fermer le supprime
+} verify_shm_header_t;
+
+/**
+ * Politique demandée par PIGNOUFS_VERIFY
+ * @param fallback Politique si la variable est absente
+ */
+static int verify_policy_from_env(int fallback) {
+    const char *policy = getenv("PIGNOUFS_VERIFY");
+    if (!policy) return fallback;
+    if (strcmp(policy, "always") == 0) return VERIFY_ALWAYS;
+    if (strcmp(policy, "open") == 0) return VERIFY_OPEN;
+    return VERIFY_ONCE;
+}
+
+/**
+ * Projette le segment partagé du conteneur, en le (ré)initialisant si besoin
+ * @return 0 en cas de succès, -1 si le cache doit rester local
+ */
+static int verify_cache_map_shared(verify_cache_t *cache, int fd, uint32_t fs_id) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) return -1;
+
+    char *name = cache->shm_name;
+    snprintf(name, sizeof(cache->shm_name), "/pignoufs-%08x-%lx", fs_id, (unsigned long) st.st_ino);
+
+    int shm_fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (shm_fd < 0) return -1;
+
+    size_t size = sizeof(verify_shm_header_t) + (size_t) cache->num_blocks * sizeof(uint32_t);
+    struct stat shm_st;
+    if (fstat(shm_fd, &shm_st) < 0 || ((size_t) shm_st.st_size < size && ftruncate(shm_fd, (off_t) size) < 0)) {
+        close(shm_fd);
+        return -1;
+    }
+
+    void *shm = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    close(shm_fd);
+    if (shm == MAP_FAILED) return -1;
+
+    // Segment neuf ou d'un autre conteneur : tout repasse à "jamais vérifié"
+    verify_shm_header_t *header = (verify_shm_header_t *) shm;
+    if (header->magic != VERIFY_SHM_MAGIC || header->num_blocks != cache->num_blocks) {
+        memset(shm, 0, size);
+        header->num_blocks = cache->num_blocks;
+        __atomic_store_n(&header->magic, VERIFY_SHM_MAGIC, __ATOMIC_RELEASE);
+    }
+    __atomic_add_fetch(&header->users, 1, __ATOMIC_ACQ_REL);
+
+    cache->shm = shm;
+    cache->shm_size = size;
+    cache->verified = (uint32_t *) (header + 1);
+    return 0;
+}
+
+verify_cache_t *verify_cache_open(int fd, uint32_t fs_id, uint32_t num_blocks) {
+    verify_cache_t *cache = calloc(1, sizeof(verify_cache_t));
+    if (!cache) return NULL;
+
+    cache->policy = verify_policy_from_env(VERIFY_ONCE);
+    cache->num_blocks = num_blocks;
+    if (cache->policy == VERIFY_ALWAYS) return cache;
+
+    // "open" ne vaut que pour cette ouverture : le partager n'aurait pas de sens
+    const char *where = getenv("PIGNOUFS_VERIFY_CACHE");
+    if (cache->policy == VERIFY_ONCE && where && strcmp(where, "shm") == 0
+        && verify_cache_map_shared(cache, fd, fs_id) == 0) {
+        return cache;
+    }
+
+    cache->verified = calloc(num_blocks, sizeof(uint32_t));
+    if (!cache->verified) cache->policy = VERIFY_ALWAYS;
+    return cache;
+}
+
+int verify_cache_share(verify_cache_t *cache) {
+    if (!cache || cache->shm || !cache->verified) return 0;  // Déjà partagé, ou rien à retenir
+
+    // Projection partagée de /dev/zero : mémoire anonyme commune au processus et à ses fils
+    size_t size = (size_t) cache->num_blocks * sizeof(uint32_t);
+    int zero_fd = open("/dev/zero", O_RDWR);
+    if (zero_fd < 0) return -1;
+    void *shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, zero_fd, 0);
+    close(zero_fd);
+    if (shared == MAP_FAILED) return -1;
+
+    memcpy(shared, cache->verified, size);
+    free(cache->verified);
+    cache->shm = shared;
+    cache->shm_size = size;
+    cache->verified = (uint32_t *) shared;
+    return 0;
+}
+
+void verify_cache_reload_policy(verify_cache_t *cache, int fallback) {
+    if (!cache || !cache->verified) return;  // Cache créé en "always" : aucune vérification retenue
+    cache->policy = verify_policy_from_env(fallback);
+}
+
+void verify_cache_close(verify_cache_t *cache) {
+    if (!cache) return;
+
+    if (cache->shm) {
+        // Dernier utilisateur du segment nommé : le retirer (les projections restantes restent valides)
+        if (cache->shm_name[0]
+            && __atomic_sub_fetch(&((verify_shm_header_t *) cache->shm)->users, 1, __ATOMIC_ACQ_REL) == 0) {
+            shm_unlink(cache->shm_name);
+        }
+        munmap(cache->shm, cache->shm_size);
+    } else {
+        free(cache->verified);
+    }
+    free(cache);
+}
+
+int verify_cache_hit(verify_cache_t *cache, uint32_t block_index, uint32_t generation) {
+    if (!cache || cache->policy == VERIFY_ALWAYS || block_index >= cache->num_blocks) return 0;
+
+    uint32_t seen = __atomic_load_n(&cache->verified[block_index], __ATOMIC_RELAXED);
+    if (cache->policy == VERIFY_OPEN) return seen != 0;
+    return seen == generation + 1;
+}
+
+void verify_cache_store(verify_cache_t *cache, uint32_t block_index, uint32_t generation) {
+    if (!cache || cache->policy == VERIFY_ALWAYS || block_index >= cache->num_blocks) return;
+
+    __atomic_store_n(&cache->verified[block_index], generation + 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,332 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "../../include/pfs.h"
+#include "../../include/pignoufs.h"
+#include "../../include/fs_structs.h"
+#include "../../include/fs_common.h"
+#include "../../include/block_ops.h"
+#include "../../include/inode_ops.h"
+#include <errno.h>
+
+
+/// Implémentation de libpignoufs au-dessus de inode_ops et block_ops : un seul contexte par
+/// conteneur ouvert, et pour chaque fichier ouvert sa table de blocs (blocs d'indirection gardés)
+
+struct pfs_file {
+    pfs_fs_t *fs;
+    int inode_index;          // Inode résolu à l'ouverture (plus de recherche par nom ensuite)
+    int flags;                // Mode d'ouverture (O_RDONLY, O_WRONLY, O_RDWR)
+    char name[256];           // Nom du fichier (pour détecter un inode réutilisé)
+    uint32_t generation;      // Génération de l'inode + 1 quand la table a été lue (0 : à relire)
+    uint64_t size;            // Taille du fichier lors de la lecture de la table
+    block_map_t map;          // Table des blocs, avec les blocs d'indirection déjà lus
+    pfs_file_t *next;         // Fichier ouvert suivant du même conteneur
+};
+
+struct pfs_fs {
+    fs_context_t ctx;
+    int writable;             // Conteneur ouvert en O_RDWR
+    pfs_file_t *files;        // Fichiers encore ouverts
+};
+
+/**
+ * Retire le préfixe "//" utilisé par les commandes pour désigner un fichier du conteneur
+ */
+static const char *pfs_name(const char *name) {
+    return strncmp(name, "//", 2) == 0 ? name + 2 : name;
+}
+
+/**
+ * Positionne errno et renvoie -1
+ */
+static int pfs_fail(int err) {
+    errno = err;
+    return -1;
+}
+
+pfs_fs_t *pfs_open_fs(const char *path, int flags) {
+    if ((flags & O_ACCMODE) != O_RDONLY && (flags & O_ACCMODE) != O_RDWR) {
+        pfs_fail(EINVAL);
+        return NULL;
+    }
+
+    pfs_fs_t *fs = calloc(1, sizeof(pfs_fs_t));
+    if (!fs) {
+        pfs_fail(ENOMEM);
+        return NULL;
+    }
+
+    // Rien sur la sortie d'erreur de l'appelant : chaque échec est rendu par errno
+    fs_silence_errors(1);
+
+    errno = 0;
+    if (init_fs_context_and_verify(path, &fs->ctx, flags & O_ACCMODE) < 0) {
+        int err = errno ? errno : EIO;
+        free(fs);
+        pfs_fail(err);
+        return NULL;
+    }
+    fs->writable = (flags & O_ACCMODE) == O_RDWR;
+    return fs;
+}
+
+void pfs_close_fs(pfs_fs_t *fs) {
+    if (!fs) return;
+
+    while (fs->files) {
+        pfs_close(fs->files);
+    }
+    fs_free_context(&fs->ctx);
+    free(fs);
+}
+
+/**
+ * Relit la table des blocs du fichier si son inode a changé depuis la dernière lecture
+ * (la génération du bloc d'inode avance à chaque recalcul de sa somme de contrôle)
+ * @return 0 en cas de succès, -1 en cas d'erreur (errno positionné)
+ */
+static int refresh_block_map(pfs_file_t *file) {
+    fs_context_t *ctx = &file->fs->ctx;
+
+    block_t *inode_block = get_inode_block(ctx->fs_map, file->inode_index);
+    if (!inode_block || !verify_block_checksum(ctx, inode_block)) {
+        return pfs_fail(EIO);
+    }
+
+    // Attendre qu'aucune écriture ne soit en cours, comme inode_reader_open
+    pthread_mutex_t *mutex_ptr = block_read_lock(ctx->fs_map, inode_block);
+    if (pthread_mutex_lock(mutex_ptr) != 0) {
+        return pfs_fail(EIO);
+    }
+    pthread_mutex_unlock(mutex_ptr);
+
+    inode_t *inode = get_inode(ctx->fs_map, file->inode_index);
+    if (!(inode->flags & PERM_EXISTS) || strcmp(inode->filename, file->name) != 0) {
+        return pfs_fail(ESTALE);  // Supprimé, ou inode réutilisé par un autre fichier
+    }
+
+    uint32_t generation = __atomic_load_n(BLOCK_GENERATION(BLOCK_META(ctx, inode_block)), __ATOMIC_ACQUIRE);
+    if (file->generation == generation + 1 && !is_block_dirty(ctx, inode_block)) {
+        return 0;
+    }
+
+    // Les blocs d'indirection gardés peuvent avoir été libérés : repartir de l'inode
+    block_map_init(&file->map, ctx, inode);
+    file->size = inode_size(inode);
+    file->generation = generation + 1;
+    return 0;
+}
+
+pfs_file_t *pfs_open(pfs_fs_t *fs, const char *name, int flags) {
+    fs_context_t *ctx = &fs->ctx;
+    int access = flags & O_ACCMODE;
+    name = pfs_name(name);
+
+    if (strlen(name) == 0 || strlen(name) > 255) {
+        pfs_fail(EINVAL);
+        return NULL;
+    }
+    if (access != O_RDONLY && !fs->writable) {
+        pfs_fail(EROFS);
+        return NULL;
+    }
+
+    int inode_index = find_inode_by_name(ctx, name);
+    if (inode_index < 0 && !(flags & O_CREAT)) {
+        pfs_fail(ENOENT);
+        return NULL;
+    }
+
+    if (inode_index >= 0) {
+        block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
+        if (!inode_block || !verify_block_checksum(ctx, inode_block)) {
+            pfs_fail(EIO);
+            return NULL;
+        }
+        inode_t *inode = get_inode(ctx->fs_map, inode_index);
+        if ((access != O_WRONLY && !check_permissions(inode, PERM_READ))
+            || (access != O_RDONLY && !check_permissions(inode, PERM_WRITE))) {
+            pfs_fail(EACCES);
+            return NULL;
+        }
+    }
+
+    // Création, ou remise à zéro d'un fichier existant
+    if (inode_index < 0 || ((flags & O_TRUNC) && access != O_RDONLY)) {
+        if (!fs->writable) {
+            pfs_fail(EROFS);
+            return NULL;
+        }
+        errno = 0;
+        inode_index = create_or_reset_file(ctx, name, 1);
+        if (inode_index < 0) {
+            pfs_fail(errno ? errno : EIO);
+            return NULL;
+        }
+    }
+
+    pfs_file_t *file = calloc(1, sizeof(pfs_file_t));
+    if (!file) {
+        pfs_fail(ENOMEM);
+        return NULL;
+    }
+    file->fs = fs;
+    file->inode_index = inode_index;
+    file->flags = access;
+    strcpy(file->name, name);
+
+    if (refresh_block_map(file) < 0) {
+        int err = errno;
+        free(file);
+        pfs_fail(err);
+        return NULL;
+    }
+
+    file->next = fs->files;
+    fs->files = file;
+    return file;
+}
+
+ssize_t pfs_pread(pfs_file_t *file, void *buf, size_t count, uint64_t offset) {
+    if (file->flags == O_WRONLY) {
+        return pfs_fail(EBADF);
+    }
+    if (refresh_block_map(file) < 0) {
+        return -1;
+    }
+    if (offset >= file->size || count == 0) {
+        return 0;
+    }
+    if (count > file->size - offset) {
+        count = file->size - offset;
+    }
+
+    // Contenu rangé dans l'inode, vérifié par refresh_block_map
+    if (file->map.inode->flags & PERM_INLINE) {
+        memcpy(buf, inode_inline_data(file->map.inode) + offset, count);
+        return (ssize_t) count;
+    }
+
+    fs_context_t *ctx = &file->fs->ctx;
+    uint32_t first = (uint32_t) (offset / ctx->data_size);
+    uint32_t last = (uint32_t) ((offset + count - 1) / ctx->data_size);
+    char *out = (char *) buf;
+    block_t *blocks[INODE_READER_IOV];
+
+    // Vérifier les blocs touchés par lots (hachage multi-buffer), puis copier
+    for (uint32_t batch = first; batch <= last; batch += INODE_READER_IOV) {
+        uint32_t n = last - batch + 1 < INODE_READER_IOV ? last - batch + 1 : INODE_READER_IOV;
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t *ref = block_map_slot(&file->map, batch + i, 0);
+            blocks[i] = ref && *ref ? get_block(ctx->fs_map, *ref) : NULL;
+            if (!blocks[i]) return pfs_fail(EIO);
+        }
+        if (verify_blocks_checksum(ctx, blocks, n) >= 0) {
+            return pfs_fail(EIO);
+        }
+
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t block_start = (uint64_t) (batch + i) * ctx->data_size;
+            uint32_t from = offset > block_start ? (uint32_t) (offset - block_start) : 0;
+            uint32_t to = offset + count < block_start + ctx->data_size ? (uint32_t) (offset + count - block_start)
+                                                                       : ctx->data_size;
+            memcpy(out, blocks[i]->data + from, to - from);
+            out += to - from;
+        }
+    }
+    return (ssize_t) count;
+}
+
+ssize_t pfs_pwrite(pfs_file_t *file, const void *buf, size_t count, uint64_t offset) {
+    fs_context_t *ctx = &file->fs->ctx;
+
+    if (file->flags == O_RDONLY) {
+        return pfs_fail(EBADF);
+    }
+    if (count > UINT32_MAX) {
+        count = UINT32_MAX;  // Écriture partielle, comme pwrite
+    }
+    if (offset > inode_max_size(ctx) || count > inode_max_size(ctx) - offset) {
+        return pfs_fail(EFBIG);
+    }
+    if (refresh_block_map(file) < 0) {
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // Seuls les blocs couvrant la plage sont modifiés ; au-delà de la fin, le fichier grandit
+    uint64_t end = offset + count;
+    if (reserve_blocks(ctx, blocks_to_allocate(ctx, file->size, end)) < 0) {
+        release_reserved_blocks(ctx);
+        return pfs_fail(ENOSPC);
+    }
+    int result = write_inode_at(ctx, file->inode_index, buf, (uint32_t) count, offset);
+
+    // Rendre les blocs réservés inutilisés et oublier le résumé de la bitmap
+    // (d'autres processus peuvent allouer d'ici la prochaine écriture)
+    free_alloc_state(ctx);
+    file->generation = 0;
+
+    return result < 0 ? pfs_fail(EIO) : (ssize_t) count;
+}
+
+int pfs_close(pfs_file_t *file) {
+    if (!file) return pfs_fail(EBADF);
+
+    // Retirer le fichier de la liste du conteneur
+    for (pfs_file_t **link = &file->fs->files; *link; link = &(*link)->next) {
+        if (*link == file) {
+            *link = file->next;
+            break;
+        }
+    }
+    free(file);
+    return 0;
+}
+
+/**
+ * Remplit les informations d'un inode existant
+ * @return 1 si l'inode existe, 0 s'il est libre, -1 s'il est corrompu
+ */
+static int fill_stat(fs_context_t *ctx, int inode_index, pfs_stat_t *st) {
+    block_t *inode_block = get_inode_block(ctx->fs_map, inode_index);
+    if (!inode_block || !verify_block_checksum(ctx, inode_block)) {
+        return pfs_fail(EIO);
+    }
+
+    inode_t *inode = get_inode(ctx->fs_map, inode_index);
+    if (!(inode->flags & PERM_EXISTS)) {
+        return 0;
+    }
+
+    st->inode = (uint32_t) inode_index;
+    st->size = inode_size(inode);
+    st->flags = inode->flags;
+    st->mode = inode->mode;
+    memcpy(st->name, inode->filename, sizeof(st->name));
+    st->name[sizeof(st->name) - 1] = '\0';
+    return 1;
+}
+
+int pfs_stat(pfs_fs_t *fs, const char *name, pfs_stat_t *st) {
+    int inode_index = find_inode_by_name(&fs->ctx, pfs_name(name));
+    if (inode_index < 0) {
+        return pfs_fail(ENOENT);
+    }
+
+    int found = fill_stat(&fs->ctx, inode_index, st);
+    if (found < 0) return -1;
+    return found ? 0 : pfs_fail(ENOENT);
+}
+
+int pfs_readdir(pfs_fs_t *fs, uint32_t *cursor, pfs_stat_t *st) {
+    while (*cursor < fs->ctx.sb->max_inodes) {
+        int found = fill_stat(&fs->ctx, (int) (*cursor)++, st);
+        if (found != 0) return found;
+    }
+    return 0;
+}
@@ -5,6 +5,9 @@
 #include "../include/pignoufs.h"
 #include "../include/commands.h"
 #include "../include/fs_common.h"
+#include "../include/daemon.h"
+#include "../include/name_match.h"
+#include <errno.h>
 
 // Structure représentant une commande
 typedef struct {
@@ -20,9 +23,42 @@ typedef struct {
 
 int wrapper_mkfs(const char *fsname, int argc, char **argv) {
     if (argc < 2) {
-        return fs_error("Usage: mkfs <fsname> <nombre inode> <nombre blocks>");
+        return fs_error("Usage: mkfs <fsname> <nombre inode> <nombre blocks> [sha1|crc32c|xxh64] [v1|v2|<taille de bloc>] [packed] [trigram]");
     }
-    return cmd_mkfs(fsname, atoi(argv[0]), atoi(argv[1]));
+
+    // Options dans n'importe quel ordre : algorithme de somme de contrôle, format ou taille de
+    // bloc du format v2 (en octets, ou en Kio avec le suffixe k : 4k à 64k), table des inodes compacte,
+    // index des trigrammes
+    const char *checksum_name = NULL;
+    uint32_t block_size = BLOCK_SIZE;
+    int packed_inodes = 0;
+    int trigram_index = 0;
+    for (int i = 2; i < argc; i++) {
+        char *end;
+        unsigned long size = strtoul(argv[i], &end, 10);
+        if (strcmp(argv[i], "packed") == 0) {
+            packed_inodes = 1;
+        } else if (strcmp(argv[i], "trigram") == 0) {
+            trigram_index = 1;
+        } else if (strcmp(argv[i], "v1") == 0) {
+            block_size = BLOCK_SIZE;
+        } else if (strcmp(argv[i], "v2") == 0) {
+            block_size = PAGE_BLOCK_SIZE;
+        } else if (end != argv[i] && (*end == '\0' || ((*end == 'k' || *end == 'K') && end[1] == '\0'))) {
+            block_size = (uint32_t) (*end ? size * 1024 : size);
+        } else {
+            checksum_name = argv[i];
+        }
+    }
+    // Nombres d'inodes et de blocs sur 32 bits (au-delà de INT_MAX pour les gros conteneurs)
+    char *end_inodes, *end_blocks;
+    unsigned long nb_inode = strtoul(argv[0], &end_inodes, 10);
+    unsigned long nb_block = strtoul(argv[1], &end_blocks, 10);
+    if (*end_inodes != '\0' || *end_blocks != '\0' || nb_inode > UINT32_MAX || nb_block > UINT32_MAX) {
+        return fs_error("Nombre d'inodes ou de blocs invalide");
+    }
+    return cmd_mkfs(fsname, (uint32_t) nb_inode, (uint32_t) nb_block, checksum_name, block_size, packed_inodes,
+                    trigram_index);
 }
 
 int wrapper_df(const char *fsname, int argc, char **argv) {
@@ -62,12 +98,45 @@ int wrapper_chmod(const char *fsname, int argc, char **argv) {
     return cmd_chmod(fsname, argv[0], argv[1]);
 }
 
+/**
+ * Lit un entier positif sur 64 bits (position ou longueur dans un fichier)
+ * @return 0 en cas de succès, -1 si la chaîne n'est pas un nombre valide
+ */
+static int parse_u64(const char *str, uint64_t *value) {
+    char *end;
+    errno = 0;
+    unsigned long long parsed = strtoull(str, &end, 10);
+    if (errno || end == str || *end != '\0' || str[0] == '-') {
+        return -1;
+    }
+    *value = (uint64_t) parsed;
+    return 0;
+}
+
 int wrapper_cat(const char *fsname, int argc, char **argv) {
     if (argc < 1) {
-        fs_error("Usage: cat <fsname> <fichier>\n");
+        fs_error("Usage: cat <fsname> <fichier> [--offset N] [--length N]\n");
         return EXIT_FAILURE;
     }
-    return cmd_cat(fsname, argv[0]);
+
+    uint64_t offset = 0, length = UINT64_MAX;
+    for (int i = 1; i < argc; i++) {
+        uint64_t *target = strcmp(argv[i], "--offset") == 0 ? &offset
+                         : strcmp(argv[i], "--length") == 0 ? &length : NULL;
+        if (!target || i + 1 >= argc || parse_u64(argv[i + 1], target) < 0) {
+            return fs_error("Usage: cat <fsname> <fichier> [--offset N] [--length N]");
+        }
+        i++;
+    }
+    return cmd_cat(fsname, argv[0], offset, length);
+}
+
+int wrapper_write_at(const char *fsname, int argc, char **argv) {
+    uint64_t offset;
+    if (argc < 2 || parse_u64(argv[1], &offset) < 0) {
+        return fs_error("Usage: write-at <fsname> <fichier> <position> [données]");
+    }
+    return cmd_write_at(fsname, argv[0], offset, argc > 2 ? argv[2] : NULL);
 }
 
 int wrapper_input(const char *fsname, int argc, char **argv) {
@@ -95,11 +164,16 @@ int wrapper_addinput(const char *fsname, int argc, char **argv) {
 }
 
 int wrapper_find(const char *fsname, int argc, char **argv) {
-    if (argc < 1) {
-        fs_error("Usage: find <fsname> <fichier>\n");
+    int mode = NAME_MATCH_SUBSTRING;
+    if (argc == 2 && strcmp(argv[1], "--prefix") == 0) {
+        mode = NAME_MATCH_PREFIX;
+    } else if (argc == 2 && strcmp(argv[1], "--glob") == 0) {
+        mode = NAME_MATCH_GLOB;
+    } else if (argc != 1) {
+        fs_error("Usage: find <fsname> <motif> [--prefix|--glob]\n");
         return EXIT_FAILURE;
     }
-    return cmd_find(fsname, argv[0]);
+    return cmd_find(fsname, argv[0], mode);
 }
 
 int wrapper_mkdir(const char *fsname, int argc, char **argv) {
@@ -130,27 +204,57 @@ int wrapper_mount(const char *fsname, int argc, char **argv) {
     return cmd_mount(fsname);
 }
 
+int run_command(const char *fsname, const char *command_name, int argc, char **argv);
+
+int wrapper_serve(const char *fsname, int argc, char **argv) {
+    // serve <fsname> stop : arrêter le démon qui sert ce conteneur
+    if (argc > 0 && strcmp(argv[0], "stop") == 0) {
+        int status;
+        if (daemon_forward(fsname, DAEMON_OP_STOP, "serve", 0, NULL, &status) < 0) {
+            return fs_error("Aucun démon ne sert '%s'", fsname);
+        }
+        return status;
+    }
+    return daemon_serve(fsname, run_command);
+}
+
+int wrapper_batch(const char *fsname, int argc, char **argv) {
+    UNUSED(argc);
+    UNUSED(argv);
+    return cmd_batch(fsname, run_command);
+}
+
 // Table des commandes supportées
 static const Command commands[] = {
-        {"mkfs",     wrapper_mkfs,     2, "mkfs <fsname> <nombre inode> <nombre blocks>", "Créer un système de fichiers"},
+        {"mkfs",     wrapper_mkfs,     2, "mkfs <fsname> <nombre inode> <nombre blocks> [checksum] [v1|v2|taille] [packed] [trigram]", "Créer un système de fichiers (checksum : sha1, crc32c, xxh64 ; v2 : blocs d'une page ou plus, de 4k à 64k, en-tête compris ; packed : plusieurs inodes par bloc ; trigram : index des trigrammes pour find)"},
         {"ls",       cmd_ls,           0, "ls <fsname>",                                  "Lister les fichiers du système"},
         {"df",       wrapper_df,       0, "df <fsname>",                                  "Afficher l'espace libre"},
         {"cp",       wrapper_cp,       2, "cp <fsname> <source> <destination>",           "Copier un fichier"},
         {"rm",       wrapper_rm,       1, "rm <fsname> <fichier>",                        "Supprimer un fichier"},
         {"lock",     wrapper_lock,     2, "lock <fsname> <fichier> <mode>",               "Verrouiller un fichier (mode: read/write)"},
         {"chmod",    wrapper_chmod,    2, "chmod <fsname> <fichier> <mode>",              "Modifier les droits d'accès"},
-        {"cat",      wrapper_cat,      1, "cat <fsname> <fichier>",                       "Afficher le contenu d'un fichier"},
+        {"cat",      wrapper_cat,      1, "cat <fsname> <fichier> [--offset N] [--length N]", "Afficher le contenu d'un fichier (ou une plage)"},
+        {"write-at", wrapper_write_at, 2, "write-at <fsname> <fichier> <position> [données]", "Écrire à une position (données ou entrée standard)"},
         {"input",    wrapper_input,    1, "input <fsname> <fichier>",                     "Écrire l'entrée standard dans un fichier"},
         {"add",      wrapper_add,      2, "add <fsname> <source> <destination>",          "Ajouter un fichier à un autre"},
         {"addinput", wrapper_addinput, 1, "addinput <fsname> <fichier>",                  "Ajouter l'entrée standard à un fichier existant"},
-        {"find",     wrapper_find,     1, "find <fsname> <fichier>",                      "Rechercher un fichier"},
+        {"find",     wrapper_find,     1, "find <fsname> <motif> [--prefix|--glob]",      "Rechercher des fichiers par nom (sous-chaîne, préfixe ou motif glob)"},
         {"mkdir",    wrapper_mkdir,    1, "mkdir <fsname> <dossier>",                     "Créer un dossier"},
         {"rmdir",    wrapper_rmdir,    1, "rmdir <fsname> <dossier>",                     "Supprimer un dossier"},
         {"fsck",     wrapper_fsck,     0, "fsck <fsname>",                                "Vérifier l'intégrité du système de fichiers"},
         {"mount",    wrapper_mount,    0, "mount <fsname>",                               "Initialiser la structure de verrouillage"},
+        {"serve",    wrapper_serve,    0, "serve <fsname> [stop]",                        "Servir le conteneur aux autres commandes (socket <fsname>.sock)"},
+        {"batch",    wrapper_batch,    0, "batch <fsname> < script",                      "Exécuter un script de commandes sur un seul contexte"},
         {NULL, NULL,                   0, NULL, NULL} // Fin de la table
 };
 
+// Commandes toujours exécutées localement, même si un démon sert le conteneur
+// (mkfs recrée le fichier, lock attend un signal, serve et batch gardent leur propre contexte)
+static const char *local_commands[] = {"mkfs", "lock", "serve", "batch", NULL};
+
+// Nom du programme pour les messages d'usage
+static const char *prog_name = "pignoufs";
+
 /**
  * Affiche l'aide avec toutes les commandes disponibles
  */
@@ -171,7 +275,45 @@ void print_command_usage(const char *prog_name, const Command *cmd) {
     fs_error("Description: %s\n", cmd->description);
 }
 
+/**
+ * Exécute une commande de la table (ligne de commande ou requête reçue par le démon)
+ * @param fsname Nom du système de fichiers
+ * @param command_name Nom de la commande
+ * @param argc Nombre d'arguments de la commande
+ * @param argv Arguments de la commande
+ * @return Code de retour de la commande
+ */
+int run_command(const char *fsname, const char *command_name, int argc, char **argv) {
+    // Recherche de la commande dans la table
+    const Command *selected_command = NULL;
+    for (const Command *cmd = commands; cmd->name != NULL; cmd++) {
+        if (strcmp(command_name, cmd->name) == 0) {
+            selected_command = cmd;
+            break;
+        }
+    }
+
+    // Vérification si la commande existe
+    if (selected_command == NULL) {
+        fs_error("Erreur: commande inconnue: '%s'", command_name);
+        print_usage(prog_name);
+        return EXIT_FAILURE;
+    }
+
+    // Vérification du nombre minimum d'arguments
+    if (argc < selected_command->min_args) {
+        fs_error("Erreur: arguments insuffisants pour la commande '%s'", command_name);
+        print_command_usage(prog_name, selected_command);
+        return EXIT_FAILURE;
+    }
+
+    // Exécution de la commande
+    return selected_command->func(fsname, argc, argv);
+}
+
 int main(int argc, char *argv[]) {
+    prog_name = argv[0];
+
     // Vérification des arguments minimum
     if (argc < 2) {
         print_usage(argv[0]);
@@ -195,29 +337,15 @@ int main(int argc, char *argv[]) {
 
     const char *fsname = argv[2];
 
-    // Recherche de la commande dans la table
-    const Command *selected_command = NULL;
-    for (const Command *cmd = commands; cmd->name != NULL; cmd++) {
-        if (strcmp(command_name, cmd->name) == 0) {
-            selected_command = cmd;
-            break;
-        }
-    }
-
-    // Vérification si la commande existe
-    if (selected_command == NULL) {
-        fs_error("Erreur: commande inconnue: '%s'", command_name);
-        print_usage(argv[0]);
-        return EXIT_FAILURE;
+    // Si un démon sert ce conteneur, lui confier la commande (PIGNOUFS_NO_DAEMON pour l'éviter)
+    int local = getenv("PIGNOUFS_NO_DAEMON") != NULL;
+    for (const char **name = local_commands; *name && !local; name++) {
+        local = strcmp(command_name, *name) == 0;
     }
-
-    // Vérification du nombre minimum d'arguments
-    if (argc - 3 < selected_command->min_args) {
-        fs_error("Erreur: arguments insuffisants pour la commande '%s'", command_name);
-        print_command_usage(argv[0], selected_command);
-        return EXIT_FAILURE;
+    int status;
+    if (!local && daemon_forward(fsname, DAEMON_OP_RUN, command_name, argc - 3, &argv[3], &status) == 0) {
+        return status;
     }
 
-    // Exécution de la commande
-    return selected_command->func(fsname, argc - 3, &argv[3]);
-}
\ No newline at end of file
+    return run_command(fsname, command_name, argc - 3, &argv[3]);
+}
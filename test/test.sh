@@ -47,9 +47,83 @@ timeout 2 ./../bin/pignoufs lock $FS //test1.txt w || echo "timeout attendu (ver
 echo "Test rm"
 ./../bin/pignoufs rm $FS //test1.txt || echo "Erreur lors du rm"
 
+echo "Test résumé des inodes (ls -l après modification)"
+./../bin/pignoufs write-at $FS //test2.txt 40 "fin" > /dev/null
+./../bin/pignoufs ls $FS -l | grep -q "^test2.txt *Taille: 43 " && echo "résumé OK"
+
 echo "Test fsck"
 ./../bin/pignoufs fsck $FS
 
+echo "Test fichier à double indirection (au-delà de 10 + 1000 blocs)"
+head -c 6000000 /dev/urandom > big_src
+./../bin/pignoufs mkfs grosfs.img 4 1600 > /dev/null
+./../bin/pignoufs cp grosfs.img big_src //gros > /dev/null
+./../bin/pignoufs cat grosfs.img //gros | cmp - big_src && echo "double indirection OK"
+./../bin/pignoufs fsck grosfs.img
+rm -f grosfs.img big_src
+
+echo "Test table des inodes compacte"
+./../bin/pignoufs mkfs packedfs.img 40 100 packed > /dev/null
+for i in 1 2 3 4 5 6 7 8 9; do ./../bin/pignoufs cp packedfs.img $SRC //p$i > /dev/null; done
+./../bin/pignoufs rm packedfs.img //p4 > /dev/null
+./../bin/pignoufs cat packedfs.img //p9 | diff - $SRC && echo "table compacte OK"
+./../bin/pignoufs fsck packedfs.img
+echo "Test find (sous-chaîne, préfixe, glob)"
+./../bin/pignoufs find packedfs.img P9 | grep -q "^Trouvé: p9 "
+./../bin/pignoufs find packedfs.img p --prefix | grep -q "Total: 8 fichier"
+./../bin/pignoufs find packedfs.img 'p[1-3]' --glob | grep -q "Total: 3 fichier" && echo "find OK"
+rm -f packedfs.img
+
+echo "Test index des trigrammes"
+./../bin/pignoufs mkfs trifs.img 40 100 trigram > /dev/null
+for name in rapport_mars rapport_avril notes_avril; do ./../bin/pignoufs cp trifs.img $SRC //$name > /dev/null; done
+./../bin/pignoufs rm trifs.img //rapport_mars > /dev/null
+./../bin/pignoufs find trifs.img AVRIL | grep -q "Total: 2 fichier"
+./../bin/pignoufs find trifs.img mars | grep -q "^Aucun fichier"
+./../bin/pignoufs find trifs.img '*port*' --glob | grep -q "^Trouvé: rapport_avril " && echo "trigrammes OK"
+./../bin/pignoufs fsck trifs.img
+rm -f trifs.img
+
+echo "Test démon (serve)"
+./../bin/pignoufs mkfs servefs.img 10 50 > /dev/null
+./../bin/pignoufs serve servefs.img > /dev/null &
+for i in $(seq 1 50); do [ -S servefs.img.sock ] && break; sleep 0.1; done
+./../bin/pignoufs cp servefs.img $SRC //servi > /dev/null
+./../bin/pignoufs cat servefs.img //servi | diff - $SRC
+# Un octet corrompu sur disque après une première lecture doit être détecté par le démon
+offset=$(grep -obUa "Ceci est un test" servefs.img | head -1 | cut -d: -f1)
+printf 'X' | dd of=servefs.img bs=1 seek=$offset conv=notrunc 2> /dev/null
+if ! ./../bin/pignoufs cat servefs.img //servi > /dev/null 2>&1; then echo "démon OK"; fi
+./../bin/pignoufs serve servefs.img stop > /dev/null
+wait
+rm -f servefs.img
+
+echo "Test bibliothèque (libpignoufs)"
+make -s -C .. tests
+./../bin/pignoufs mkfs libfs.img 10 50 > /dev/null
+./../bin/test_pfs libfs.img absent.img 2> lib_err.txt
+[ ! -s lib_err.txt ] || { echo "Messages sur stderr :"; cat lib_err.txt; exit 1; }
+./../bin/pignoufs fsck libfs.img
+rm -f libfs.img lib_err.txt
+
+# Conteneur de plusieurs Gio (créé creux par ftruncate) : adresses de blocs au-delà de 2 et 4 Gio
+# Long et gourmand en disque : seulement avec BIG_TESTS=1
+if [ "${BIG_TESTS:-0}" = "1" ]; then
+    echo "Test gros conteneur (64k x 70000 blocs)"
+    BIG=bigfs.img
+    head -c 1000M /dev/urandom > big_src
+    ./../bin/pignoufs mkfs $BIG 16 70000 xxh64 64k > /dev/null
+    for i in 1 2 3 4; do ./../bin/pignoufs cp $BIG big_src //big$i; done
+    ./../bin/pignoufs cat $BIG //big4 | cmp - big_src && echo "gros conteneur OK"
+    # Source de plus de 2 Gio (un seul read n'en rend que 2) : copiée par morceaux
+    for i in 1 2 3; do ./../bin/pignoufs rm $BIG //big$i > /dev/null; done
+    head -c 2200M /dev/urandom > big_src
+    ./../bin/pignoufs cp $BIG big_src //huge > /dev/null
+    ./../bin/pignoufs cat $BIG //huge | cmp - big_src && echo "source de plus de 2 Gio OK"
+    ./../bin/pignoufs fsck $BIG
+    rm -f $BIG big_src
+fi
+
 echo "Tous les tests sont terminés."
 rm -f $FS $SRC $OUT append.txt base.txt
 
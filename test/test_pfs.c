@@ -0,0 +1,91 @@
+//
+// Created by Samuel on 17/10/2026.
+//
+
+#include "../include/pfs.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/// Test de libpignoufs : ouverture, écriture, lecture, stat, parcours et O_TRUNC sur un
+/// conteneur vide créé par test.sh. Aucun message ne doit sortir sur stderr
+
+static int failures = 0;
+
+/**
+ * Note un échec sur stdout (stderr est réservé aux messages de la bibliothèque)
+ */
+static void check(int condition, const char *what) {
+    if (!condition) {
+        printf("Échec : %s (errno %d)\n", what, errno);
+        failures++;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        printf("Usage : %s <conteneur> <conteneur absent>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Conteneur absent : errno de l'ouverture, pas une erreur générique
+    errno = 0;
+    check(!pfs_open_fs(argv[2], O_RDWR) && errno == ENOENT, "conteneur absent -> ENOENT");
+
+    pfs_fs_t *fs = pfs_open_fs(argv[1], O_RDWR);
+    if (!fs) {
+        printf("Échec : ouverture du conteneur (errno %d)\n", errno);
+        return EXIT_FAILURE;
+    }
+
+    errno = 0;
+    check(!pfs_open(fs, "//absent", O_RDONLY) && errno == ENOENT, "fichier absent -> ENOENT");
+
+    // Écriture au début puis après un trou (rempli de zéros), sur plusieurs blocs
+    pfs_file_t *file = pfs_open(fs, "//lib.txt", O_RDWR | O_CREAT);
+    check(file != NULL, "création de lib.txt");
+    if (!file) {
+        pfs_close_fs(fs);
+        return EXIT_FAILURE;
+    }
+    check(pfs_pwrite(file, "bonjour", 7, 0) == 7, "pwrite au début");
+    check(pfs_pwrite(file, "fin", 3, 10000) == 3, "pwrite après un trou");
+
+    char buf[16];
+    memset(buf, 'x', sizeof(buf));
+    check(pfs_pread(file, buf, 7, 0) == 7 && memcmp(buf, "bonjour", 7) == 0, "pread du début");
+    check(pfs_pread(file, buf, 4, 9999) == 4 && memcmp(buf, "\0fin", 4) == 0, "pread autour du trou");
+    check(pfs_pread(file, buf, sizeof(buf), 10003) == 0, "pread après la fin");
+    pfs_close(file);
+
+    pfs_stat_t st;
+    check(pfs_stat(fs, "//lib.txt", &st) == 0 && st.size == 10003, "stat après écriture");
+
+    // Parcours : lib.txt est le seul fichier
+    uint32_t cursor = 0;
+    int seen = 0;
+    while (pfs_readdir(fs, &cursor, &st) == 1) {
+        check(strcmp(st.name, "lib.txt") == 0, "nom rendu par readdir");
+        seen++;
+    }
+    check(seen == 1, "readdir rend un fichier");
+
+    // O_TRUNC : fichier vidé, puis réécrit
+    file = pfs_open(fs, "//lib.txt", O_WRONLY | O_TRUNC);
+    check(file != NULL, "ouverture avec O_TRUNC");
+    check(pfs_stat(fs, "//lib.txt", &st) == 0 && st.size == 0, "taille nulle après O_TRUNC");
+    if (file) {
+        errno = 0;
+        check(pfs_pread(file, buf, 1, 0) < 0 && errno == EBADF, "pread en O_WRONLY -> EBADF");
+        check(pfs_pwrite(file, "neuf", 4, 0) == 4, "pwrite après O_TRUNC");
+        pfs_close(file);
+    }
+    check(pfs_stat(fs, "//lib.txt", &st) == 0 && st.size == 4, "stat après réécriture");
+
+    pfs_close_fs(fs);
+
+    if (failures == 0) printf("bibliothèque OK\n");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}